@@ -16,6 +16,7 @@
 #define RAPIDJSON_ALLOCATORS_H_
 
 #include "rapidjson.h"
+#include "internal/swap.h"
 
 RAPIDJSON_NAMESPACE_BEGIN
 
@@ -52,19 +53,57 @@ concept Allocator {
 \endcode
 */
 
+///////////////////////////////////////////////////////////////////////////////
+// RAPIDJSON_ALLOCATOR_STATS
+
+//! Enable memory usage counters in CrtAllocator and MemoryPoolAllocator.
+/*!
+    \ingroup RAPIDJSON_CONFIG
+
+    When defined to 1, both allocators keep an \ref AllocatorStats record
+    which can be queried with \c GetStats(). When defined to 0 (default),
+    the counters and all the bookkeeping code are compiled out.
+*/
+#ifndef RAPIDJSON_ALLOCATOR_STATS
+#define RAPIDJSON_ALLOCATOR_STATS 0
+#endif
+
+#if RAPIDJSON_ALLOCATOR_STATS
+//! Memory usage counters of an allocator.
+/*! \see RAPIDJSON_ALLOCATOR_STATS
+*/
+struct AllocatorStats {
+    AllocatorStats() : requested(0), reserved(0), chunkCount(0), peak(0), abandoned(0) {}
+
+    size_t requested;   //!< Bytes requested by users through Malloc() and Realloc().
+    size_t reserved;    //!< Bytes obtained from the underlying allocator.
+    size_t chunkCount;  //!< Number of blocks (CrtAllocator) or chunks (MemoryPoolAllocator) obtained.
+    size_t peak;        //!< Highest value of \c reserved ever observed.
+    size_t abandoned;   //!< Bytes left behind by Realloc() when a block had to be moved; always 0 for CrtAllocator, whose realloc() releases the old block.
+};
+#endif // RAPIDJSON_ALLOCATOR_STATS
+
 ///////////////////////////////////////////////////////////////////////////////
 // CrtAllocator
 
 //! C-runtime library allocator.
 /*! This class is just wrapper for standard C library memory routines.
     \note implements Allocator concept
+    \note With \ref RAPIDJSON_ALLOCATOR_STATS, Free() is static and does not
+        know the block size, so \c reserved and \c peak are cumulative.
 */
 class CrtAllocator {
 public:
     static const bool kNeedFree = true;
     void* Malloc(size_t size) { 
-        if (size) //  behavior of malloc(0) is implementation defined.
+        if (size) { //  behavior of malloc(0) is implementation defined.
+#if RAPIDJSON_ALLOCATOR_STATS
+            stats_.requested += size;
+            stats_.chunkCount++;
+            AddReserved(size);
+#endif
             return std::malloc(size);
+        }
         else
             return NULL; // standardize to returning NULL.
     }
@@ -74,11 +113,46 @@ public:
             std::free(originalPtr);
             return NULL;
         }
+#if RAPIDJSON_ALLOCATOR_STATS
+        if (originalPtr == 0)
+            stats_.chunkCount++;
+        if (newSize > originalSize) {
+            stats_.requested += newSize - originalSize;
+            AddReserved(newSize - originalSize);
+        }
+#endif
         return std::realloc(originalPtr, newSize);
     }
     static void Free(void *ptr) { std::free(ptr); }
+
+#if RAPIDJSON_ALLOCATOR_STATS
+    //! Memory usage counters of this allocator.
+    const AllocatorStats& GetStats() const { return stats_; }
+
+private:
+    void AddReserved(size_t size) {
+        stats_.reserved += size;
+        if (stats_.reserved > stats_.peak)
+            stats_.peak = stats_.reserved;
+    }
+
+    AllocatorStats stats_;
+#endif
+};
+
+namespace internal {
+
+//! Default chunk capacity of MemoryPoolAllocator for a given base allocator.
+/*! Base allocators which work best with a specific chunk size (e.g. \ref HugePageAllocator)
+    specialize this template.
+*/
+template <typename BaseAllocator>
+struct DefaultChunkCapacity {
+    static const size_t kValue = 64 * 1024;
 };
 
+} // namespace internal
+
 ///////////////////////////////////////////////////////////////////////////////
 // MemoryPoolAllocator
 
@@ -142,6 +216,8 @@ public:
     }
 
     //! Deallocates all memory chunks, excluding the user-supplied buffer.
+    /*! With \ref RAPIDJSON_ALLOCATOR_STATS all counters except \c peak are reset.
+    */
     void Clear() {
         while (chunkHead_ && chunkHead_ != userBuffer_) {
             ChunkHeader* next = chunkHead_->next;
@@ -150,6 +226,11 @@ public:
         }
         if (chunkHead_ && chunkHead_ == userBuffer_)
             chunkHead_->size = 0; // Clear user buffer
+#if RAPIDJSON_ALLOCATOR_STATS
+        size_t peak = stats_.peak;
+        stats_ = AllocatorStats();
+        stats_.peak = peak;
+#endif
     }
 
     //! Computes the total capacity of allocated memory chunks.
@@ -172,11 +253,55 @@ public:
         return size;
     }
 
+#if RAPIDJSON_ALLOCATOR_STATS
+    //! Memory usage counters of this allocator.
+    /*! \c reserved and \c chunkCount only cover chunks obtained from the base allocator, not the user buffer.
+    */
+    const AllocatorStats& GetStats() const { return stats_; }
+#endif
+
+    //! Makes sure the next \c size bytes can be allocated without adding a chunk.
+    /*! If the current chunk is too small, a chunk of exactly \c size bytes is added,
+        regardless of the chunk capacity given at construction.
+        \param size Total size in bytes of the upcoming allocations (each one aligned with \ref RAPIDJSON_ALIGN).
+        \return true if success.
+    */
+    bool Reserve(size_t size) {
+        if (!size)
+            return true;
+
+        size = RAPIDJSON_ALIGN(size);
+        if (chunkHead_ != 0 && chunkHead_->size + size <= chunkHead_->capacity)
+            return true;
+        return AddChunk(size);
+    }
+
+    //! Exchanges the memory chunks with another pool.
+    /*! The user buffer and the base allocators travel with the chunks they belong to,
+        so each pool still frees its chunks through the allocator that made them.
+        The chunk capacity given at construction stays with each pool.
+        \param rhs The pool to exchange chunks with.
+        \return Reference to this pool.
+    */
+    MemoryPoolAllocator& Swap(MemoryPoolAllocator& rhs) RAPIDJSON_NOEXCEPT {
+        internal::Swap(chunkHead_, rhs.chunkHead_);
+        internal::Swap(userBuffer_, rhs.userBuffer_);
+        internal::Swap(baseAllocator_, rhs.baseAllocator_);
+        internal::Swap(ownBaseAllocator_, rhs.ownBaseAllocator_);
+#if RAPIDJSON_ALLOCATOR_STATS
+        internal::Swap(stats_, rhs.stats_);
+#endif
+        return *this;
+    }
+
     //! Allocates a memory block. (concept Allocator)
     void* Malloc(size_t size) {
         if (!size)
             return NULL;
 
+#if RAPIDJSON_ALLOCATOR_STATS
+        stats_.requested += size;
+#endif
         size = RAPIDJSON_ALIGN(size);
         if (chunkHead_ == 0 || chunkHead_->size + size > chunkHead_->capacity)
             if (!AddChunk(chunk_capacity_ > size ? chunk_capacity_ : size))
@@ -207,6 +332,9 @@ public:
             size_t increment = static_cast<size_t>(newSize - originalSize);
             if (chunkHead_->size + increment <= chunkHead_->capacity) {
                 chunkHead_->size += increment;
+#if RAPIDJSON_ALLOCATOR_STATS
+                stats_.requested += increment;
+#endif
                 return originalPtr;
             }
         }
@@ -215,6 +343,10 @@ public:
         if (void* newBuffer = Malloc(newSize)) {
             if (originalSize)
                 std::memcpy(newBuffer, originalPtr, originalSize);
+#if RAPIDJSON_ALLOCATOR_STATS
+            stats_.requested -= originalSize; // the copied part was already counted
+            stats_.abandoned += originalSize;
+#endif
             return newBuffer;
         }
         else
@@ -242,13 +374,19 @@ private:
             chunk->size = 0;
             chunk->next = chunkHead_;
             chunkHead_ =  chunk;
+#if RAPIDJSON_ALLOCATOR_STATS
+            stats_.reserved += RAPIDJSON_ALIGN(sizeof(ChunkHeader)) + capacity;
+            stats_.chunkCount++;
+            if (stats_.reserved > stats_.peak)
+                stats_.peak = stats_.reserved;
+#endif
             return true;
         }
         else
             return false;
     }
 
-    static const int kDefaultChunkCapacity = 64 * 1024; //!< Default chunk capacity.
+    static const size_t kDefaultChunkCapacity = internal::DefaultChunkCapacity<BaseAllocator>::kValue; //!< Default chunk capacity.
 
     //! Chunk header for perpending to each chunk.
     /*! Chunks are stored as a singly linked list.
@@ -264,6 +402,9 @@ private:
     void *userBuffer_;          //!< User supplied buffer.
     BaseAllocator* baseAllocator_;  //!< base allocator for allocating memory chunks.
     BaseAllocator* ownBaseAllocator_;   //!< base allocator created by this object.
+#if RAPIDJSON_ALLOCATOR_STATS
+    AllocatorStats stats_;      //!< Memory usage counters.
+#endif
 };
 
 RAPIDJSON_NAMESPACE_END
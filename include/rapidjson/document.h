@@ -20,6 +20,7 @@
 #include "reader.h"
 #include "internal/meta.h"
 #include "internal/strfunc.h"
+#include "internal/hash.h"
 #include "memorystream.h"
 #include "encodedstream.h"
 #include <new>      // placement new
@@ -55,6 +56,21 @@ RAPIDJSON_DIAG_OFF(terminate) // ignore throwing RAPIDJSON_ASSERT in RAPIDJSON_N
 #include <utility> // std::move
 #endif
 
+/*! \def RAPIDJSON_VALUE_HASH_CACHE
+    \ingroup RAPIDJSON_CONFIG
+    \brief Cache the structural hash of objects and arrays (see GenericValue::GetHash()).
+
+    Define to 1 to have non-empty objects and (non-packed) arrays keep 8 more bytes after
+    their members or elements for the cached hash. By default the plain layout is kept and
+    GetHash() recomputes the hash of the whole subtree on every call.
+
+    With the cache, GetHash() and the non-const accessors write to the value, so a value
+    read by several threads at once must only be accessed through other const member functions.
+*/
+#ifndef RAPIDJSON_VALUE_HASH_CACHE
+#define RAPIDJSON_VALUE_HASH_CACHE 0
+#endif
+
 RAPIDJSON_NAMESPACE_BEGIN
 
 // Forward declaration.
@@ -725,7 +741,7 @@ public:
     */
     ~GenericValue() {
         if (Allocator::kNeedFree) { // Shortcut by Allocator's trait
-            switch(data_.f.flags) {
+            switch(data_.f.flags & ~kHashValidFlag) {
             case kArrayFlag:
                 {
                     GenericValue* e = GetElementsPointer();
@@ -741,6 +757,11 @@ public:
                 Allocator::Free(GetMembersPointer());
                 break;
 
+            case kInt64ArrayFlag:
+            case kDoubleArrayFlag:
+                Allocator::Free(GetElementsPointer());
+                break;
+
             case kCopyStringFlag:
                 Allocator::Free(const_cast<Ch*>(GetStringPointer()));
                 break;
@@ -853,7 +874,9 @@ public:
     //! Equal-to operator
     /*!
         \note If an object contains duplicated named member, comparing equality with any object is always \c false.
-        \note Linear time complexity (number of all values in the subtree and total lengths of all strings).
+        \note Linear time complexity (number of all values in the subtree and total lengths of all strings),
+            except for objects below \ref kMemberIndexThreshold members, which are compared in quadratic time.
+        \see CachedHashDiffers()
     */
     template <typename SourceAllocator>
     bool operator==(const GenericValue<Encoding, SourceAllocator>& rhs) const {
@@ -862,7 +885,7 @@ public:
             return false;
 
         switch (GetType()) {
-        case kObjectType: // Warning: O(n^2) inner-loop
+        case kObjectType: // O(n^2) inner-loop unless rhs has a member index
             if (data_.o.size != rhs.data_.o.size)
                 return false;
             for (ConstMemberIterator lhsMemberItr = MemberBegin(); lhsMemberItr != MemberEnd(); ++lhsMemberItr) {
@@ -875,6 +898,14 @@ public:
         case kArrayType:
             if (data_.a.size != rhs.data_.a.size)
                 return false;
+            if (IsPackedArray() || rhs.IsPackedArray()) {
+                GenericValue lhsElement;
+                RhsType rhsElement;
+                for (SizeType i = 0; i < data_.a.size; i++)
+                    if (ElementAt(i, lhsElement) != rhs.ElementAt(i, rhsElement))
+                        return false;
+                return true;
+            }
             for (SizeType i = 0; i < data_.a.size; i++)
                 if ((*this)[i] != rhs[i])
                     return false;
@@ -937,6 +968,83 @@ public:
     template <typename T> friend RAPIDJSON_DISABLEIF_RETURN((internal::IsGenericValue<T>), (bool)) operator!=(const T& lhs, const GenericValue& rhs) { return !(rhs == lhs); }
     //@}
 
+    //!@name Structural hash
+    //@{
+
+    //! Get the structural hash of the value.
+    /*! The hash ignores the order of object members and agrees with operator==: integers up to 2^53 are hashed
+        by their \c double value, so that 1 and 1.0 hash alike, larger integers by their exact value. Different
+        hashes therefore prove that two values differ, except for an integer beyond 2^53 against the \c double
+        it rounds to, which operator== compares after conversion. Equal hashes mean that the values are equal
+        with overwhelming probability; confirm with operator== where a collision matters.
+
+        With \ref RAPIDJSON_VALUE_HASH_CACHE, the hash of non-empty objects and arrays is cached and dropped by
+        every non-const member function, including the accessors through which the children can be modified
+        (operator[](), FindMember(), MemberBegin(), Begin(), ...). A child modified through a reference or an
+        iterator obtained before the last call leaves stale hashes in its ancestors; call InvalidateHash() on
+        them in that case.
+        \note Linear time complexity, constant time while the hash stays cached.
+    */
+    uint64_t GetHash() const {
+        switch (GetType()) {
+        case kObjectType: {
+            if (data_.f.flags & kHashValidFlag)
+                return *GetHashSlot();
+            uint64_t h = internal::HashCombine(0, kObjectType);
+            for (ConstMemberIterator m = MemberBegin(); m != MemberEnd(); ++m)
+                h += internal::HashCombine(m->name.GetHash(), m->value.GetHash()); // member order insensitive
+            return CacheHash(h);
+        }
+
+        case kArrayType: {
+            if (data_.f.flags & kHashValidFlag)
+                return *GetHashSlot();
+            uint64_t h = internal::HashCombine(0, kArrayType);
+            if (IsInt64Array()) {
+                for (SizeType i = 0; i < data_.a.size; i++)
+                    h = internal::HashCombine(h, HashInteger(static_cast<uint64_t>(GetInt64Array()[i]), GetInt64Array()[i] < 0));
+            }
+            else if (IsDoubleArray()) {
+                for (SizeType i = 0; i < data_.a.size; i++)
+                    h = internal::HashCombine(h, HashNumber(GetDoubleArray()[i]));
+            }
+            else {
+                for (ConstValueIterator v = Begin(); v != End(); ++v)
+                    h = internal::HashCombine(h, v->GetHash());
+            }
+            return CacheHash(h);
+        }
+
+        case kStringType:
+            return internal::HashBytes(GetString(), GetStringLength() * sizeof(Ch), kStringType);
+
+        case kNumberType:
+            return IsDouble() ? HashNumber(GetDouble()) : HashInteger(data_.n.u64, !IsUint64());
+
+        default:
+            return internal::HashBytes(0, 0, GetType());
+        }
+    }
+
+    //! Whether the cached hashes of two containers prove that they differ (\ref RAPIDJSON_VALUE_HASH_CACHE).
+    /*! \return false unless both hashes are cached and differ.
+        \note Constant time. Unlike operator==, trusts the caches, which a child modified through a reference
+            obtained before GetHash() leaves stale.
+    */
+    template <typename SourceAllocator>
+    bool CachedHashDiffers(const GenericValue<Encoding, SourceAllocator>& rhs) const {
+        return (data_.f.flags & rhs.data_.f.flags & kHashValidFlag) && *GetHashSlot() != *rhs.GetHashSlot();
+    }
+
+    //! Drop the cached hash of this value (not of its children).
+    /*! Writes to the value only when a hash is cached. */
+    GenericValue& InvalidateHash() {
+        if (data_.f.flags & kHashValidFlag)
+            data_.f.flags &= static_cast<uint16_t>(~kHashValidFlag);
+        return *this;
+    }
+    //@}
+
     //!@name Type
     //@{
 
@@ -945,8 +1053,9 @@ public:
     bool IsFalse()  const { return data_.f.flags == kFalseFlag; }
     bool IsTrue()   const { return data_.f.flags == kTrueFlag; }
     bool IsBool()   const { return (data_.f.flags & kBoolFlag) != 0; }
-    bool IsObject() const { return data_.f.flags == kObjectFlag; }
-    bool IsArray()  const { return data_.f.flags == kArrayFlag; }
+    bool IsObject() const { return GetType() == kObjectType; }
+    //! Whether this is an array of values; false for packed arrays (see IsPackedArray()), which still have GetType() == kArrayType.
+    bool IsArray()  const { return (data_.f.flags & (kTypeMask | kPackedFlag)) == kArrayFlag; }
     bool IsNumber() const { return (data_.f.flags & kNumberFlag) != 0; }
     bool IsInt()    const { return (data_.f.flags & kIntFlag) != 0; }
     bool IsUint()   const { return (data_.f.flags & kUintFlag) != 0; }
@@ -1022,6 +1131,53 @@ public:
     //! Get the number of members in the object.
     SizeType MemberCount() const { RAPIDJSON_ASSERT(IsObject()); return data_.o.size; }
 
+    //! Get the capacity of object.
+    SizeType MemberCapacity() const { RAPIDJSON_ASSERT(IsObject()); return data_.o.capacity; }
+
+    //! Request the object to have enough capacity to store members.
+    /*! \param newCapacity  The capacity that the object at least need to have.
+        \param allocator    Allocator for reallocating memory. It must be the same one as used before. Commonly use GenericDocument::GetAllocator().
+        \return The value itself for fluent API.
+        \note Linear time complexity.
+    */
+    GenericValue& MemberReserve(SizeType newCapacity, Allocator &allocator) {
+        RAPIDJSON_ASSERT(IsObject());
+        InvalidateHash();
+        if (newCapacity > data_.o.capacity) {
+            SetMembersPointer(reinterpret_cast<Member*>(allocator.Realloc(GetMembersPointer(), MemberStorageSize(data_.o.capacity), MemberStorageSize(newCapacity))));
+            data_.o.capacity = newCapacity;
+            BuildMemberIndex();
+        }
+        return *this;
+    }
+
+    //! Minimum object capacity for which a hash index of the member names is kept.
+    static const SizeType kMemberIndexThreshold = 32;
+
+    //! Number of bytes of the member buffer of an object with the given capacity.
+    /*! The members are followed by the cached hash of the object (\ref RAPIDJSON_VALUE_HASH_CACHE) and, for objects
+        whose capacity reaches \ref kMemberIndexThreshold, by a hash index of the member names.
+    */
+    static size_t MemberStorageSize(SizeType capacity) {
+        size_t size = capacity * sizeof(Member);
+        if (capacity)
+            size += kHashSlotSize;
+        if (capacity >= kMemberIndexThreshold)
+            size += MemberIndexSize(capacity) * sizeof(SizeType);
+        return size;
+    }
+
+    //! Rebuild the member index after member names were modified or reordered in place.
+    /*! The index is maintained by all member functions of the object. It only needs to be rebuilt
+        when names are changed through member iterators, e.g. after sorting the members.
+        \note Linear time complexity.
+    */
+    GenericValue& RebuildMemberIndex() {
+        RAPIDJSON_ASSERT(IsObject());
+        BuildMemberIndex();
+        return *this;
+    }
+
     //! Check whether the object is empty.
     bool ObjectEmpty() const { RAPIDJSON_ASSERT(IsObject()); return data_.o.size == 0; }
 
@@ -1040,7 +1196,10 @@ public:
         return (*this)[n];
     }
     template <typename T>
-    RAPIDJSON_DISABLEIF_RETURN((internal::NotExpr<internal::IsSame<typename internal::RemoveConst<T>::Type, Ch> >),(const GenericValue&)) operator[](T* name) const { return const_cast<GenericValue&>(*this)[name]; }
+    RAPIDJSON_DISABLEIF_RETURN((internal::NotExpr<internal::IsSame<typename internal::RemoveConst<T>::Type, Ch> >),(const GenericValue&)) operator[](T* name) const {
+        GenericValue n(StringRef(name));
+        return (*this)[n];
+    }
 
     //! Get a value from an object associated with the name.
     /*! \pre IsObject() == true
@@ -1053,7 +1212,12 @@ public:
     */
     template <typename SourceAllocator>
     GenericValue& operator[](const GenericValue<Encoding, SourceAllocator>& name) {
-        MemberIterator member = FindMember(name);
+        InvalidateHash();
+        return const_cast<GenericValue&>(static_cast<const GenericValue&>(*this)[name]);
+    }
+    template <typename SourceAllocator>
+    const GenericValue& operator[](const GenericValue<Encoding, SourceAllocator>& name) const {
+        ConstMemberIterator member = FindMember(name);
         if (member != MemberEnd())
             return member->value;
         else {
@@ -1068,8 +1232,6 @@ public:
             return *new (buffer) GenericValue();
         }
     }
-    template <typename SourceAllocator>
-    const GenericValue& operator[](const GenericValue<Encoding, SourceAllocator>& name) const { return const_cast<GenericValue&>(*this)[name]; }
 
 #if RAPIDJSON_HAS_STDSTRING
     //! Get a value from an object associated with name (string object).
@@ -1085,10 +1247,10 @@ public:
     ConstMemberIterator MemberEnd() const   { RAPIDJSON_ASSERT(IsObject()); return ConstMemberIterator(GetMembersPointer() + data_.o.size); }
     //! Member iterator
     /*! \pre IsObject() == true */
-    MemberIterator MemberBegin()            { RAPIDJSON_ASSERT(IsObject()); return MemberIterator(GetMembersPointer()); }
+    MemberIterator MemberBegin()            { RAPIDJSON_ASSERT(IsObject()); InvalidateHash(); return MemberIterator(GetMembersPointer()); }
     //! \em Past-the-end member iterator
     /*! \pre IsObject() == true */
-    MemberIterator MemberEnd()              { RAPIDJSON_ASSERT(IsObject()); return MemberIterator(GetMembersPointer() + data_.o.size); }
+    MemberIterator MemberEnd()              { RAPIDJSON_ASSERT(IsObject()); InvalidateHash(); return MemberIterator(GetMembersPointer() + data_.o.size); }
 
     //! Check whether a member exists in the object.
     /*!
@@ -1134,14 +1296,18 @@ public:
         \note Earlier versions of Rapidjson returned a \c NULL pointer, in case
             the requested member doesn't exist. For consistency with e.g.
             \c std::map, this has been changed to MemberEnd() now.
-        \note Linear time complexity.
+        \note Constant time complexity on average for objects with a member index
+            (capacity of at least \ref kMemberIndexThreshold), linear time otherwise.
     */
     MemberIterator FindMember(const Ch* name) {
         GenericValue n(StringRef(name));
         return FindMember(n);
     }
 
-    ConstMemberIterator FindMember(const Ch* name) const { return const_cast<GenericValue&>(*this).FindMember(name); }
+    ConstMemberIterator FindMember(const Ch* name) const {
+        GenericValue n(StringRef(name));
+        return FindMember(n);
+    }
 
     //! Find member by name.
     /*!
@@ -1154,19 +1320,15 @@ public:
         \note Earlier versions of Rapidjson returned a \c NULL pointer, in case
             the requested member doesn't exist. For consistency with e.g.
             \c std::map, this has been changed to MemberEnd() now.
-        \note Linear time complexity.
+        \note Constant time complexity on average for objects with a member index
+            (capacity of at least \ref kMemberIndexThreshold), linear time otherwise.
     */
     template <typename SourceAllocator>
     MemberIterator FindMember(const GenericValue<Encoding, SourceAllocator>& name) {
-        RAPIDJSON_ASSERT(IsObject());
-        RAPIDJSON_ASSERT(name.IsString());
-        MemberIterator member = MemberBegin();
-        for ( ; member != MemberEnd(); ++member)
-            if (name.StringEqual(member->name))
-                break;
-        return member;
+        InvalidateHash();
+        return MemberIterator(FindMemberPointer(name));
     }
-    template <typename SourceAllocator> ConstMemberIterator FindMember(const GenericValue<Encoding, SourceAllocator>& name) const { return const_cast<GenericValue&>(*this).FindMember(name); }
+    template <typename SourceAllocator> ConstMemberIterator FindMember(const GenericValue<Encoding, SourceAllocator>& name) const { return ConstMemberIterator(FindMemberPointer(name)); }
 
 #if RAPIDJSON_HAS_STDSTRING
     //! Find member by string object name.
@@ -1193,22 +1355,25 @@ public:
     GenericValue& AddMember(GenericValue& name, GenericValue& value, Allocator& allocator) {
         RAPIDJSON_ASSERT(IsObject());
         RAPIDJSON_ASSERT(name.IsString());
+        InvalidateHash();
 
         ObjectData& o = data_.o;
         if (o.size >= o.capacity) {
             if (o.capacity == 0) {
                 o.capacity = kDefaultObjectCapacity;
-                SetMembersPointer(reinterpret_cast<Member*>(allocator.Malloc(o.capacity * sizeof(Member))));
+                SetMembersPointer(reinterpret_cast<Member*>(allocator.Malloc(MemberStorageSize(o.capacity))));
             }
             else {
                 SizeType oldCapacity = o.capacity;
                 o.capacity += (oldCapacity + 1) / 2; // grow by factor 1.5
-                SetMembersPointer(reinterpret_cast<Member*>(allocator.Realloc(GetMembersPointer(), oldCapacity * sizeof(Member), o.capacity * sizeof(Member))));
+                SetMembersPointer(reinterpret_cast<Member*>(allocator.Realloc(GetMembersPointer(), MemberStorageSize(oldCapacity), MemberStorageSize(o.capacity))));
             }
+            BuildMemberIndex();
         }
         Member* members = GetMembersPointer();
         members[o.size].name.RawAssign(name);
         members[o.size].value.RawAssign(value);
+        IndexMember(o.size);
         o.size++;
         return *this;
     }
@@ -1346,6 +1511,7 @@ public:
         for (MemberIterator m = MemberBegin(); m != MemberEnd(); ++m)
             m->~Member();
         data_.o.size = 0;
+        BuildMemberIndex();
     }
 
     //! Remove a member in object by its name.
@@ -1389,8 +1555,14 @@ public:
         RAPIDJSON_ASSERT(data_.o.size > 0);
         RAPIDJSON_ASSERT(GetMembersPointer() != 0);
         RAPIDJSON_ASSERT(m >= MemberBegin() && m < MemberEnd());
+        InvalidateHash();
 
         MemberIterator last(GetMembersPointer() + (data_.o.size - 1));
+        if (GetMemberIndex()) {
+            UnindexMember(static_cast<SizeType>(m - MemberBegin()));
+            if (m != last)
+                *FindMemberIndexSlot(data_.o.size - 1) = static_cast<SizeType>(m - MemberBegin()) + 1;
+        }
         if (data_.o.size > 1 && m != last)
             *m = *last; // Move the last one to this place
         else
@@ -1434,6 +1606,7 @@ public:
             itr->~Member();
         std::memmove(&*pos, &*last, static_cast<size_t>(MemberEnd() - last) * sizeof(Member));
         data_.o.size -= static_cast<SizeType>(last - first);
+        BuildMemberIndex();
         return pos;
     }
 
@@ -1475,20 +1648,110 @@ public:
     GenericValue& SetArray() { this->~GenericValue(); new (this) GenericValue(kArrayType); return *this; }
 
     //! Get the number of elements in array.
-    SizeType Size() const { RAPIDJSON_ASSERT(IsArray()); return data_.a.size; }
+    SizeType Size() const { RAPIDJSON_ASSERT(GetType() == kArrayType); return data_.a.size; }
 
     //! Get the capacity of array.
-    SizeType Capacity() const { RAPIDJSON_ASSERT(IsArray()); return data_.a.capacity; }
+    SizeType Capacity() const { RAPIDJSON_ASSERT(GetType() == kArrayType); return data_.a.capacity; }
+
+    //! Number of bytes of the element buffer of a (non-packed) array with the given capacity.
+    /*! The elements are followed by the cached hash of the array (\ref RAPIDJSON_VALUE_HASH_CACHE). */
+    static size_t ElementStorageSize(SizeType capacity) {
+        return capacity ? capacity * sizeof(GenericValue) + kHashSlotSize : 0;
+    }
 
     //! Check whether the array is empty.
-    bool Empty() const { RAPIDJSON_ASSERT(IsArray()); return data_.a.size == 0; }
+    bool Empty() const { RAPIDJSON_ASSERT(GetType() == kArrayType); return data_.a.size == 0; }
+
+    //! Check whether the array stores its elements as a packed \c int64_t or \c double buffer.
+    /*! Packed arrays are created by \ref kParsePackedArraysFlag, SetInt64Array() and SetDoubleArray().
+        Their elements are read through GetInt64Array() / GetDoubleArray() (or Accept()), not through
+        operator[](), Begin() and End(), so IsArray() is false for them while GetType() is kArrayType.
+        Size(), Empty(), Clear(), PopBack() and ElementAt() work on both kinds, ErasePacked() removes
+        an element; Reserve() and PushBack() turn them back into regular arrays, as does UnpackArray().
+    */
+    bool IsPackedArray() const { return (data_.f.flags & (kTypeMask | kPackedFlag)) == kInt64ArrayFlag; }
+    bool IsInt64Array() const { return data_.f.flags == kInt64ArrayFlag; }
+    bool IsDoubleArray() const { return data_.f.flags == kDoubleArrayFlag; }
+
+    //! Elements of a packed integer array, Size() of them.
+    const int64_t* GetInt64Array() const { RAPIDJSON_ASSERT(IsInt64Array()); return reinterpret_cast<const int64_t*>(GetElementsPointer()); }
+    //! Elements of a packed double array, Size() of them.
+    const double* GetDoubleArray() const { RAPIDJSON_ASSERT(IsDoubleArray()); return reinterpret_cast<const double*>(GetElementsPointer()); }
+
+    //! Element \c index of a regular or packed array; elements of packed arrays are unpacked into \c scratch.
+    const GenericValue& ElementAt(SizeType index, GenericValue& scratch) const {
+        RAPIDJSON_ASSERT(GetType() == kArrayType);
+        RAPIDJSON_ASSERT(index < data_.a.size);
+        if (!IsPackedArray())
+            return GetElementsPointer()[index];
+        if (IsInt64Array())
+            scratch.SetInt64(GetInt64Array()[index]);
+        else
+            scratch.SetDouble(GetDoubleArray()[index]);
+        return scratch;
+    }
+
+    //! Remove element \c index of a packed array, keeping it packed.
+    /*! \note Linear time complexity.
+    */
+    GenericValue& ErasePacked(SizeType index) {
+        RAPIDJSON_ASSERT(IsPackedArray());
+        RAPIDJSON_ASSERT(index < data_.a.size);
+        InvalidateHash();
+        char* e = reinterpret_cast<char*>(GetElementsPointer());
+        const size_t width = IsInt64Array() ? sizeof(int64_t) : sizeof(double);
+        std::memmove(e + index * width, e + (index + 1) * width, (data_.a.size - index - 1) * width);
+        --data_.a.size;
+        return *this;
+    }
+
+    //! Set this value as a packed array of integers copied from \c values.
+    GenericValue& SetInt64Array(const int64_t* values, SizeType count, Allocator& allocator) {
+        this->~GenericValue();
+        SetPackedRaw(values, count, kInt64ArrayFlag, allocator);
+        return *this;
+    }
+
+    //! Set this value as a packed array of doubles copied from \c values.
+    GenericValue& SetDoubleArray(const double* values, SizeType count, Allocator& allocator) {
+        this->~GenericValue();
+        SetPackedRaw(values, count, kDoubleArrayFlag, allocator);
+        return *this;
+    }
+
+    //! Turn a packed array into a regular array of number values (no-op for regular arrays).
+    /*! \note Linear time complexity.
+    */
+    GenericValue& UnpackArray(Allocator& allocator) {
+        RAPIDJSON_ASSERT(GetType() == kArrayType);
+        if (!IsPackedArray())
+            return *this;
+        GenericValue* packed = GetElementsPointer();
+        GenericValue* e = data_.a.size ? static_cast<GenericValue*>(allocator.Malloc(ElementStorageSize(data_.a.size))) : 0;
+        for (SizeType i = 0; i < data_.a.size; i++) {
+            if (IsInt64Array())
+                new (&e[i]) GenericValue(reinterpret_cast<const int64_t*>(packed)[i]);
+            else
+                new (&e[i]) GenericValue(reinterpret_cast<const double*>(packed)[i]);
+        }
+        Allocator::Free(packed);
+        data_.f.flags = kArrayFlag;
+        SetElementsPointer(e);
+        data_.a.capacity = data_.a.size;
+        return *this;
+    }
 
     //! Remove all elements in the array.
     /*! This function do not deallocate memory in the array, i.e. the capacity is unchanged.
         \note Linear time complexity.
     */
     void Clear() {
-        RAPIDJSON_ASSERT(IsArray());
+        RAPIDJSON_ASSERT(GetType() == kArrayType);
+        InvalidateHash();
+        if (IsPackedArray()) {
+            data_.a.size = 0;
+            return;
+        }
         GenericValue* e = GetElementsPointer();
         for (GenericValue* v = e; v != e + data_.a.size; ++v)
             v->~GenericValue();
@@ -1501,24 +1764,27 @@ public:
         \see operator[](T*)
     */
     GenericValue& operator[](SizeType index) {
+        InvalidateHash();
+        return const_cast<GenericValue&>(static_cast<const GenericValue&>(*this)[index]);
+    }
+    const GenericValue& operator[](SizeType index) const {
         RAPIDJSON_ASSERT(IsArray());
         RAPIDJSON_ASSERT(index < data_.a.size);
         return GetElementsPointer()[index];
     }
-    const GenericValue& operator[](SizeType index) const { return const_cast<GenericValue&>(*this)[index]; }
 
     //! Element iterator
     /*! \pre IsArray() == true */
-    ValueIterator Begin() { RAPIDJSON_ASSERT(IsArray()); return GetElementsPointer(); }
+    ValueIterator Begin() { InvalidateHash(); return const_cast<ValueIterator>(static_cast<const GenericValue&>(*this).Begin()); }
     //! \em Past-the-end element iterator
     /*! \pre IsArray() == true */
-    ValueIterator End() { RAPIDJSON_ASSERT(IsArray()); return GetElementsPointer() + data_.a.size; }
+    ValueIterator End() { InvalidateHash(); return const_cast<ValueIterator>(static_cast<const GenericValue&>(*this).End()); }
     //! Constant element iterator
     /*! \pre IsArray() == true */
-    ConstValueIterator Begin() const { return const_cast<GenericValue&>(*this).Begin(); }
+    ConstValueIterator Begin() const { RAPIDJSON_ASSERT(IsArray()); return GetElementsPointer(); }
     //! Constant \em past-the-end element iterator
     /*! \pre IsArray() == true */
-    ConstValueIterator End() const { return const_cast<GenericValue&>(*this).End(); }
+    ConstValueIterator End() const { RAPIDJSON_ASSERT(IsArray()); return GetElementsPointer() + data_.a.size; }
 
     //! Request the array to have enough capacity to store elements.
     /*! \param newCapacity  The capacity that the array at least need to have.
@@ -1527,9 +1793,11 @@ public:
         \note Linear time complexity.
     */
     GenericValue& Reserve(SizeType newCapacity, Allocator &allocator) {
-        RAPIDJSON_ASSERT(IsArray());
+        RAPIDJSON_ASSERT(GetType() == kArrayType);
+        UnpackArray(allocator);
+        InvalidateHash();
         if (newCapacity > data_.a.capacity) {
-            SetElementsPointer(reinterpret_cast<GenericValue*>(allocator.Realloc(GetElementsPointer(), data_.a.capacity * sizeof(GenericValue), newCapacity * sizeof(GenericValue))));
+            SetElementsPointer(reinterpret_cast<GenericValue*>(allocator.Realloc(GetElementsPointer(), ElementStorageSize(data_.a.capacity), ElementStorageSize(newCapacity))));
             data_.a.capacity = newCapacity;
         }
         return *this;
@@ -1546,7 +1814,9 @@ public:
         \note Amortized constant time complexity.
     */
     GenericValue& PushBack(GenericValue& value, Allocator& allocator) {
-        RAPIDJSON_ASSERT(IsArray());
+        RAPIDJSON_ASSERT(GetType() == kArrayType);
+        UnpackArray(allocator);
+        InvalidateHash();
         if (data_.a.size >= data_.a.capacity)
             Reserve(data_.a.capacity == 0 ? kDefaultArrayCapacity : (data_.a.capacity + (data_.a.capacity + 1) / 2), allocator);
         GetElementsPointer()[data_.a.size++].RawAssign(value);
@@ -1601,8 +1871,13 @@ public:
         \note Constant time complexity.
     */
     GenericValue& PopBack() {
-        RAPIDJSON_ASSERT(IsArray());
+        RAPIDJSON_ASSERT(GetType() == kArrayType);
         RAPIDJSON_ASSERT(!Empty());
+        InvalidateHash();
+        if (IsPackedArray()) {
+            --data_.a.size;
+            return *this;
+        }
         GetElementsPointer()[--data_.a.size].~GenericValue();
         return *this;
     }
@@ -1727,6 +2002,19 @@ public:
     */
     GenericValue& SetString(const Ch* s, Allocator& allocator) { return SetString(s, internal::StrLen(s), allocator); }
 
+    //! Set this value as a string sharing storage of the allocator with other values.
+    /*! The storage is neither copied nor freed by this value, e.g. keys interned by \ref kParseInternKeysFlag.
+        Unlike a constant string, it is deep-copied by CopyFrom() and reported as a copy to Accept() handlers,
+        so copies never reference the source allocator.
+        \param s string reference into storage living as long as the allocator
+        \return The value itself for fluent API.
+        \post IsSharedString() == true && GetString() == s && GetStringLength() == s.length
+    */
+    GenericValue& SetSharedString(StringRefType s) { this->~GenericValue(); SetStringRaw(s); data_.f.flags = kSharedStringFlag; return *this; }
+
+    //! Whether the string shares its storage with other values (SetSharedString()).
+    bool IsSharedString() const { return data_.f.flags == kSharedStringFlag; }
+
 #if RAPIDJSON_HAS_STDSTRING
     //! Set this value as a string by copying from source string.
     /*! \param s source string.
@@ -1793,6 +2081,13 @@ public:
         case kArrayType:
             if (RAPIDJSON_UNLIKELY(!handler.StartArray()))
                 return false;
+            if (IsPackedArray()) {
+                GenericValue element;
+                for (SizeType i = 0; i < data_.a.size; i++)
+                    if (RAPIDJSON_UNLIKELY(!ElementAt(i, element).Accept(handler)))
+                        return false;
+                return handler.EndArray(data_.a.size);
+            }
             for (const GenericValue* v = Begin(); v != End(); ++v)
                 if (RAPIDJSON_UNLIKELY(!v->Accept(handler)))
                     return false;
@@ -1826,6 +2121,10 @@ private:
         kStringFlag     = 0x0400,
         kCopyFlag       = 0x0800,
         kInlineStrFlag  = 0x1000,
+        kPackedFlag     = 0x2000,
+        kPackedDoubleFlag = 0x4000,
+        kHashValidFlag  = 0x8000,
+        kSharedStrFlag  = kPackedFlag,  // strings only: storage shared by several values
 
         // Initial flags of different types.
         kNullFlag = kNullType,
@@ -1840,14 +2139,18 @@ private:
         kConstStringFlag = kStringType | kStringFlag,
         kCopyStringFlag = kStringType | kStringFlag | kCopyFlag,
         kShortStringFlag = kStringType | kStringFlag | kCopyFlag | kInlineStrFlag,
+        kSharedStringFlag = kStringType | kStringFlag | kCopyFlag | kSharedStrFlag,
         kObjectFlag = kObjectType,
         kArrayFlag = kArrayType,
+        kInt64ArrayFlag = kArrayType | kPackedFlag,
+        kDoubleArrayFlag = kArrayType | kPackedFlag | kPackedDoubleFlag,
 
         kTypeMask = 0x07
     };
 
     static const SizeType kDefaultArrayCapacity = 16;
     static const SizeType kDefaultObjectCapacity = 16;
+    static const size_t kHashSlotSize = RAPIDJSON_VALUE_HASH_CACHE ? sizeof(uint64_t) : 0;
 
     struct Flag {
 #if RAPIDJSON_48BITPOINTER_OPTIMIZATION
@@ -1937,11 +2240,44 @@ private:
     RAPIDJSON_FORCEINLINE Member* GetMembersPointer() const { return RAPIDJSON_GETPOINTER(Member, data_.o.members); }
     RAPIDJSON_FORCEINLINE Member* SetMembersPointer(Member* members) { return RAPIDJSON_SETPOINTER(Member, data_.o.members, members); }
 
+    // Cached hash of a non-empty object or array, stored right after its members or elements.
+    uint64_t* GetHashSlot() const {
+        return IsObject() ? reinterpret_cast<uint64_t*>(GetMembersPointer() + data_.o.capacity) : reinterpret_cast<uint64_t*>(GetElementsPointer() + data_.a.capacity);
+    }
+
+    uint64_t CacheHash(uint64_t h) const {
+        if (kHashSlotSize && (IsObject() ? data_.o.capacity : data_.a.capacity) && !IsPackedArray()) {
+            GenericValue* self = const_cast<GenericValue*>(this);
+            *self->GetHashSlot() = h;
+            self->data_.f.flags |= kHashValidFlag;
+        }
+        return h;
+    }
+
+    // Integral doubles beyond 2^53 hash as the 64-bit integer they hold exactly.
+    static uint64_t HashNumber(double d) {
+        if (!(d < 0.0) && !(d > 0.0))
+            d = 0.0; // -0.0 == 0.0
+        if (d > 9007199254740992.0 && d < 18446744073709551616.0)
+            return HashInteger(static_cast<uint64_t>(d), false);
+        if (d < -9007199254740992.0 && d >= -9223372036854775808.0)
+            return HashInteger(static_cast<uint64_t>(static_cast<int64_t>(d)), true);
+        return internal::HashBytes(&d, sizeof(d), kNumberType);
+    }
+
+    // Integers up to 2^53 hash as their double value, larger ones by their two's complement bits.
+    static uint64_t HashInteger(uint64_t bits, bool negative) {
+        const uint64_t magnitude = negative ? 0 - bits : bits;
+        if (magnitude <= RAPIDJSON_UINT64_C2(0x200000, 0x00000000))
+            return HashNumber(negative ? -static_cast<double>(magnitude) : static_cast<double>(magnitude));
+        return internal::HashBytes(&bits, sizeof(bits), kNumberType);
+    }
+
     // Initialize this value as array with initial data, without calling destructor.
     void SetArrayRaw(GenericValue* values, SizeType count, Allocator& allocator) {
         data_.f.flags = kArrayFlag;
         if (count) {
-            GenericValue* e = static_cast<GenericValue*>(allocator.Malloc(count * sizeof(GenericValue)));
+            GenericValue* e = static_cast<GenericValue*>(allocator.Malloc(ElementStorageSize(count)));
             SetElementsPointer(e);
             std::memcpy(e, values, count * sizeof(GenericValue));
         }
@@ -1950,17 +2286,141 @@ private:
         data_.a.size = data_.a.capacity = count;
     }
 
+    //! Initialize this value as packed array, without calling destructor.
+    template <typename T>
+    void SetPackedRaw(const T* values, SizeType count, uint16_t flags, Allocator& allocator) {
+        data_.f.flags = flags;
+        if (count) {
+            void* e = allocator.Malloc(count * sizeof(T));
+            std::memcpy(e, values, count * sizeof(T));
+            SetElementsPointer(static_cast<GenericValue*>(e));
+        }
+        else
+            SetElementsPointer(0);
+        data_.a.size = data_.a.capacity = count;
+    }
+
+    //! Initialize this value as packed array if all values are integers or all are doubles, without calling destructor.
+    bool SetPackedArrayRaw(GenericValue* values, SizeType count, Allocator& allocator) {
+        if (count == 0)
+            return false;
+        uint16_t all = static_cast<uint16_t>(~0u);
+        for (SizeType i = 0; i < count; i++)
+            all &= values[i].data_.f.flags;
+        if ((all & kNumberDoubleFlag) == kNumberDoubleFlag) {
+            double* e = static_cast<double*>(allocator.Malloc(count * sizeof(double)));
+            for (SizeType i = 0; i < count; i++)
+                e[i] = values[i].data_.n.d;
+            data_.f.flags = kDoubleArrayFlag;
+            SetElementsPointer(reinterpret_cast<GenericValue*>(e));
+        }
+        else if ((all & kNumberInt64Flag) == kNumberInt64Flag) {
+            int64_t* e = static_cast<int64_t*>(allocator.Malloc(count * sizeof(int64_t)));
+            for (SizeType i = 0; i < count; i++)
+                e[i] = values[i].data_.n.i64;
+            data_.f.flags = kInt64ArrayFlag;
+            SetElementsPointer(reinterpret_cast<GenericValue*>(e));
+        }
+        else
+            return false;
+        data_.a.size = data_.a.capacity = count;
+        return true;
+    }
+
     //! Initialize this value as object with initial data, without calling destructor.
     void SetObjectRaw(Member* members, SizeType count, Allocator& allocator) {
         data_.f.flags = kObjectFlag;
         if (count) {
-            Member* m = static_cast<Member*>(allocator.Malloc(count * sizeof(Member)));
+            Member* m = static_cast<Member*>(allocator.Malloc(MemberStorageSize(count)));
             SetMembersPointer(m);
             std::memcpy(m, members, count * sizeof(Member));
         }
         else
             SetMembersPointer(0);
         data_.o.size = data_.o.capacity = count;
+        BuildMemberIndex();
+    }
+
+    // Member index: open addressing table of MemberIndexSize(capacity) slots placed right after
+    // the members, each holding a member position + 1 (0 marks an empty slot). It only exists for
+    // objects with capacity >= kMemberIndexThreshold, so small objects keep their exact layout.
+    static SizeType MemberIndexSize(SizeType capacity) {
+        SizeType size = kMemberIndexThreshold * 2;
+        while (size < capacity * 2)
+            size <<= 1;
+        return size;
+    }
+
+    SizeType* GetMemberIndex() const {
+        return data_.o.capacity >= kMemberIndexThreshold ? reinterpret_cast<SizeType*>(reinterpret_cast<char*>(GetMembersPointer() + data_.o.capacity) + kHashSlotSize) : 0;
+    }
+
+    template <typename SourceAllocator>
+    static SizeType HashMemberName(const GenericValue<Encoding, SourceAllocator>& name) {
+        return internal::StrHash(name.GetString(), name.GetStringLength());
+    }
+
+    template <typename SourceAllocator>
+    Member* FindMemberPointer(const GenericValue<Encoding, SourceAllocator>& name) const {
+        RAPIDJSON_ASSERT(IsObject());
+        RAPIDJSON_ASSERT(name.IsString());
+        Member* members = GetMembersPointer();
+        if (const SizeType* index = GetMemberIndex()) {
+            const SizeType mask = MemberIndexSize(data_.o.capacity) - 1;
+            for (SizeType i = HashMemberName(name) & mask; index[i] != 0; i = (i + 1) & mask)
+                if (name.StringEqual(members[index[i] - 1].name))
+                    return members + (index[i] - 1);
+            return members + data_.o.size;
+        }
+        Member* member = members;
+        for ( ; member != members + data_.o.size; ++member)
+            if (name.StringEqual(member->name))
+                break;
+        return member;
+    }
+
+    void IndexMember(SizeType pos) {
+        if (SizeType* index = GetMemberIndex()) {
+            const SizeType mask = MemberIndexSize(data_.o.capacity) - 1;
+            SizeType i = HashMemberName(GetMembersPointer()[pos].name) & mask;
+            while (index[i] != 0)
+                i = (i + 1) & mask;
+            index[i] = pos + 1;
+        }
+    }
+
+    void BuildMemberIndex() {
+        if (SizeType* index = GetMemberIndex()) {
+            std::memset(index, 0, MemberIndexSize(data_.o.capacity) * sizeof(SizeType));
+            for (SizeType pos = 0; pos < data_.o.size; pos++)
+                IndexMember(pos);
+        }
+    }
+
+    SizeType* FindMemberIndexSlot(SizeType pos) const {
+        SizeType* index = GetMemberIndex();
+        const SizeType mask = MemberIndexSize(data_.o.capacity) - 1;
+        SizeType i = HashMemberName(GetMembersPointer()[pos].name) & mask;
+        while (index[i] != pos + 1) {
+            RAPIDJSON_ASSERT(index[i] != 0);
+            i = (i + 1) & mask;
+        }
+        return &index[i];
+    }
+
+    // Backward shift deletion keeps every probe sequence free of holes.
+    void UnindexMember(SizeType pos) {
+        SizeType* index = GetMemberIndex();
+        const SizeType mask = MemberIndexSize(data_.o.capacity) - 1;
+        SizeType hole = static_cast<SizeType>(FindMemberIndexSlot(pos) - index);
+        for (SizeType i = (hole + 1) & mask; index[i] != 0; i = (i + 1) & mask) {
+            SizeType home = HashMemberName(GetMembersPointer()[index[i] - 1].name) & mask;
+            if (((i - home) & mask) >= ((i - hole) & mask)) {
+                index[hole] = index[i];
+                hole = i;
+            }
+        }
+        index[hole] = 0;
     }
 
     //! Initialize this value as constant string, without calling destructor.
@@ -2042,7 +2502,8 @@ public:
         \param stackAllocator   Optional allocator for allocating memory for stack.
     */
     explicit GenericDocument(Type type, Allocator* allocator = 0, size_t stackCapacity = kDefaultStackCapacity, StackAllocator* stackAllocator = 0) :
-        GenericValue<Encoding, Allocator>(type),  allocator_(allocator), ownAllocator_(0), stack_(stackAllocator, stackCapacity), parseResult_()
+        GenericValue<Encoding, Allocator>(type),  allocator_(allocator), ownAllocator_(0), stack_(stackAllocator, stackCapacity), parseResult_(),
+        keys_(0), keyCount_(0), keyCapacity_(0), internKeys_(false), packArrays_(false)
     {
         if (!allocator_)
             ownAllocator_ = allocator_ = RAPIDJSON_NEW(Allocator());
@@ -2055,7 +2516,8 @@ public:
         \param stackAllocator   Optional allocator for allocating memory for stack.
     */
     GenericDocument(Allocator* allocator = 0, size_t stackCapacity = kDefaultStackCapacity, StackAllocator* stackAllocator = 0) :
-        allocator_(allocator), ownAllocator_(0), stack_(stackAllocator, stackCapacity), parseResult_()
+        allocator_(allocator), ownAllocator_(0), stack_(stackAllocator, stackCapacity), parseResult_(),
+        keys_(0), keyCount_(0), keyCapacity_(0), internKeys_(false), packArrays_(false)
     {
         if (!allocator_)
             ownAllocator_ = allocator_ = RAPIDJSON_NEW(Allocator());
@@ -2068,7 +2530,8 @@ public:
           allocator_(rhs.allocator_),
           ownAllocator_(rhs.ownAllocator_),
           stack_(std::move(rhs.stack_)),
-          parseResult_(rhs.parseResult_)
+          parseResult_(rhs.parseResult_),
+          keys_(0), keyCount_(0), keyCapacity_(0), internKeys_(false), packArrays_(false)
     {
         rhs.allocator_ = 0;
         rhs.ownAllocator_ = 0;
@@ -2139,8 +2602,22 @@ public:
         \return The document itself for fluent API.
     */
     template <typename Generator>
+    GenericDocument& Populate(Generator& g) {
+        return Populate<kParseDefaultFlags>(g);
+    }
+
+    //! Populate this document by a generator which produces SAX events, building it as \ref ParseStream() would.
+    /*! \tparam parseFlags Combination of \ref ParseFlag. \ref kParseInternKeysFlag and \ref kParsePackedArraysFlag
+            apply to the document built here; the generator handles the other flags.
+        \tparam Generator A functor with <tt>bool f(Handler)</tt> prototype.
+        \param g Generator functor which sends SAX events to the parameter.
+        \return The document itself for fluent API.
+    */
+    template <unsigned parseFlags, typename Generator>
     GenericDocument& Populate(Generator& g) {
         ClearStackOnExit scope(*this);
+        internKeys_ = (parseFlags & kParseInternKeysFlag) && !Allocator::kNeedFree;
+        packArrays_ = (parseFlags & kParsePackedArraysFlag) != 0;
         if (g(*this)) {
             RAPIDJSON_ASSERT(stack_.GetSize() == sizeof(ValueType)); // Got one and only one root object
             ValueType::operator=(*stack_.template Pop<ValueType>(1));// Move value from stack to document
@@ -2163,6 +2640,8 @@ public:
         GenericReader<SourceEncoding, Encoding, StackAllocator> reader(
             stack_.HasAllocator() ? &stack_.GetAllocator() : 0);
         ClearStackOnExit scope(*this);
+        internKeys_ = (parseFlags & kParseInternKeysFlag) && !Allocator::kNeedFree;
+        packArrays_ = (parseFlags & kParsePackedArraysFlag) != 0;
         parseResult_ = reader.template Parse<parseFlags>(is, *this);
         if (parseResult_) {
             RAPIDJSON_ASSERT(stack_.GetSize() == sizeof(ValueType)); // Got one and only one root object
@@ -2317,6 +2796,12 @@ public:
         return *allocator_;
     }
 
+    //! Get the allocator of this document (read-only, e.g. for Capacity() or statistics).
+    const Allocator& GetAllocator() const {
+        RAPIDJSON_ASSERT(allocator_);
+        return *allocator_;
+    }
+
     //! Get the capacity of stack in bytes.
     size_t GetStackCapacity() const { return stack_.GetCapacity(); }
 
@@ -2363,7 +2848,13 @@ public:
 
     bool StartObject() { new (stack_.template Push<ValueType>()) ValueType(kObjectType); return true; }
 
-    bool Key(const Ch* str, SizeType length, bool copy) { return String(str, length, copy); }
+    bool Key(const Ch* str, SizeType length, bool copy) {
+        if (internKeys_) {
+            (new (stack_.template Push<ValueType>()) ValueType())->SetSharedString(StringRef(InternKey(str, length), length));
+            return true;
+        }
+        return String(str, length, copy);
+    }
 
     bool EndObject(SizeType memberCount) {
         typename ValueType::Member* members = stack_.template Pop<typename ValueType::Member>(memberCount);
@@ -2375,7 +2866,9 @@ public:
 
     bool EndArray(SizeType elementCount) {
         ValueType* elements = stack_.template Pop<ValueType>(elementCount);
-        stack_.template Top<ValueType>()->SetArrayRaw(elements, elementCount, GetAllocator());
+        ValueType* array = stack_.template Top<ValueType>();
+        if (!packArrays_ || !array->SetPackedArrayRaw(elements, elementCount, GetAllocator()))
+            array->SetArrayRaw(elements, elementCount, GetAllocator());
         return true;
     }
 
@@ -2392,6 +2885,58 @@ private:
         else
             stack_.Clear();
         stack_.ShrinkToFit();
+        StackAllocator::Free(keys_);
+        keys_ = 0;
+        keyCount_ = keyCapacity_ = 0;
+        internKeys_ = false;
+        packArrays_ = false;
+    }
+
+    //! Interned key of the key dictionary (kParseInternKeysFlag).
+    struct InternedKey {
+        const Ch* str;
+        SizeType length;
+        uint32_t hash;
+    };
+
+    //! Returns the document-wide copy of a key, allocated on first use.
+    /*! The dictionary is an open addressing table living in the stack allocator for the
+        duration of the parse; the interned strings themselves belong to the document allocator.
+    */
+    const Ch* InternKey(const Ch* str, SizeType length) {
+        const uint32_t hash = internal::StrHash(str, length);
+        if (keyCount_ * 2 >= keyCapacity_)
+            GrowKeys();
+        const SizeType mask = keyCapacity_ - 1;
+        SizeType i = hash & mask;
+        for (; keys_[i].str; i = (i + 1) & mask)
+            if (keys_[i].hash == hash && keys_[i].length == length && std::memcmp(keys_[i].str, str, length * sizeof(Ch)) == 0)
+                return keys_[i].str;
+
+        Ch* s = static_cast<Ch*>(GetAllocator().Malloc((length + 1) * sizeof(Ch)));
+        std::memcpy(s, str, length * sizeof(Ch));
+        s[length] = '\0';
+        keys_[i].str = s;
+        keys_[i].length = length;
+        keys_[i].hash = hash;
+        keyCount_++;
+        return s;
+    }
+
+    void GrowKeys() {
+        const SizeType capacity = keyCapacity_ ? keyCapacity_ * 2 : 64;
+        InternedKey* keys = static_cast<InternedKey*>(stack_.GetAllocator().Malloc(capacity * sizeof(InternedKey)));
+        std::memset(keys, 0, capacity * sizeof(InternedKey));
+        for (SizeType k = 0; k < keyCapacity_; k++)
+            if (keys_[k].str) {
+                SizeType i = keys_[k].hash & (capacity - 1);
+                while (keys[i].str)
+                    i = (i + 1) & (capacity - 1);
+                keys[i] = keys_[k];
+            }
+        StackAllocator::Free(keys_);
+        keys_ = keys;
+        keyCapacity_ = capacity;
     }
 
     void Destroy() {
@@ -2403,6 +2948,11 @@ private:
     Allocator* ownAllocator_;
     internal::Stack<StackAllocator> stack_;
     ParseResult parseResult_;
+    InternedKey* keys_;
+    SizeType keyCount_;
+    SizeType keyCapacity_;
+    bool internKeys_;
+    bool packArrays_;
 };
 
 //! GenericDocument with UTF8 encoding
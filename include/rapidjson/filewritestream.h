@@ -60,6 +60,23 @@ public:
         }
     }
 
+    void PutN(const char* str, size_t n) {
+        size_t avail = static_cast<size_t>(bufferEnd_ - current_);
+        while (n > avail) {
+            std::memcpy(current_, str, avail);
+            current_ += avail;
+            Flush();
+            str += avail;
+            n -= avail;
+            avail = static_cast<size_t>(bufferEnd_ - current_);
+        }
+
+        if (n > 0) {
+            std::memcpy(current_, str, n);
+            current_ += n;
+        }
+    }
+
     void Flush() {
         if (current_ != buffer_) {
             size_t result = fwrite(buffer_, 1, static_cast<size_t>(current_ - buffer_), fp_);
@@ -89,6 +106,11 @@ private:
     char *current_;
 };
 
+//! Implement specialized version of PutUnsafeN() with memcpy() for better performance.
+inline void PutUnsafeN(FileWriteStream& stream, const char* str, size_t n) {
+    stream.PutN(str, n);
+}
+
 //! Implement specialized version of PutN() with memset() for better performance.
 template<>
 inline void PutN(FileWriteStream& stream, char c, size_t n) {
@@ -41,6 +41,10 @@ class CrtAllocator;
 template <typename BaseAllocator>
 class MemoryPoolAllocator;
 
+// hugepageallocator.h
+
+class HugePageAllocator;
+
 // stream.h
 
 template <typename Encoding>
@@ -0,0 +1,180 @@
+// Tencent is pleased to support the open source community by making RapidJSON available.
+// 
+// Copyright (C) 2015 THL A29 Limited, a Tencent company, and Milo Yip. All rights reserved.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed 
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR 
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the 
+// specific language governing permissions and limitations under the License.
+
+#ifndef RAPIDJSON_HUGEPAGEALLOCATOR_H_
+#define RAPIDJSON_HUGEPAGEALLOCATOR_H_
+
+#include "allocators.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define RAPIDJSON_HAS_MMAP 1
+#else
+#define RAPIDJSON_HAS_MMAP 0
+#endif
+
+RAPIDJSON_NAMESPACE_BEGIN
+
+///////////////////////////////////////////////////////////////////////////////
+// HugePageAllocator
+
+//! Allocator returning 2 MB aligned regions backed by huge pages when possible.
+/*! This allocator is meant to be the \c BaseAllocator of MemoryPoolAllocator,
+    i.e. to provide the chunks of the pool. Each block is rounded up to a
+    multiple of 2 MB and mapped with \c mmap():
+
+    - with \c MAP_HUGETLB first, when available and requested (needs pages
+      reserved in \c /proc/sys/vm/nr_hugepages);
+    - otherwise as an aligned anonymous mapping advised with \c MADV_HUGEPAGE,
+      so that transparent huge pages back it;
+    - otherwise (no \c mmap, or mapping failure) with \c std::malloc().
+
+    MemoryPoolAllocator<HugePageAllocator> uses chunks of \ref kChunkCapacity
+    bytes by default, so that every chunk fills exactly one huge page.
+
+    Huge pages cut the TLB misses of lookups scattered over a large document.
+    Parsing is not faster: it writes the same bytes, and the kernel zeroes (and
+    with \c defrag=madvise may first compact) every 2 MB page on first touch.
+
+    \note implements Allocator concept
+*/
+class HugePageAllocator {
+public:
+    static const bool kNeedFree = true;
+    static const size_t kHugePageSize = 2 * 1024 * 1024;        //!< Size and alignment of the mapped regions.
+    static const size_t kChunkCapacity = kHugePageSize - 64;    //!< Chunk capacity leaving room for the block and chunk headers.
+
+    //! Constructor.
+    /*! \param explicitHugePages Try \c MAP_HUGETLB before transparent huge pages. Off by default:
+        without reserved pages every chunk would pay for a failing \c mmap() first.
+    */
+    explicit HugePageAllocator(bool explicitHugePages = false) : explicitHugePages_(explicitHugePages) {}
+
+    void* Malloc(size_t size) {
+        if (!size)
+            return NULL;
+
+        const size_t total = (size + kHeaderSize + kHugePageSize - 1) & ~(kHugePageSize - 1);
+        Header* header = 0;
+#if RAPIDJSON_HAS_MMAP
+        header = MapHugeTlb(total);
+        if (!header)
+            header = MapAligned(total);
+#endif
+        if (!header) {
+            header = static_cast<Header*>(std::malloc(size + kHeaderSize));
+            if (!header)
+                return NULL;
+            header->size = size + kHeaderSize;
+            header->kind = kMalloc;
+        }
+        return reinterpret_cast<char*>(header) + kHeaderSize;
+    }
+
+    void* Realloc(void* originalPtr, size_t originalSize, size_t newSize) {
+        if (newSize == 0) {
+            Free(originalPtr);
+            return NULL;
+        }
+        if (originalPtr && newSize <= GetHeader(originalPtr)->size - kHeaderSize)
+            return originalPtr; // fits in the rounded-up region
+        void* newPtr = Malloc(newSize);
+        if (newPtr && originalPtr) {
+            std::memcpy(newPtr, originalPtr, originalSize < newSize ? originalSize : newSize);
+            Free(originalPtr);
+        }
+        return newPtr;
+    }
+
+    static void Free(void *ptr) {
+        if (!ptr)
+            return;
+        Header* header = GetHeader(ptr);
+#if RAPIDJSON_HAS_MMAP
+        if (header->kind != kMalloc) {
+            munmap(header, header->size);
+            return;
+        }
+#endif
+        std::free(header);
+    }
+
+private:
+    enum Kind { kMalloc, kHugeTlb, kTransparent };
+
+    //! Block header, placed at the start of the region.
+    struct Header {
+        size_t size;    //!< Size of the whole region in bytes, header included.
+        size_t kind;    //!< How the region was obtained, see Kind.
+    };
+
+    static const size_t kHeaderSize = RAPIDJSON_ALIGN(sizeof(Header));
+
+    static Header* GetHeader(void* ptr) { return reinterpret_cast<Header*>(static_cast<char*>(ptr) - kHeaderSize); }
+
+#if RAPIDJSON_HAS_MMAP
+    Header* MapHugeTlb(size_t total) {
+#ifdef MAP_HUGETLB
+        if (explicitHugePages_) {
+            void* p = mmap(0, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED) {
+                Header* header = static_cast<Header*>(p);
+                header->size = total;
+                header->kind = kHugeTlb;
+                return header;
+            }
+        }
+#endif
+        (void)total;
+        return 0;
+    }
+
+    static Header* MapAligned(size_t total) {
+        // Over-allocate by one huge page, then trim both ends to the 2 MB boundary.
+        const size_t mapped = total + kHugePageSize;
+        void* p = mmap(0, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            return 0;
+
+        char* base = static_cast<char*>(p);
+        char* aligned = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(base) + kHugePageSize - 1) & ~static_cast<uintptr_t>(kHugePageSize - 1));
+        if (aligned != base)
+            munmap(base, static_cast<size_t>(aligned - base));
+        if (aligned + total != base + mapped)
+            munmap(aligned + total, static_cast<size_t>(base + mapped - (aligned + total)));
+#ifdef MADV_HUGEPAGE
+        madvise(aligned, total, MADV_HUGEPAGE);
+#endif
+        Header* header = reinterpret_cast<Header*>(aligned);
+        header->size = total;
+        header->kind = kTransparent;
+        return header;
+    }
+#endif // RAPIDJSON_HAS_MMAP
+
+    bool explicitHugePages_;
+};
+
+namespace internal {
+
+template <>
+struct DefaultChunkCapacity<HugePageAllocator> {
+    static const size_t kValue = HugePageAllocator::kChunkCapacity;
+};
+
+} // namespace internal
+
+RAPIDJSON_NAMESPACE_END
+
+#endif // RAPIDJSON_HUGEPAGEALLOCATOR_H_
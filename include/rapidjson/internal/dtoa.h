@@ -213,6 +213,63 @@ inline char* Prettify(char* buffer, int length, int k, int maxDecimalPlaces) {
     }
 }
 
+//! Formats a positive value with a known number of decimal places without Grisu2.
+/*! Writes the value rounded to maxDecimalPlaces decimals, without trailing zeros, when that decimal is
+    provably what Grisu2() followed by the truncation in Prettify() would produce: it lies well inside
+    the rounding interval of the value, and the interval is narrower than 10^-maxDecimalPlaces so no
+    other decimal with as few places fits. Prices and factors such as 11.11 are typical.
+    \return end of the output, or 0 when the value does not qualify and must go through Grisu2().
+*/
+inline char* DtoaFixed(double value, char* buffer, int maxDecimalPlaces) {
+    static const double kPow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17 };
+    static const uint64_t kPow5[] = { 1, 5, 25, 125, 625, 3125, 15625, 78125, 390625, 1953125, 9765625, 48828125, 244140625,
+        1220703125, RAPIDJSON_UINT64_C2(0x00000001, 0x6BCC41E9) /* 5^14 */, RAPIDJSON_UINT64_C2(0x00000007, 0x1AFD498D) /* 5^15 */,
+        RAPIDJSON_UINT64_C2(0x00000023, 0x86F26FC1) /* 5^16 */, RAPIDJSON_UINT64_C2(0x000000B1, 0xA2BC2EC5) /* 5^17 */ };
+    // Plain decimal notation in Prettify() needs 1e-5 <= value; the scaled value must be an exact integer in double
+    if (maxDecimalPlaces > 17 || !(value >= 1e-5))
+        return 0;
+    const double scaled = value * kPow10[maxDecimalPlaces];
+    if (!(scaled < 9007199254740992.0)) // 2^53
+        return 0;
+
+    // value = m * 2^-s with s = t + maxDecimalPlaces, so value * 10^k = m * 5^k / 2^t
+    const Double d(value);
+    const uint64_t m = d.IntegerSignificand();
+    const int t = -d.IntegerExponent() - maxDecimalPlaces;
+    const uint64_t p5 = kPow5[maxDecimalPlaces];
+    if (t <= 0 || t > 60 || m == (uint64_t(1) << 52) || (uint64_t(1) << t) <= p5)
+        return 0; // ulp not below 10^-k, or asymmetric interval at a power of two
+
+    // Error of the candidate in units of 2^-t, computed modulo 2^64; the true error is far below 2^63.
+    // Accept within 63/64 of half an ulp, which leaves room for the narrowed interval of Grisu2().
+    const uint64_t c = static_cast<uint64_t>(scaled + 0.5);
+    uint64_t e = (c << t) - m * p5;
+    if (e >> 63)
+        e = ~e + 1;
+    if (e >= (uint64_t(1) << 50) || e * 128 >= p5 * 63)
+        return 0;
+
+    const uint64_t scale = static_cast<uint64_t>(kPow10[maxDecimalPlaces]);
+    const uint64_t integer = c / scale;
+    uint64_t fraction = c - integer * scale;
+    buffer = u64toa(integer, buffer);
+    *buffer++ = '.';
+    if (fraction == 0) {
+        *buffer++ = '0';
+        return buffer;
+    }
+    int length = maxDecimalPlaces;
+    while (fraction % 10 == 0) {
+        fraction /= 10;
+        length--;
+    }
+    for (int i = length - 1; i >= 0; i--) {
+        buffer[i] = static_cast<char>('0' + static_cast<char>(fraction % 10));
+        fraction /= 10;
+    }
+    return buffer + length;
+}
+
 inline char* dtoa(double value, char* buffer, int maxDecimalPlaces = 324) {
     RAPIDJSON_ASSERT(maxDecimalPlaces >= 1);
     Double d(value);
@@ -229,6 +286,9 @@ inline char* dtoa(double value, char* buffer, int maxDecimalPlaces = 324) {
             *buffer++ = '-';
             value = -value;
         }
+        char* end = DtoaFixed(value, buffer, maxDecimalPlaces);
+        if (end)
+            return end;
         int length, K;
         Grisu2(value, buffer, &length, &K);
         return Prettify(buffer, length, K, maxDecimalPlaces);
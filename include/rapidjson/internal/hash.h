@@ -0,0 +1,120 @@
+// Tencent is pleased to support the open source community by making RapidJSON available.
+//
+// Copyright (C) 2015 THL A29 Limited, a Tencent company, and Milo Yip.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// 64-bit multiply-mix hashing in the style of wyhash (Wang Yi, public domain):
+// the input is consumed 16 or 48 bytes at a time and every step folds the
+// 128-bit product of two words back into 64 bits.
+
+#ifndef RAPIDJSON_INTERNAL_HASH_H_
+#define RAPIDJSON_INTERNAL_HASH_H_
+
+#include "../rapidjson.h"
+#include <cstring> // memcpy
+
+#if defined(_MSC_VER) && defined(_M_AMD64)
+#include <intrin.h>
+#pragma intrinsic(_umul128)
+#endif
+
+RAPIDJSON_NAMESPACE_BEGIN
+namespace internal {
+
+static const uint64_t kHashSecret0 = RAPIDJSON_UINT64_C2(0xa0761d64, 0x78bd642f);
+static const uint64_t kHashSecret1 = RAPIDJSON_UINT64_C2(0xe7037ed1, 0xa0b428db);
+static const uint64_t kHashSecret2 = RAPIDJSON_UINT64_C2(0x8ebc6af0, 0x9c88c6e3);
+static const uint64_t kHashSecret3 = RAPIDJSON_UINT64_C2(0x589965cc, 0x75374cc3);
+
+//! Replaces \c a and \c b by the low and high words of their 128-bit product.
+inline void HashMum(uint64_t* a, uint64_t* b) {
+#if defined(_MSC_VER) && defined(_M_AMD64)
+    *a = _umul128(*a, *b, b);
+#elif (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 6)) && defined(__x86_64__)
+    __extension__ typedef unsigned __int128 uint128;
+    uint128 p = static_cast<uint128>(*a) * static_cast<uint128>(*b);
+    *a = static_cast<uint64_t>(p);
+    *b = static_cast<uint64_t>(p >> 64);
+#else
+    const uint64_t M32 = 0xFFFFFFFF;
+    const uint64_t ha = *a >> 32, la = *a & M32, hb = *b >> 32, lb = *b & M32;
+    const uint64_t hh = ha * hb, hl = ha * lb, lh = la * hb, ll = la * lb;
+    const uint64_t mid = (ll >> 32) + (hl & M32) + (lh & M32);
+    *a = (mid << 32) | (ll & M32);
+    *b = hh + (hl >> 32) + (lh >> 32) + (mid >> 32);
+#endif
+}
+
+//! Mixes two words into one.
+inline uint64_t HashMix(uint64_t a, uint64_t b) {
+    HashMum(&a, &b);
+    return a ^ b;
+}
+
+inline uint64_t HashRead64(const unsigned char* p) { uint64_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+inline uint64_t HashRead32(const unsigned char* p) { uint32_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+
+//! Hashes \c length bytes starting at \c data.
+/*! Words are read in native byte order, so hash values differ between little- and big-endian machines. */
+inline uint64_t HashBytes(const void* data, size_t length, uint64_t seed) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    seed ^= HashMix(seed ^ kHashSecret0, kHashSecret1);
+    uint64_t a, b;
+    if (length <= 16) {
+        if (length >= 4) {
+            const size_t middle = (length >> 3) << 2;
+            a = (HashRead32(p) << 32) | HashRead32(p + middle);
+            b = (HashRead32(p + length - 4) << 32) | HashRead32(p + length - 4 - middle);
+        }
+        else if (length > 0) {
+            a = (uint64_t(p[0]) << 16) | (uint64_t(p[length >> 1]) << 8) | p[length - 1];
+            b = 0;
+        }
+        else
+            a = b = 0;
+    }
+    else {
+        size_t i = length;
+        if (i > 48) {
+            uint64_t seed1 = seed, seed2 = seed;
+            do {
+                seed = HashMix(HashRead64(p) ^ kHashSecret1, HashRead64(p + 8) ^ seed);
+                seed1 = HashMix(HashRead64(p + 16) ^ kHashSecret2, HashRead64(p + 24) ^ seed1);
+                seed2 = HashMix(HashRead64(p + 32) ^ kHashSecret3, HashRead64(p + 40) ^ seed2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (i > 16) {
+            seed = HashMix(HashRead64(p) ^ kHashSecret1, HashRead64(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        a = HashRead64(p + i - 16);
+        b = HashRead64(p + i - 8);
+    }
+    a ^= kHashSecret1;
+    b ^= seed;
+    HashMum(&a, &b);
+    return HashMix(a ^ kHashSecret0 ^ length, b ^ kHashSecret1);
+}
+
+//! Folds the hash \c d of a child into the running hash \c h of its container.
+inline uint64_t HashCombine(uint64_t h, uint64_t d) {
+    return HashMix(h ^ kHashSecret1, d ^ kHashSecret2);
+}
+
+} // namespace internal
+RAPIDJSON_NAMESPACE_END
+
+#endif // RAPIDJSON_INTERNAL_HASH_H_
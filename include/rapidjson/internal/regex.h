@@ -40,6 +40,12 @@ RAPIDJSON_DIAG_OFF(4512) // assignment operator could not be generated
 #define RAPIDJSON_REGEX_VERBOSE 0
 #endif
 
+#ifndef RAPIDJSON_REGEX_DFA_MAX_STATES
+//! Maximum number of DFA states cached per regex and anchoring mode.
+/*! Once the cache is full, matching continues with the NFA simulation. */
+#define RAPIDJSON_REGEX_DFA_MAX_STATES 256
+#endif
+
 RAPIDJSON_NAMESPACE_BEGIN
 namespace internal {
 
@@ -49,6 +55,9 @@ namespace internal {
 static const SizeType kRegexInvalidState = ~SizeType(0);  //!< Represents an invalid index in GenericRegex::State::out, out1
 static const SizeType kRegexInvalidRange = ~SizeType(0);
 
+template <typename RegexType, typename Allocator>
+class GenericRegexSearch;
+
 //! Regular expression engine with subset of ECMAscript grammar.
 /*!
     Supported regular expression syntax:
@@ -80,32 +89,44 @@ static const SizeType kRegexInvalidRange = ~SizeType(0);
     \note This is a Thompson NFA engine, implemented with reference to 
         Cox, Russ. "Regular Expression Matching Can Be Simple And Fast (but is slow in Java, Perl, PHP, Python, Ruby,...).", 
         https://swtch.com/~rsc/regexp/regexp1.html 
+
+    \note The NFA is simulated through a lazily built DFA: each set of NFA states
+        reached while matching becomes a cached DFA state, with transitions over
+        the equivalence classes of ASCII codepoints. Non-ASCII codepoints are
+        stepped without caching the transition, and matching falls back to plain
+        NFA simulation once RAPIDJSON_REGEX_DFA_MAX_STATES states are cached.
+        Search(s, length) additionally rejects inputs lacking the literal prefix
+        or the longest literal substring that every match must contain.
+
+    \note A regex is immutable once constructed and may be shared between threads.
+        The DFA and the scratch state sets belong to a GenericRegexSearch; Match()
+        and Search() of the regex itself match through a temporary one, so keep a
+        GenericRegexSearch per thread to reuse the DFA across calls.
 */
 template <typename Encoding, typename Allocator = CrtAllocator>
 class GenericRegex {
 public:
+    typedef Encoding EncodingType;
     typedef typename Encoding::Ch Ch;
+    template <typename, typename> friend class GenericRegexSearch;
 
     GenericRegex(const Ch* source, Allocator* allocator = 0) : 
         states_(allocator, 256), ranges_(allocator, 256), root_(kRegexInvalidState), stateCount_(), rangeCount_(), 
-        stateSet_(), state0_(allocator, 0), state1_(allocator, 0), anchorBegin_(), anchorEnd_()
+        prefix_(allocator, 0), required_(allocator, 0), classCount_(), anchorBegin_(), anchorEnd_()
     {
         GenericStringStream<Encoding> ss(source);
         DecodedStream<GenericStringStream<Encoding> > ds(ss);
         Parse(ds);
     }
 
-    ~GenericRegex() {
-        Allocator::Free(stateSet_);
-    }
-
     bool IsValid() const {
         return root_ != kRegexInvalidState;
     }
 
     template <typename InputStream>
     bool Match(InputStream& is) const {
-        return SearchWithAnchoring(is, true, true);
+        GenericRegexSearch<GenericRegex, CrtAllocator> search(*this);
+        return search.Match(is);
     }
 
     bool Match(const Ch* s) const {
@@ -115,7 +136,8 @@ public:
 
     template <typename InputStream>
     bool Search(InputStream& is) const {
-        return SearchWithAnchoring(is, anchorBegin_, anchorEnd_);
+        GenericRegexSearch<GenericRegex, CrtAllocator> search(*this);
+        return search.Search(is);
     }
 
     bool Search(const Ch* s) const {
@@ -123,6 +145,13 @@ public:
         return Search(is);
     }
 
+    //! Search with the literal prefilters applied to \c s[0, length) first.
+    bool Search(const Ch* s, SizeType length) const {
+        if (!MayContainMatch(s, length))
+            return false;
+        return Search(s);
+    }
+
 private:
     enum Operator {
         kZeroOrOne,
@@ -150,6 +179,12 @@ private:
         unsigned codepoint;
     };
 
+    struct LiteralStream {
+        LiteralStream(Stack<Allocator>& s) : stack(s) {}
+        void Put(Ch c) { *stack.template Push<Ch>() = c; }
+        Stack<Allocator>& stack;
+    };
+
     struct Frag {
         Frag(SizeType s, SizeType o, SizeType m) : start(s), out(o), minIndex(m) {}
         SizeType start;
@@ -300,7 +335,7 @@ private:
                 case '\\': // Escape character
                     if (!CharacterEscape(ds, &codepoint))
                         return; // Unsupported escape character
-                    // fall through to default
+                    // fall through - to default
 
                 default: // Pattern character
                     PushOperand(operandStack, codepoint);
@@ -328,13 +363,118 @@ private:
 #endif
         }
 
-        // Preallocate buffer for SearchWithAnchoring()
-        RAPIDJSON_ASSERT(stateSet_ == 0);
-        if (stateCount_ > 0) {
-            stateSet_ = static_cast<unsigned*>(states_.GetAllocator().Malloc(GetStateSetSize()));
-            state0_.template Reserve<SizeType>(stateCount_);
-            state1_.template Reserve<SizeType>(stateCount_);
+        if (stateCount_ > 0 && IsValid()) {
+            BuildClasses();
+            BuildLiterals();
+        }
+    }
+
+    //! Whether a consuming state accepts \c codepoint.
+    bool MatchState(const State& sr, unsigned codepoint) const {
+        return sr.codepoint == codepoint ||
+            sr.codepoint == kAnyCharacterClass || 
+            (sr.codepoint == kRangeCharacterClass && MatchRange(sr.rangeStart, codepoint));
+    }
+
+    //! Partitions ASCII into classes of codepoints that every state treats alike.
+    void BuildClasses() {
+        unsigned representative[kDfaAsciiSize];
+        classCount_ = 0;
+        for (unsigned c = 0; c < kDfaAsciiSize; c++) {
+            unsigned k = 0;
+            for (; k < classCount_; k++) {
+                SizeType i = 0;
+                for (; i < stateCount_; i++) {
+                    const State& sr = GetState(i);
+                    if (sr.out1 == kRegexInvalidState && sr.out != kRegexInvalidState &&
+                        MatchState(sr, c) != MatchState(sr, representative[k]))
+                        break;
+                }
+                if (i == stateCount_)
+                    break;
+            }
+            if (k == classCount_)
+                representative[classCount_++] = c;
+            classOf_[c] = static_cast<unsigned char>(k);
+        }
+    }
+
+    //! A state consuming exactly one fixed codepoint.
+    bool IsLiteralState(SizeType index) const {
+        const State& sr = GetState(index);
+        return sr.out1 == kRegexInvalidState && sr.out != kRegexInvalidState &&
+            sr.codepoint != kAnyCharacterClass && sr.codepoint != kRangeCharacterClass;
+    }
+
+    //! Whether every path from root_ to the matching state passes through \c index.
+    bool IsMandatoryState(SizeType index, uint32_t* visited, Stack<Allocator>& pending) const {
+        std::memset(visited, 0, GetStateSetSize());
+        pending.Clear();
+        *pending.template Push<SizeType>() = root_;
+        while (!pending.Empty()) {
+            SizeType i = *pending.template Pop<SizeType>(1);
+            if (i == kRegexInvalidState || i == index || (visited[i >> 5] & (1u << (i & 31))))
+                continue;
+            visited[i >> 5] |= 1u << (i & 31);
+            const State& sr = GetState(i);
+            if (sr.out == kRegexInvalidState)
+                return false; // reached the matching state
+            *pending.template Push<SizeType>() = sr.out;
+            *pending.template Push<SizeType>() = sr.out1;
+        }
+        return true;
+    }
+
+    //! Encodes the chain of literal states starting at \c index, returns its length.
+    SizeType AppendLiteralChain(SizeType index, Stack<Allocator>* literal) const {
+        SizeType length = 0;
+        for (; length < stateCount_ && IsLiteralState(index); length++) {
+            if (literal) {
+                LiteralStream os(*literal);
+                Encoding::Encode(os, GetState(index).codepoint);
+            }
+            index = GetState(index).out;
+        }
+        return length;
+    }
+
+    //! Collects the anchored literal prefix and the longest literal every match contains.
+    void BuildLiterals() {
+        AppendLiteralChain(root_, &prefix_);
+
+        Stack<Allocator> pending(&states_.GetAllocator(), 0);
+        Stack<Allocator> visitedSet(&states_.GetAllocator(), 0);
+        uint32_t* visited = visitedSet.template Push<uint32_t>(GetStateSetSize() / sizeof(uint32_t));
+        SizeType best = kRegexInvalidState, bestLength = 0;
+        for (SizeType i = 0; i < stateCount_; i++)
+            if (IsLiteralState(i)) {
+                SizeType length = AppendLiteralChain(i, 0);
+                if (length > bestLength && IsMandatoryState(i, visited, pending)) {
+                    best = i;
+                    bestLength = length;
+                }
+            }
+        if (best != kRegexInvalidState)
+            AppendLiteralChain(best, &required_);
+    }
+
+    //! Whether \c s[0, length) holds the literal prefix and the required literal (Search(s, length)).
+    bool MayContainMatch(const Ch* s, SizeType length) const {
+        if (anchorBegin_ && !prefix_.Empty()) {
+            const SizeType prefixLength = static_cast<SizeType>(prefix_.GetSize() / sizeof(Ch));
+            if (length < prefixLength || std::memcmp(s, prefix_.template Bottom<Ch>(), prefix_.GetSize()) != 0)
+                return false;
         }
+        return required_.Empty() || Contains(s, length, required_.template Bottom<Ch>(), static_cast<SizeType>(required_.GetSize() / sizeof(Ch)));
+    }
+
+    static bool Contains(const Ch* s, SizeType length, const Ch* literal, SizeType literalLength) {
+        if (literalLength > length)
+            return false;
+        for (const Ch* end = s + length - literalLength; s <= end; s++)
+            if (*s == *literal && std::memcmp(s, literal, sizeof(Ch) * literalLength) == 0)
+                return true;
+        return false;
     }
 
     SizeType NewState(SizeType out, SizeType out1, unsigned codepoint) {
@@ -534,7 +674,7 @@ private:
                 }
                 else if (!CharacterEscape(ds, &codepoint))
                     return false;
-                // fall through to default
+                // fall through - to default
 
             default:
                 switch (step) {
@@ -543,7 +683,7 @@ private:
                         step++;
                         break;
                     }
-                    // fall through to step 0 for other characters
+                    // fall through - to step 0 for other characters
 
                 case 0:
                     {
@@ -603,59 +743,43 @@ private:
         }
     }
 
-    template <typename InputStream>
-    bool SearchWithAnchoring(InputStream& is, bool anchorBegin, bool anchorEnd) const {
-        RAPIDJSON_ASSERT(IsValid());
-        DecodedStream<InputStream> ds(is);
-
-        state0_.Clear();
-        Stack<Allocator> *current = &state0_, *next = &state1_;
-        const size_t stateSetSize = GetStateSetSize();
-        std::memset(stateSet_, 0, stateSetSize);
-
-        bool matched = AddState(*current, root_);
-        unsigned codepoint;
-        while (!current->Empty() && (codepoint = ds.Take()) != 0) {
-            std::memset(stateSet_, 0, stateSetSize);
-            next->Clear();
-            matched = false;
-            for (const SizeType* s = current->template Bottom<SizeType>(); s != current->template End<SizeType>(); ++s) {
-                const State& sr = GetState(*s);
-                if (sr.codepoint == codepoint ||
-                    sr.codepoint == kAnyCharacterClass || 
-                    (sr.codepoint == kRangeCharacterClass && MatchRange(sr.rangeStart, codepoint)))
-                {
-                    matched = AddState(*next, sr.out) || matched;
-                    if (!anchorEnd && matched)
-                        return true;
-                }
-                if (!anchorBegin)
-                    AddState(*next, root_);
-            }
-            internal::Swap(current, next);
-        }
-
+    //! Advances the NFA state set \c current by \c codepoint into \c next, returns whether a match state was reached.
+    bool Step(const uint32_t* current, unsigned codepoint, bool anchorBegin, uint32_t* next) const {
+        const SizeType words = static_cast<SizeType>(GetStateSetSize() / sizeof(uint32_t));
+        std::memset(next, 0, GetStateSetSize());
+        bool matched = false;
+        for (SizeType w = 0; w < words; w++)
+            for (SizeType index = w * 32, bits = current[w]; bits != 0; bits >>= 1, index++)
+                if ((bits & 1) && MatchState(GetState(index), codepoint))
+                    matched = AddState(next, GetState(index).out) || matched;
+        if (!anchorBegin)
+            AddState(next, root_);
         return matched;
     }
 
+    bool IsEmptySet(const uint32_t* set) const {
+        for (size_t w = 0; w < GetStateSetSize() / sizeof(uint32_t); w++)
+            if (set[w])
+                return false;
+        return true;
+    }
+
     size_t GetStateSetSize() const {
         return (stateCount_ + 31) / 32 * 4;
     }
 
     // Return whether the added states is a match state
-    bool AddState(Stack<Allocator>& l, SizeType index) const {
+    bool AddState(uint32_t* set, SizeType index) const {
         RAPIDJSON_ASSERT(index != kRegexInvalidState);
 
         const State& s = GetState(index);
         if (s.out1 != kRegexInvalidState) { // Split
-            bool matched = AddState(l, s.out);
-            return AddState(l, s.out1) || matched;
-        }
-        else if (!(stateSet_[index >> 5] & (1 << (index & 31)))) {
-            stateSet_[index >> 5] |= (1 << (index & 31));
-            *l.template PushUnsafe<SizeType>() = index;
+            bool matched = AddState(set, s.out);
+            return AddState(set, s.out1) || matched;
         }
-        return s.out == kRegexInvalidState; // by using PushUnsafe() above, we can ensure s is not validated due to reallocation.
+        else
+            set[index >> 5] |= 1u << (index & 31);
+        return s.out == kRegexInvalidState;
     }
 
     bool MatchRange(SizeType rangeIndex, unsigned codepoint) const {
@@ -676,17 +800,179 @@ private:
     SizeType rangeCount_;
 
     static const unsigned kInfinityQuantifier = ~0u;
+    static const unsigned kDfaAsciiSize = 128;
+    static const SizeType kDfaMatchedFlag = 0x80000000u;
+
+    // Prefilters for Search(s, length)
+    Stack<Allocator> prefix_;   //!< Literal every anchored match starts with
+    Stack<Allocator> required_; //!< Literal every match contains
+    unsigned char classOf_[kDfaAsciiSize];
+    unsigned classCount_;
 
-    // For SearchWithAnchoring()
-    uint32_t* stateSet_;        // allocated by states_.GetAllocator()
-    mutable Stack<Allocator> state0_;
-    mutable Stack<Allocator> state1_;
     bool anchorBegin_;
     bool anchorEnd_;
 };
 
 typedef GenericRegex<UTF8<> > Regex;
 
+///////////////////////////////////////////////////////////////////////////////
+// GenericRegexSearch
+
+//! Matching state of a GenericRegex: the lazily built DFA and the scratch state sets.
+/*! The DFA grows with every search, so a search object must not be used by several
+    threads at once; the regex it refers to may be shared.
+    \tparam RegexType Type of the GenericRegex.
+    \tparam Allocator Allocator of the DFA and the scratch state sets.
+*/
+template <typename RegexType, typename Allocator = CrtAllocator>
+class GenericRegexSearch {
+public:
+    typedef typename RegexType::EncodingType Encoding;
+    typedef typename Encoding::Ch Ch;
+
+    GenericRegexSearch(const RegexType& regex, Allocator* allocator = 0) : 
+        regex_(regex), ownAllocator_(allocator ? 0 : RAPIDJSON_NEW(Allocator())), allocator_(allocator ? allocator : ownAllocator_),
+        stateSet_(static_cast<uint32_t*>(allocator_->Malloc(regex.GetStateSetSize() * 2))), anchoredDfa_(allocator_), unanchoredDfa_(allocator_)
+    {
+    }
+
+    ~GenericRegexSearch() {
+        Allocator::Free(stateSet_);
+        RAPIDJSON_DELETE(ownAllocator_);
+    }
+
+    template <typename InputStream>
+    bool Match(InputStream& is) {
+        return SearchWithAnchoring(is, true, true);
+    }
+
+    bool Match(const Ch* s) {
+        GenericStringStream<Encoding> is(s);
+        return Match(is);
+    }
+
+    template <typename InputStream>
+    bool Search(InputStream& is) {
+        return SearchWithAnchoring(is, regex_.anchorBegin_, regex_.anchorEnd_);
+    }
+
+    bool Search(const Ch* s) {
+        GenericStringStream<Encoding> is(s);
+        return Search(is);
+    }
+
+    //! Search with the literal prefilters applied to \c s[0, length) first.
+    bool Search(const Ch* s, SizeType length) {
+        if (!regex_.MayContainMatch(s, length))
+            return false;
+        return Search(s);
+    }
+
+private:
+    //! Lazily built DFA for one anchoring mode.
+    /*! DFA state 0 is the empty NFA state set, on which matching stops. */
+    struct DfaCache {
+        DfaCache(Allocator* allocator) : sets(allocator, 0), transitions(allocator, 0), count(), start(), startMatched() {}
+        Stack<Allocator> sets;          //!< count NFA state sets of GetStateSetSize() bytes
+        Stack<Allocator> transitions;   //!< count rows of classCount_ SizeType, kRegexInvalidState when not built yet
+        SizeType count;
+        SizeType start;
+        bool startMatched;
+    };
+
+    template <typename InputStream>
+    bool SearchWithAnchoring(InputStream& is, bool anchorBegin, bool anchorEnd) {
+        RAPIDJSON_ASSERT(regex_.IsValid());
+        typename RegexType::template DecodedStream<InputStream> ds(is);
+
+        DfaCache& dfa = anchorBegin ? anchoredDfa_ : unanchoredDfa_;
+        if (dfa.count == 0)
+            InitDfa(dfa);
+
+        SizeType state = dfa.start;
+        bool matched = dfa.startMatched;
+        unsigned codepoint;
+        while (state != 0 && (codepoint = ds.Take()) != 0) {
+            SizeType* transition = codepoint < RegexType::kDfaAsciiSize ? &GetTransition(dfa, state, regex_.classOf_[codepoint]) : 0;
+            if (transition && *transition != kRegexInvalidState) {
+                matched = (*transition & RegexType::kDfaMatchedFlag) != 0;
+                state = *transition & ~RegexType::kDfaMatchedFlag;
+            }
+            else {
+                uint32_t* next = stateSet_ + regex_.GetStateSetSize() / sizeof(uint32_t);
+                matched = regex_.Step(GetDfaSet(dfa, state), codepoint, anchorBegin, next);
+                SizeType target = AddDfaState(dfa, next);
+                if (target == kRegexInvalidState)
+                    return SearchNfa(ds, next, matched, anchorBegin, anchorEnd);
+                if (transition)
+                    GetTransition(dfa, state, regex_.classOf_[codepoint]) = target | (matched ? RegexType::kDfaMatchedFlag : 0);
+                state = target;
+            }
+            if (!anchorEnd && matched)
+                return true;
+        }
+
+        return matched;
+    }
+
+    //! Continues matching by NFA simulation once the DFA cache is full.
+    template <typename DecodedStream>
+    bool SearchNfa(DecodedStream& ds, uint32_t* current, bool matched, bool anchorBegin, bool anchorEnd) {
+        uint32_t* next = current == stateSet_ ? stateSet_ + regex_.GetStateSetSize() / sizeof(uint32_t) : stateSet_;
+        if (!anchorEnd && matched)
+            return true;
+        unsigned codepoint;
+        while (!regex_.IsEmptySet(current) && (codepoint = ds.Take()) != 0) {
+            matched = regex_.Step(current, codepoint, anchorBegin, next);
+            if (!anchorEnd && matched)
+                return true;
+            internal::Swap(current, next);
+        }
+        return matched;
+    }
+
+    void InitDfa(DfaCache& dfa) {
+        uint32_t* set = stateSet_;
+        std::memset(set, 0, regex_.GetStateSetSize());
+        AddDfaState(dfa, set); // dead state 0
+        dfa.startMatched = regex_.AddState(set, regex_.root_);
+        dfa.start = AddDfaState(dfa, set);
+        RAPIDJSON_ASSERT(dfa.start != kRegexInvalidState);
+    }
+
+    //! Returns the DFA state for \c set, creating it if there is room; kRegexInvalidState when the cache is full.
+    SizeType AddDfaState(DfaCache& dfa, const uint32_t* set) {
+        const size_t setSize = regex_.GetStateSetSize();
+        for (SizeType i = 0; i < dfa.count; i++)
+            if (std::memcmp(GetDfaSet(dfa, i), set, setSize) == 0)
+                return i;
+        if (dfa.count >= RAPIDJSON_REGEX_DFA_MAX_STATES)
+            return kRegexInvalidState;
+        std::memcpy(dfa.sets.template Push<uint32_t>(setSize / sizeof(uint32_t)), set, setSize);
+        SizeType* row = dfa.transitions.template Push<SizeType>(regex_.classCount_);
+        for (unsigned k = 0; k < regex_.classCount_; k++)
+            row[k] = kRegexInvalidState;
+        return dfa.count++;
+    }
+
+    const uint32_t* GetDfaSet(const DfaCache& dfa, SizeType state) const {
+        return dfa.sets.template Bottom<uint32_t>() + state * (regex_.GetStateSetSize() / sizeof(uint32_t));
+    }
+
+    SizeType& GetTransition(DfaCache& dfa, SizeType state, unsigned cls) {
+        return dfa.transitions.template Bottom<SizeType>()[state * regex_.classCount_ + cls];
+    }
+
+    const RegexType& regex_;
+    Allocator* ownAllocator_;
+    Allocator* allocator_;
+    uint32_t* stateSet_;        //!< two scratch sets
+    DfaCache anchoredDfa_;
+    DfaCache unanchoredDfa_;
+};
+
+typedef GenericRegexSearch<Regex> RegexSearch;
+
 } // namespace internal
 RAPIDJSON_NAMESPACE_END
 
@@ -33,6 +33,15 @@ inline SizeType StrLen(const Ch* s) {
     return SizeType(p - s);
 }
 
+//! FNV-1a hash of a string of \c length characters.
+template <typename Ch>
+inline uint32_t StrHash(const Ch* s, SizeType length) {
+    uint32_t h = 2166136261u;
+    for (SizeType i = 0; i < length; i++)
+        h = (h ^ static_cast<uint32_t>(s[i])) * 16777619u;
+    return h;
+}
+
 //! Returns number of code points in a encoded string.
 template<typename Encoding>
 bool CountStringCodePoint(const typename Encoding::Ch* s, SizeType length, SizeType* outCount) {
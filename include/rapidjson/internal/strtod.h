@@ -19,6 +19,8 @@
 #include "biginteger.h"
 #include "diyfp.h"
 #include "pow10.h"
+#include "pow5.h"
+#include <limits>
 
 RAPIDJSON_NAMESPACE_BEGIN
 namespace internal {
@@ -221,6 +223,112 @@ inline double StrtodBigInteger(double approx, const char* decimals, size_t lengt
         return a.NextPositiveDouble();
 }
 
+//! Full 64x64->128-bit multiplication, returning the low word and storing the high word.
+inline uint64_t StrtodMul128(uint64_t a, uint64_t b, uint64_t* high) {
+#if defined(_MSC_VER) && defined(_M_AMD64)
+    return _umul128(a, b, high);
+#elif defined(__GNUC__) && defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 uint128;
+    uint128 p = static_cast<uint128>(a) * static_cast<uint128>(b);
+    *high = static_cast<uint64_t>(p >> 64);
+    return static_cast<uint64_t>(p);
+#else
+    const uint64_t M32 = 0xFFFFFFFF;
+    const uint64_t a0 = a & M32, a1 = a >> 32, b0 = b & M32, b1 = b >> 32;
+    const uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+    const uint64_t mid = (p00 >> 32) + (p10 & M32) + (p01 & M32);
+    *high = p11 + (p10 >> 32) + (p01 >> 32) + (mid >> 32);
+    return (mid << 32) | (p00 & M32);
+#endif
+}
+
+//! Eisel-Lemire conversion of w * 10^q to the nearest double.
+/*! Correctly rounded for an exact decimal significand w. Returns false when the
+    128-bit approximation cannot decide the rounding, or the result would overflow,
+    in which case the caller must fall back to a slower algorithm.
+*/
+inline bool StrtodEiselLemire(uint64_t w, int q, double* result) {
+    if (w == 0 || q < -342) {
+        *result = 0.0;
+        return true;
+    }
+    if (q > 308)
+        return false;
+
+    // Normalize w so that its most significant bit is set
+    const DiyFp n = DiyFp(w, 0).Normalize();
+    const int lz = -n.e;
+    w = n.f;
+
+    // 55 bits of the product suffice unless the lower 9 bits of the high word are all ones
+    const uint64_t* pow5 = Pow5_128(q);
+    uint64_t hi;
+    uint64_t lo = StrtodMul128(w, pow5[0], &hi);
+    if ((hi & 0x1FF) == 0x1FF) {
+        uint64_t hi2;
+        StrtodMul128(w, pow5[1], &hi2);
+        lo += hi2;
+        if (hi2 > lo)
+            hi++;
+        // Product might still be off by one unit; 5^q is exact in 128 bits only for q in [-27, 55]
+        if (lo == ~uint64_t(0) && (q < -27 || q > 55))
+            return false;
+    }
+
+    const int upperbit = static_cast<int>(hi >> 63);
+    const int shift = upperbit + 9;
+    uint64_t mantissa = hi >> shift;
+    // floor(log2(10^q)) + 63 + upperbit - lz, biased by 1023
+    int power2 = (((152170 + 65536) * q) >> 16) + 63 + upperbit - lz + 1023;
+
+    if (power2 <= 0) { // Subnormal
+        if (-power2 + 1 >= 64) {
+            *result = 0.0;
+            return true;
+        }
+        mantissa >>= -power2 + 1;
+        mantissa += (mantissa & 1);
+        mantissa >>= 1;
+        power2 = (mantissa < (uint64_t(1) << 52)) ? 0 : 1;
+        *result = Double((static_cast<uint64_t>(power2) << 52) | (mantissa & ~(uint64_t(1) << 52))).Value();
+        return true;
+    }
+
+    // Exactly halfway between two doubles: only possible for small q, round to even
+    if (lo <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == hi)
+        mantissa &= ~uint64_t(1);
+
+    mantissa += (mantissa & 1);
+    mantissa >>= 1;
+    if (mantissa >= (uint64_t(2) << 52)) {
+        mantissa = uint64_t(1) << 52;
+        power2++;
+    }
+    if (power2 >= 0x7FF)
+        return false;
+
+    *result = Double((static_cast<uint64_t>(power2) << 52) | (mantissa & ~(uint64_t(1) << 52))).Value();
+    return true;
+}
+
+// Whether decimals[0, length), without trailing zeros and with integerDigits digits before the point,
+// rounds to infinity: is at least 2^1024 - 2^970, the midpoint between the largest double and 2^1024.
+inline bool StrtodOverflows(const char* decimals, size_t length, int integerDigits) {
+    static const char kThreshold[] =
+        "179769313486231580793728971405303415079934132710037826936173778980444968292764750946649017977587207"
+        "096330286416692887910946555547851940402630657488671505820681908902000708383676273854845817711531764"
+        "475730270069855571366959622842914819860834936475292719074168444365510704342711559699508093042880177"
+        "904174497792";
+    if (integerDigits != static_cast<int>(sizeof(kThreshold) - 1))
+        return integerDigits > static_cast<int>(sizeof(kThreshold) - 1);
+    for (size_t i = 0; i < sizeof(kThreshold) - 1; i++) {
+        const char digit = i < length ? decimals[i] : '0';
+        if (digit != kThreshold[i])
+            return digit > kThreshold[i];
+    }
+    return true;  // equal, or greater by the nonzero digits past the threshold's; ties round to even, 2^1024
+}
+
 inline double StrtodFullPrecision(double d, int p, const char* decimals, size_t length, size_t decimalPosition, int exp) {
     RAPIDJSON_ASSERT(d >= 0.0);
     RAPIDJSON_ASSERT(length >= 1);
@@ -243,6 +351,25 @@ inline double StrtodFullPrecision(double d, int p, const char* decimals, size_t
         exp++;
     }
 
+    // Eisel-Lemire on the leading 19 digits. When digits were dropped, the result is only
+    // accepted if rounding the truncated and the incremented significands agree.
+    {
+        const size_t n = length < 19 ? length : 19;
+        uint64_t w = 0;
+        for (size_t i = 0; i < n; i++)
+            w = w * 10 + static_cast<unsigned>(decimals[i] - '0');
+        const int q = static_cast<int>(decimalPosition) - static_cast<int>(n) + exp;
+        if (StrtodEiselLemire(w, q, &result)) {
+            double upper;
+            if (n == length || (StrtodEiselLemire(w + 1, q, &upper) && upper == result))
+                return result;
+        }
+    }
+
+    // Eisel-Lemire declines overflow; DiyFp and BigInteger cannot represent it
+    if (StrtodOverflows(decimals, length, static_cast<int>(decimalPosition) + exp))
+        return std::numeric_limits<double>::infinity();
+
     // Trim right-most digits
     const int kMaxDecimalDigit = 780;
     if (static_cast<int>(length) > kMaxDecimalDigit) {
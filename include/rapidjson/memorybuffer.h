@@ -59,6 +59,12 @@ struct GenericMemoryBuffer {
 
 typedef GenericMemoryBuffer<> MemoryBuffer;
 
+//! Implement specialized version of PutUnsafeN() with memcpy() for better performance.
+template<typename Allocator>
+inline void PutUnsafeN(GenericMemoryBuffer<Allocator>& memoryBuffer, const char* str, size_t n) {
+    std::memcpy(memoryBuffer.stack_.template Push<char>(n), str, n);
+}
+
 //! Implement specialized version of PutN() with memset() for better performance.
 template<>
 inline void PutN(MemoryBuffer& memoryBuffer, char c, size_t n) {
@@ -403,6 +403,8 @@ public:
         ValueType* v = &root;
         bool exist = true;
         for (const Token *t = tokens_; t != tokens_ + tokenCount_; ++t) {
+            if (v->IsPackedArray()) // elements of packed arrays are not values
+                v->UnpackArray(allocator);
             if (v->IsArray() && t->name[0] == '-' && t->length == 1) {
                 v->PushBack(ValueType().Move(), allocator);
                 v = &((*v)[v->Size() - 1]);
@@ -469,10 +471,12 @@ public:
         \return Pointer to the value if it can be resolved. Otherwise null.
 
         \note
-        There are only 3 situations when a value cannot be resolved:
+        There are only 4 situations when a value cannot be resolved:
         1. A value in the path is not an array nor object.
         2. An object value does not contain the token.
         3. A token is out of range of an array value.
+        4. A token indexes a packed array (\ref GenericValue::IsPackedArray()), whose elements are not values;
+           read them with GenericValue::ElementAt().
 
         Use unresolvedTokenIndex to retrieve the token index.
     */
@@ -490,8 +494,8 @@ public:
                 }
                 continue;
             case kArrayType:
-                if (t->index == kPointerInvalidIndex || t->index >= v->Size())
-                    break;
+                if (!v->IsArray() || t->index == kPointerInvalidIndex || t->index >= v->Size())
+                    break; // elements of packed arrays cannot be referenced
                 v = &((*v)[t->index]);
                 continue;
             default:
@@ -707,6 +711,7 @@ public:
         \return Whether the resolved value is found and erased.
 
         \note Erasing with an empty pointer \c Pointer(""), i.e. the root, always fail and return false.
+        \note An element of a packed array is erased in place (see GenericValue::ErasePacked()).
     */
     bool Erase(ValueType& root) const {
         RAPIDJSON_ASSERT(IsValid());
@@ -726,7 +731,7 @@ public:
                 }
                 break;
             case kArrayType:
-                if (t->index == kPointerInvalidIndex || t->index >= v->Size())
+                if (!v->IsArray() || t->index == kPointerInvalidIndex || t->index >= v->Size())
                     return false;
                 v = &((*v)[t->index]);
                 break;
@@ -741,7 +746,10 @@ public:
         case kArrayType:
             if (last->index == kPointerInvalidIndex || last->index >= v->Size())
                 return false;
-            v->Erase(v->Begin() + last->index);
+            if (v->IsPackedArray())
+                v->ErasePacked(static_cast<SizeType>(last->index));
+            else
+                v->Erase(v->Begin() + last->index);
             return true;
         default:
             return false;
@@ -324,27 +324,59 @@
 
 /*! \def RAPIDJSON_SIMD
     \ingroup RAPIDJSON_CONFIG
-    \brief Enable SSE2/SSE4.2 optimization.
+    \brief Enable SSE2/SSE4.2/AVX2/AVX-512 optimization.
 
     RapidJSON supports optimized implementations for some parsing operations
-    based on the SSE2 or SSE4.2 SIMD extensions on modern Intel-compatible
-    processors.
+    based on the SSE2, SSE4.2, AVX2 or AVX-512BW SIMD extensions on modern
+    Intel-compatible processors.
 
-    To enable these optimizations, two different symbols can be defined;
+    To enable these optimizations, four different symbols can be defined;
     \code
     // Enable SSE2 optimization.
     #define RAPIDJSON_SSE2
 
     // Enable SSE4.2 optimization.
     #define RAPIDJSON_SSE42
+
+    // Enable AVX2 optimization (32 bytes per iteration).
+    #define RAPIDJSON_AVX2
+
+    // Enable AVX-512BW optimization (64 bytes per iteration).
+    #define RAPIDJSON_AVX512
     \endcode
 
-    \c RAPIDJSON_SSE42 takes precedence, if both are defined.
+    \c RAPIDJSON_AVX512 takes precedence over \c RAPIDJSON_AVX2, which takes
+    precedence over \c RAPIDJSON_SSE42, which takes precedence over
+    \c RAPIDJSON_SSE2. \c RAPIDJSON_AVX2 and \c RAPIDJSON_AVX512 imply
+    \c RAPIDJSON_SSE42 for the code paths without a wider implementation.
+    The matching compiler switches (e.g. \c -mavx2, \c -mavx512bw) are required.
 
     If any of these symbols is defined, RapidJSON defines the macro
     \c RAPIDJSON_SIMD to indicate the availability of the optimized code.
 */
-#if defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SSE42) \
+#if (defined(RAPIDJSON_AVX2) || defined(RAPIDJSON_AVX512)) && !defined(RAPIDJSON_SSE42)
+#define RAPIDJSON_SSE42
+#endif
+
+/*! \def RAPIDJSON_SIMD_DISPATCH
+    \ingroup RAPIDJSON_CONFIG
+    \brief Select the SIMD kernels at run time.
+
+    With \c RAPIDJSON_SSE2 and friends, the binary requires the instruction set
+    it was compiled for. When \c RAPIDJSON_SIMD_DISPATCH is defined, the SSE2,
+    SSE4.2, AVX2 and AVX-512BW kernels are all compiled (with function target
+    attributes, no compiler switch is needed) and the best one supported by the
+    running CPU is selected through \c cpuid on first use. It takes precedence
+    over the compile-time symbols above and is ignored on non-x86 targets.
+
+    The active kernel set is reported by GetSimdKernel() in \c simd.h and can be
+    forced with SetSimdKernel().
+*/
+#if defined(RAPIDJSON_SIMD_DISPATCH) && !(defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+#undef RAPIDJSON_SIMD_DISPATCH
+#endif
+
+#if defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SSE42) || defined(RAPIDJSON_SIMD_DISPATCH) \
     || defined(RAPIDJSON_DOXYGEN_RUNNING)
 #define RAPIDJSON_SIMD
 #endif
@@ -560,6 +592,14 @@ RAPIDJSON_NAMESPACE_END
 #define RAPIDJSON_NOEXCEPT /* noexcept */
 #endif // RAPIDJSON_HAS_CXX11_NOEXCEPT
 
+#ifndef RAPIDJSON_HAS_CXX11_ATOMIC
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1700)
+#define RAPIDJSON_HAS_CXX11_ATOMIC 1
+#else
+#define RAPIDJSON_HAS_CXX11_ATOMIC 0
+#endif
+#endif // RAPIDJSON_HAS_CXX11_ATOMIC
+
 // no automatic detection, yet
 #ifndef RAPIDJSON_HAS_CXX11_TYPETRAITS
 #define RAPIDJSON_HAS_CXX11_TYPETRAITS 0
@@ -23,13 +23,16 @@
 #include "internal/meta.h"
 #include "internal/stack.h"
 #include "internal/strtod.h"
+#include "simd.h"
 #include <limits>
 
 #if defined(RAPIDJSON_SIMD) && defined(_MSC_VER)
 #include <intrin.h>
 #pragma intrinsic(_BitScanForward)
 #endif
-#ifdef RAPIDJSON_SSE42
+#if defined(RAPIDJSON_AVX2) || defined(RAPIDJSON_AVX512)
+#include <immintrin.h>
+#elif defined(RAPIDJSON_SSE42)
 #include <nmmintrin.h>
 #elif defined(RAPIDJSON_SSE2)
 #include <emmintrin.h>
@@ -153,6 +156,9 @@ enum ParseFlag {
     kParseNumbersAsStringsFlag = 64,    //!< Parse all numbers (ints/doubles) as strings.
     kParseTrailingCommasFlag = 128, //!< Allow trailing commas at the end of objects and arrays.
     kParseNanAndInfFlag = 256,      //!< Allow parsing NaN, Inf, Infinity, -Inf and -Infinity as doubles.
+    kParseInternKeysFlag = 512,     //!< Share the storage of identical object keys (GenericDocument with an allocator which does not need Free() only).
+    kParsePackedArraysFlag = 1024,  //!< Store non-empty arrays of only integers (int64) or only doubles as packed buffers (GenericDocument only, see GenericValue::IsPackedArray()).
+    kParsePredictKeysFlag = 2048,   //!< Match the key predicted by the handler (PredictKey()) before parsing it as a string. Recursive parsing of contiguous buffers only.
     kParseDefaultFlags = RAPIDJSON_PARSE_DEFAULT_FLAGS  //!< Default parse flags. Can be customized by defining RAPIDJSON_PARSE_DEFAULT_FLAGS
 };
 
@@ -182,6 +188,10 @@ concept Handler {
     bool EndObject(SizeType memberCount);
     bool StartArray();
     bool EndArray(SizeType elementCount);
+    /// enabled via kParsePredictKeysFlag: JSON text of the key expected next, from the opening quote through the colon (null for none)
+    const Ch* PredictKey(SizeType& length);
+    /// enabled via kParsePredictKeysFlag: the text of PredictKey() was found and consumed, in place of Key()
+    bool PredictedKey();
 };
 \endcode
 */
@@ -214,6 +224,8 @@ struct BaseReaderHandler {
     bool EndObject(SizeType) { return static_cast<Override&>(*this).Default(); }
     bool StartArray() { return static_cast<Override&>(*this).Default(); }
     bool EndArray(SizeType) { return static_cast<Override&>(*this).Default(); }
+    const Ch* PredictKey(SizeType&) { return 0; }
+    bool PredictedKey() { return static_cast<Override&>(*this).Default(); }
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -276,7 +288,144 @@ inline const char* SkipWhitespace(const char* p, const char* end) {
     return p;
 }
 
-#ifdef RAPIDJSON_SSE42
+#if defined(RAPIDJSON_SIMD_DISPATCH)
+//! Skip whitespace with the kernel set selected at run time.
+inline const char *SkipWhitespace_SIMD(const char* p) {
+    // Fast return for single non-whitespace
+    if (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')
+        ++p;
+    else
+        return p;
+
+    return internal::SimdDispatch<>::Table()->skipWhitespace(p);
+}
+
+inline const char *SkipWhitespace_SIMD(const char* p, const char* end) {
+    // Fast return for single non-whitespace
+    if (p != end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
+        ++p;
+    else
+        return p;
+
+    return internal::SimdDispatch<>::Table()->skipWhitespaceBounded(p, end);
+}
+
+#elif defined(RAPIDJSON_AVX2) || defined(RAPIDJSON_AVX512)
+namespace internal {
+
+// Building blocks shared by the AVX2 (32 bytes) and AVX-512BW (64 bytes) scanners.
+// Masks have one bit per byte, bit 0 being the byte at the lowest address.
+#ifdef RAPIDJSON_AVX512
+typedef __m512i SimdVector;
+typedef uint64_t SimdMask;
+static const size_t kSimdWidth = 64;
+
+RAPIDJSON_SIMD_BLOCK_READ inline SimdVector SimdLoad(const char* p) { return _mm512_load_si512(reinterpret_cast<const void*>(p)); }
+inline SimdVector SimdLoadu(const char* p) { return _mm512_loadu_si512(reinterpret_cast<const void*>(p)); }
+inline void SimdStoreu(char* p, SimdVector s) { _mm512_storeu_si512(reinterpret_cast<void*>(p), s); }
+
+//! Bytes which end an unescaped string run: '\"', '\\' and control characters (< 0x20).
+inline SimdMask SimdStringStopMask(SimdVector s) {
+    return _mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8('\"'))
+         | _mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8('\\'))
+         | _mm512_cmplt_epu8_mask(s, _mm512_set1_epi8(0x20));
+}
+
+//! Bytes which are not JSON whitespace.
+inline SimdMask SimdNonWhitespaceMask(SimdVector s) {
+    return ~(_mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8(' '))
+           | _mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8('\n'))
+           | _mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8('\r'))
+           | _mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8('\t')));
+}
+#else
+typedef __m256i SimdVector;
+typedef uint32_t SimdMask;
+static const size_t kSimdWidth = 32;
+
+RAPIDJSON_SIMD_BLOCK_READ inline SimdVector SimdLoad(const char* p) { return _mm256_load_si256(reinterpret_cast<const __m256i *>(p)); }
+inline SimdVector SimdLoadu(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+inline void SimdStoreu(char* p, SimdVector s) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), s); }
+
+//! Bytes which end an unescaped string run: '\"', '\\' and control characters (< 0x20).
+inline SimdMask SimdStringStopMask(SimdVector s) {
+    const __m256i sp = _mm256_set1_epi8(0x1F);
+    const __m256i t1 = _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\"'));
+    const __m256i t2 = _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\\'));
+    const __m256i t3 = _mm256_cmpeq_epi8(_mm256_max_epu8(s, sp), sp); // s < 0x20 <=> max(s, 0x1F) == 0x1F
+    return static_cast<SimdMask>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(t1, t2), t3)));
+}
+
+//! Bytes which are not JSON whitespace.
+inline SimdMask SimdNonWhitespaceMask(SimdVector s) {
+    __m256i x = _mm256_cmpeq_epi8(s, _mm256_set1_epi8(' '));
+    x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\n')));
+    x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\r')));
+    x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\t')));
+    return ~static_cast<SimdMask>(_mm256_movemask_epi8(x));
+}
+#endif
+
+//! Index of the lowest set bit. \pre mask != 0
+inline size_t SimdFirstBit(SimdMask mask) {
+#ifdef _MSC_VER
+    unsigned long offset;
+    _BitScanForward64(&offset, static_cast<uint64_t>(mask));
+    return offset;
+#else
+    return static_cast<size_t>(__builtin_ctzll(static_cast<unsigned long long>(mask)));
+#endif
+}
+
+//! Misalignment of \c p relative to kSimdWidth.
+/*! The first block of a zero-terminated string is loaded from the aligned address
+    below \c p, so it never crosses a page boundary; the bits of the bytes before
+    \c p are shifted out of the mask.
+*/
+inline size_t SimdMisalignment(const char* p) { return reinterpret_cast<size_t>(p) & (kSimdWidth - 1); }
+
+} // namespace internal
+
+//! Skip whitespace with AVX2/AVX-512BW instructions, testing 32/64 8-byte characters at once.
+inline const char *SkipWhitespace_SIMD(const char* p) {
+    // Fast return for single non-whitespace
+    if (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')
+        ++p;
+    else
+        return p;
+
+    // The first (partial) block, loaded from the aligned address below p
+    const size_t misalign = internal::SimdMisalignment(p);
+    internal::SimdMask r = internal::SimdNonWhitespaceMask(internal::SimdLoad(p - misalign)) >> misalign;
+    if (r != 0)
+        return p + internal::SimdFirstBit(r);
+
+    // The rest of string
+    for (p += internal::kSimdWidth - misalign;; p += internal::kSimdWidth) {
+        r = internal::SimdNonWhitespaceMask(internal::SimdLoad(p));
+        if (r != 0)   // some of characters is non-whitespace (the terminating zero at least)
+            return p + internal::SimdFirstBit(r);
+    }
+}
+
+inline const char *SkipWhitespace_SIMD(const char* p, const char* end) {
+    // Fast return for single non-whitespace
+    if (p != end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
+        ++p;
+    else
+        return p;
+
+    // The middle of string using SIMD, never reading past end
+    for (; end - p >= static_cast<ptrdiff_t>(internal::kSimdWidth); p += internal::kSimdWidth) {
+        const internal::SimdMask r = internal::SimdNonWhitespaceMask(internal::SimdLoadu(p));
+        if (r != 0)
+            return p + internal::SimdFirstBit(r);
+    }
+
+    return SkipWhitespace(p, end);
+}
+
+#elif defined(RAPIDJSON_SSE42)
 //! Skip whitespace with SSE 4.2 pcmpistrm instruction, testing 16 8-byte characters at once.
 inline const char *SkipWhitespace_SIMD(const char* p) {
     // Fast return for single non-whitespace
@@ -606,14 +755,19 @@ private:
             if (RAPIDJSON_UNLIKELY(is.Peek() != '"'))
                 RAPIDJSON_PARSE_ERROR(kParseErrorObjectMissName, is.Tell());
 
-            ParseString<parseFlags>(is, handler, true);
-            RAPIDJSON_PARSE_ERROR_EARLY_RETURN_VOID;
+            if (ParsePredictedKey(is, handler, internal::BoolType<(parseFlags & kParsePredictKeysFlag) != 0>())) {
+                RAPIDJSON_PARSE_ERROR_EARLY_RETURN_VOID;
+            }
+            else {
+                ParseString<parseFlags>(is, handler, true);
+                RAPIDJSON_PARSE_ERROR_EARLY_RETURN_VOID;
 
-            SkipWhitespaceAndComments<parseFlags>(is);
-            RAPIDJSON_PARSE_ERROR_EARLY_RETURN_VOID;
+                SkipWhitespaceAndComments<parseFlags>(is);
+                RAPIDJSON_PARSE_ERROR_EARLY_RETURN_VOID;
 
-            if (RAPIDJSON_UNLIKELY(!Consume(is, ':')))
-                RAPIDJSON_PARSE_ERROR(kParseErrorObjectMissColon, is.Tell());
+                if (RAPIDJSON_UNLIKELY(!Consume(is, ':')))
+                    RAPIDJSON_PARSE_ERROR(kParseErrorObjectMissColon, is.Tell());
+            }
 
             SkipWhitespaceAndComments<parseFlags>(is);
             RAPIDJSON_PARSE_ERROR_EARLY_RETURN_VOID;
@@ -909,7 +1063,134 @@ private:
             // Do nothing for generic version
     }
 
-#if defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SSE42)
+#if defined(RAPIDJSON_SIMD_DISPATCH)
+    // StringStream -> StackStream<char>
+    static RAPIDJSON_FORCEINLINE void ScanCopyUnescapedString(StringStream& is, StackStream<char>& os) {
+        const char* p = is.src_;
+        const char* q = internal::SimdDispatch<>::Table()->scanString(p);
+        const SizeType length = static_cast<SizeType>(q - p);
+        if (length != 0)
+            std::memcpy(os.Push(length), p, length);
+
+        is.src_ = q;
+    }
+
+    // InsituStringStream -> InsituStringStream
+    static RAPIDJSON_FORCEINLINE void ScanCopyUnescapedString(InsituStringStream& is, InsituStringStream& os) {
+        RAPIDJSON_ASSERT(&is == &os);
+        (void)os;
+
+        if (is.src_ == is.dst_) {
+            SkipUnescapedString(is);
+            return;
+        }
+
+        // dst_ is behind src_, so the overlapping move never clobbers unread input
+        char* p = is.src_;
+        char* q = const_cast<char*>(internal::SimdDispatch<>::Table()->scanString(p));
+        const size_t length = static_cast<size_t>(q - p);
+        std::memmove(is.dst_, p, length);
+
+        is.src_ = q;
+        is.dst_ += length;
+    }
+
+    // When read/write pointers are the same for insitu stream, just skip unescaped characters
+    static RAPIDJSON_FORCEINLINE void SkipUnescapedString(InsituStringStream& is) {
+        RAPIDJSON_ASSERT(is.src_ == is.dst_);
+        is.src_ = is.dst_ = const_cast<char*>(internal::SimdDispatch<>::Table()->scanString(is.src_));
+    }
+#elif defined(RAPIDJSON_AVX2) || defined(RAPIDJSON_AVX512)
+    // StringStream -> StackStream<char>
+    static RAPIDJSON_FORCEINLINE void ScanCopyUnescapedString(StringStream& is, StackStream<char>& os) {
+        const char* p = is.src_;
+
+        // The first (partial) block, loaded from the aligned address below p
+        const size_t misalign = internal::SimdMisalignment(p);
+        internal::SimdMask r = internal::SimdStringStopMask(internal::SimdLoad(p - misalign)) >> misalign;
+        size_t length = r != 0 ? internal::SimdFirstBit(r) : internal::kSimdWidth - misalign;
+        std::memcpy(os.Push(static_cast<SizeType>(length)), p, length);
+        p += length;
+
+        // The rest of string using SIMD
+        if (r == 0) {
+            for (;; p += internal::kSimdWidth) {
+                const internal::SimdVector s = internal::SimdLoad(p);
+                r = internal::SimdStringStopMask(s);
+                if (RAPIDJSON_UNLIKELY(r != 0)) {   // some of characters is escaped
+                    length = internal::SimdFirstBit(r);
+                    std::memcpy(os.Push(static_cast<SizeType>(length)), p, length);
+                    p += length;
+                    break;
+                }
+                internal::SimdStoreu(reinterpret_cast<char*>(os.Push(internal::kSimdWidth)), s);
+            }
+        }
+
+        is.src_ = p;
+    }
+
+    // InsituStringStream -> InsituStringStream
+    static RAPIDJSON_FORCEINLINE void ScanCopyUnescapedString(InsituStringStream& is, InsituStringStream& os) {
+        RAPIDJSON_ASSERT(&is == &os);
+        (void)os;
+
+        if (is.src_ == is.dst_) {
+            SkipUnescapedString(is);
+            return;
+        }
+
+        char* p = is.src_;
+        char *q = is.dst_;
+
+        // The first (partial) block, loaded from the aligned address below p
+        const size_t misalign = internal::SimdMisalignment(p);
+        internal::SimdMask r = internal::SimdStringStopMask(internal::SimdLoad(p - misalign)) >> misalign;
+        for (const char* pend = p + (r != 0 ? internal::SimdFirstBit(r) : internal::kSimdWidth - misalign); p != pend; )
+            *q++ = *p++;
+
+        // The rest of string using SIMD; q is behind p, so stores never clobber unread input
+        if (r == 0) {
+            for (;; p += internal::kSimdWidth, q += internal::kSimdWidth) {
+                const internal::SimdVector s = internal::SimdLoad(p);
+                r = internal::SimdStringStopMask(s);
+                if (RAPIDJSON_UNLIKELY(r != 0)) {   // some of characters is escaped
+                    for (const char* pend = p + internal::SimdFirstBit(r); p != pend; )
+                        *q++ = *p++;
+                    break;
+                }
+                internal::SimdStoreu(q, s);
+            }
+        }
+
+        is.src_ = p;
+        is.dst_ = q;
+    }
+
+    // When read/write pointers are the same for insitu stream, just skip unescaped characters
+    static RAPIDJSON_FORCEINLINE void SkipUnescapedString(InsituStringStream& is) {
+        RAPIDJSON_ASSERT(is.src_ == is.dst_);
+        char* p = is.src_;
+
+        // The first (partial) block, loaded from the aligned address below p
+        const size_t misalign = internal::SimdMisalignment(p);
+        internal::SimdMask r = internal::SimdStringStopMask(internal::SimdLoad(p - misalign)) >> misalign;
+        if (r != 0)
+            p += internal::SimdFirstBit(r);
+        else {
+            // The rest of string using SIMD
+            for (p += internal::kSimdWidth - misalign;; p += internal::kSimdWidth) {
+                r = internal::SimdStringStopMask(internal::SimdLoad(p));
+                if (RAPIDJSON_UNLIKELY(r != 0)) {   // some of characters is escaped
+                    p += internal::SimdFirstBit(r);
+                    break;
+                }
+            }
+        }
+
+        is.src_ = is.dst_ = p;
+    }
+#elif defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SSE42)
     // StringStream -> StackStream<char>
     static RAPIDJSON_FORCEINLINE void ScanCopyUnescapedString(StringStream& is, StackStream<char>& os) {
         const char* p = is.src_;
@@ -927,7 +1208,7 @@ private:
         // The rest of string using SIMD
         static const char dquote[16] = { '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"' };
         static const char bslash[16] = { '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\' };
-        static const char space[16]  = { 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19 };
+        static const char space[16]  = { 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F };
         const __m128i dq = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&dquote[0]));
         const __m128i bs = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&bslash[0]));
         const __m128i sp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&space[0]));
@@ -936,7 +1217,7 @@ private:
             const __m128i s = _mm_load_si128(reinterpret_cast<const __m128i *>(p));
             const __m128i t1 = _mm_cmpeq_epi8(s, dq);
             const __m128i t2 = _mm_cmpeq_epi8(s, bs);
-            const __m128i t3 = _mm_cmpeq_epi8(_mm_max_epu8(s, sp), sp); // s < 0x20 <=> max(s, 0x19) == 0x19
+            const __m128i t3 = _mm_cmpeq_epi8(_mm_max_epu8(s, sp), sp); // s < 0x20 <=> max(s, 0x1F) == 0x1F
             const __m128i x = _mm_or_si128(_mm_or_si128(t1, t2), t3);
             unsigned short r = static_cast<unsigned short>(_mm_movemask_epi8(x));
             if (RAPIDJSON_UNLIKELY(r != 0)) {   // some of characters is escaped
@@ -988,7 +1269,7 @@ private:
         // The rest of string using SIMD
         static const char dquote[16] = { '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"' };
         static const char bslash[16] = { '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\' };
-        static const char space[16] = { 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19 };
+        static const char space[16] = { 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F };
         const __m128i dq = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&dquote[0]));
         const __m128i bs = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&bslash[0]));
         const __m128i sp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&space[0]));
@@ -997,7 +1278,7 @@ private:
             const __m128i s = _mm_load_si128(reinterpret_cast<const __m128i *>(p));
             const __m128i t1 = _mm_cmpeq_epi8(s, dq);
             const __m128i t2 = _mm_cmpeq_epi8(s, bs);
-            const __m128i t3 = _mm_cmpeq_epi8(_mm_max_epu8(s, sp), sp); // s < 0x20 <=> max(s, 0x19) == 0x19
+            const __m128i t3 = _mm_cmpeq_epi8(_mm_max_epu8(s, sp), sp); // s < 0x20 <=> max(s, 0x1F) == 0x1F
             const __m128i x = _mm_or_si128(_mm_or_si128(t1, t2), t3);
             unsigned short r = static_cast<unsigned short>(_mm_movemask_epi8(x));
             if (RAPIDJSON_UNLIKELY(r != 0)) {   // some of characters is escaped
@@ -1036,7 +1317,7 @@ private:
         // The rest of string using SIMD
         static const char dquote[16] = { '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"' };
         static const char bslash[16] = { '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\' };
-        static const char space[16] = { 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19 };
+        static const char space[16] = { 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F };
         const __m128i dq = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&dquote[0]));
         const __m128i bs = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&bslash[0]));
         const __m128i sp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&space[0]));
@@ -1045,7 +1326,7 @@ private:
             const __m128i s = _mm_load_si128(reinterpret_cast<const __m128i *>(p));
             const __m128i t1 = _mm_cmpeq_epi8(s, dq);
             const __m128i t2 = _mm_cmpeq_epi8(s, bs);
-            const __m128i t3 = _mm_cmpeq_epi8(_mm_max_epu8(s, sp), sp); // s < 0x20 <=> max(s, 0x19) == 0x19
+            const __m128i t3 = _mm_cmpeq_epi8(_mm_max_epu8(s, sp), sp); // s < 0x20 <=> max(s, 0x1F) == 0x1F
             const __m128i x = _mm_or_si128(_mm_or_si128(t1, t2), t3);
             unsigned short r = static_cast<unsigned short>(_mm_movemask_epi8(x));
             if (RAPIDJSON_UNLIKELY(r != 0)) {   // some of characters is escaped
@@ -1066,6 +1347,108 @@ private:
     }
 #endif
 
+    // Takes up to 8 leading digits at once into acc from streams with a contiguous buffer.
+    // Returns the number of digits taken; the generic version takes none.
+    template<typename InputStream>
+    static RAPIDJSON_FORCEINLINE unsigned TakeDigits(InputStream&, uint64_t*) {
+        return 0;
+    }
+
+#if RAPIDJSON_ENDIAN == RAPIDJSON_LITTLEENDIAN
+    // Zero-terminated buffers: the load must not cross into the next page, which may be unmapped;
+    // the digit run ends at the terminator at the latest.
+    static RAPIDJSON_FORCEINLINE unsigned TakeDigits(StringStream& is, uint64_t* acc) {
+        if (!internal::SwarLoadable8(is.src_))
+            return 0;
+        const unsigned n = internal::SwarTakeDigits8(internal::SwarLoad8Terminated(is.src_), acc);
+        is.src_ += n;
+        return n;
+    }
+
+    static RAPIDJSON_FORCEINLINE unsigned TakeDigits(InsituStringStream& is, uint64_t* acc) {
+        if (!internal::SwarLoadable8(is.src_))
+            return 0;
+        const unsigned n = internal::SwarTakeDigits8(internal::SwarLoad8Terminated(is.src_), acc);
+        is.src_ += n;
+        return n;
+    }
+
+    // Length-bounded buffers: while 8 bytes remain
+    static RAPIDJSON_FORCEINLINE unsigned TakeDigits(MemoryStream& is, uint64_t* acc) {
+        if (is.end_ - is.src_ < 8)
+            return 0;
+        const unsigned n = internal::SwarTakeDigits8(internal::SwarLoad8(is.src_), acc);
+        is.src_ += n;
+        return n;
+    }
+
+    static RAPIDJSON_FORCEINLINE unsigned TakeDigits(EncodedInputStream<UTF8<>, MemoryStream>& is, uint64_t* acc) {
+        return TakeDigits(is.is_, acc);
+    }
+#endif
+
+    // Key of an object member predicted by the handler (kParsePredictKeysFlag): true when its text was
+    // consumed and reported through PredictedKey(), false to parse the key as a string.
+    template<typename InputStream, typename Handler>
+    RAPIDJSON_FORCEINLINE bool ParsePredictedKey(InputStream&, Handler&, internal::FalseType) {
+        return false;
+    }
+
+    template<typename InputStream, typename Handler>
+    RAPIDJSON_FORCEINLINE bool ParsePredictedKey(InputStream& is, Handler& handler, internal::TrueType) {
+        if (!TakePredictedKey(is, handler))
+            return false;
+        if (RAPIDJSON_UNLIKELY(!handler.PredictedKey()))
+            RAPIDJSON_PARSE_ERROR_NORETURN(kParseErrorTermination, is.Tell());
+        return true;
+    }
+
+    // Consumes the predicted key text with a single comparison. Only streams with a contiguous
+    // buffer take part; the generic version matches nothing.
+    template<typename InputStream, typename Handler>
+    static RAPIDJSON_FORCEINLINE bool TakePredictedKey(InputStream&, Handler&) {
+        return false;
+    }
+
+    // Zero-terminated buffers: compared byte by byte up to the first mismatch. The predicted text
+    // holds no NUL, so the terminator mismatches and nothing past it is read.
+    static RAPIDJSON_FORCEINLINE bool MatchPredictedKey(const char* src, const char* key, SizeType length) {
+        for (SizeType i = 0; i < length; i++)
+            if (src[i] != key[i])
+                return false;
+        return true;
+    }
+
+    template<typename Handler>
+    static RAPIDJSON_FORCEINLINE bool TakePredictedKey(StringStream& is, Handler& handler) {
+        SizeType length = 0;
+        const char* key = handler.PredictKey(length);
+        if (!key || !MatchPredictedKey(is.src_, key, length))
+            return false;
+        is.src_ += length;
+        return true;
+    }
+
+    template<typename Handler>
+    static RAPIDJSON_FORCEINLINE bool TakePredictedKey(InsituStringStream& is, Handler& handler) {
+        SizeType length = 0;
+        const char* key = handler.PredictKey(length);
+        if (!key || !MatchPredictedKey(is.src_, key, length))
+            return false;
+        is.src_ += length;
+        return true;
+    }
+
+    template<typename Handler>
+    static RAPIDJSON_FORCEINLINE bool TakePredictedKey(MemoryStream& is, Handler& handler) {
+        SizeType length = 0;
+        const char* key = handler.PredictKey(length);
+        if (!key || static_cast<size_t>(is.end_ - is.src_) < length || std::memcmp(is.src_, key, length) != 0)
+            return false;
+        is.src_ += length;
+        return true;
+    }
+
     template<typename InputStream, bool backup, bool pushOnTake>
     class NumberStream;
 
@@ -1081,6 +1464,7 @@ private:
         RAPIDJSON_FORCEINLINE Ch TakePush() { return is.Take(); }
         RAPIDJSON_FORCEINLINE Ch Take() { return is.Take(); }
 		  RAPIDJSON_FORCEINLINE void Push(char) {}
+        RAPIDJSON_FORCEINLINE unsigned TakeDigits(uint64_t* acc) { return GenericReader::TakeDigits(is, acc); }
 
         size_t Tell() { return is.Tell(); }
         size_t Length() { return 0; }
@@ -1108,6 +1492,9 @@ private:
             stackStream.Put(c);
         }
 
+        // Backed up digits are pushed one by one
+        RAPIDJSON_FORCEINLINE unsigned TakeDigits(uint64_t*) { return 0; }
+
         size_t Length() { return stackStream.Length(); }
 
         const char* Pop() {
@@ -1158,6 +1545,11 @@ private:
         else if (RAPIDJSON_LIKELY(s.Peek() >= '1' && s.Peek() <= '9')) {
             i = static_cast<unsigned>(s.TakePush() - '0');
 
+            // At most 9 digits so far, below both 2^31 and 2^32
+            uint64_t i9 = i;
+            significandDigit += static_cast<int>(s.TakeDigits(&i9));
+            i = static_cast<unsigned>(i9);
+
             if (minus)
                 while (RAPIDJSON_LIKELY(s.Peek() >= '0' && s.Peek() <= '9')) {
                     if (RAPIDJSON_UNLIKELY(i >= 214748364)) { // 2^31 = 2147483648
@@ -1204,6 +1596,8 @@ private:
         // Parse 64bit int
         bool useDouble = false;
         if (use64bit) {
+            // At most 18 digits so far, below 2^63
+            significandDigit += static_cast<int>(s.TakeDigits(&i64));
             if (minus)
                 while (RAPIDJSON_LIKELY(s.Peek() >= '0' && s.Peek() <= '9')) {
                      if (RAPIDJSON_UNLIKELY(i64 >= RAPIDJSON_UINT64_C2(0x0CCCCCCC, 0xCCCCCCCC))) // 2^63 = 9223372036854775808
@@ -1252,6 +1646,20 @@ private:
                 if (!use64bit)
                     i64 = i;
 
+                // Take 8 digits at a time while every prefix stays below the fast path limit
+                while (i64 <= 90071991) { // (2^53 - 1 - 99999999) / 10^8
+                    const uint64_t prev = i64;
+                    const unsigned n = s.TakeDigits(&i64);
+                    expFrac -= static_cast<int>(n);
+                    if (prev != 0)
+                        significandDigit += static_cast<int>(n);
+                    else // leading zeros are not significant
+                        for (uint64_t t = i64; t != 0; t /= 10)
+                            significandDigit++;
+                    if (n < 8)
+                        break;
+                }
+
                 while (RAPIDJSON_LIKELY(s.Peek() >= '0' && s.Peek() <= '9')) {
                     if (i64 > RAPIDJSON_UINT64_C2(0x1FFFFF, 0xFFFFFFFF)) // 2^53 - 1 for fast path
                         break;
@@ -1363,6 +1771,10 @@ private:
                else
                    d = internal::StrtodNormalPrecision(d, p);
 
+               // Use > max, instead of == inf, to avoid -Wfloat-equal
+               if (RAPIDJSON_UNLIKELY(d > (std::numeric_limits<double>::max)()))
+                   RAPIDJSON_PARSE_ERROR(kParseErrorNumberTooBig, startOffset);
+
                cont = handler.Double(minus ? -d : d);
            }
            else if (useNanOrInf) {
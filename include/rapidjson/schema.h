@@ -17,6 +17,7 @@
 
 #include "document.h"
 #include "pointer.h"
+#include "internal/hash.h"
 #include <cmath> // abs, floor
 
 #if !defined(RAPIDJSON_SCHEMA_USE_INTERNALREGEX)
@@ -155,6 +156,9 @@ public:
     virtual void DestroryHasher(void* hasher) = 0;
     virtual void* MallocState(size_t size) = 0;
     virtual void FreeState(void* p) = 0;
+#if RAPIDJSON_SCHEMA_USE_INTERNALREGEX
+    virtual bool IsPatternMatch(const typename SchemaType::RegexType* pattern, const typename SchemaType::Ch* str, SizeType length) = 0;
+#endif
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -195,20 +199,20 @@ public:
     bool StartObject() { return true; }
     bool Key(const Ch* str, SizeType len, bool copy) { return String(str, len, copy); }
     bool EndObject(SizeType memberCount) { 
-        uint64_t h = Hash(0, kObjectType);
+        uint64_t h = HashCombine(0, kObjectType);
         uint64_t* kv = stack_.template Pop<uint64_t>(memberCount * 2);
         for (SizeType i = 0; i < memberCount; i++)
-            h ^= Hash(kv[i * 2], kv[i * 2 + 1]);  // Use xor to achieve member order insensitive
+            h += HashCombine(kv[i * 2], kv[i * 2 + 1]);  // Use addition to achieve member order insensitive
         *stack_.template Push<uint64_t>() = h;
         return true;
     }
     
     bool StartArray() { return true; }
     bool EndArray(SizeType elementCount) { 
-        uint64_t h = Hash(0, kArrayType);
+        uint64_t h = HashCombine(0, kArrayType);
         uint64_t* e = stack_.template Pop<uint64_t>(elementCount);
         for (SizeType i = 0; i < elementCount; i++)
-            h = Hash(h, e[i]); // Use hash to achieve element order sensitive
+            h = HashCombine(h, e[i]); // Use hash to achieve element order sensitive
         *stack_.template Push<uint64_t>() = h;
         return true;
     }
@@ -220,6 +224,9 @@ public:
         return *stack_.template Top<uint64_t>();
     }
 
+    //! Clears the hash stack, keeping its capacity.
+    void Reset() { stack_.Clear(); }
+
 private:
     static const size_t kDefaultSize = 256;
     struct Number {
@@ -235,22 +242,10 @@ private:
     bool WriteNumber(const Number& n) { return WriteBuffer(kNumberType, &n, sizeof(n)); }
     
     bool WriteBuffer(Type type, const void* data, size_t len) {
-        // FNV-1a from http://isthe.com/chongo/tech/comp/fnv/
-        uint64_t h = Hash(RAPIDJSON_UINT64_C2(0x84222325, 0xcbf29ce4), type);
-        const unsigned char* d = static_cast<const unsigned char*>(data);
-        for (size_t i = 0; i < len; i++)
-            h = Hash(h, d[i]);
-        *stack_.template Push<uint64_t>() = h;
+        *stack_.template Push<uint64_t>() = HashBytes(data, len, type);
         return true;
     }
 
-    static uint64_t Hash(uint64_t h, uint64_t d) {
-        static const uint64_t kPrime = RAPIDJSON_UINT64_C2(0x00000100, 0x000001b3);
-        h ^= d;
-        h *= kPrime;
-        return h;
-    }
-
     Stack<Allocator> stack_;
 };
 
@@ -345,16 +340,27 @@ public:
     typedef SchemaValidationContext<SchemaDocumentType> Context;
     typedef Schema<SchemaDocumentType> SchemaType;
     typedef GenericValue<EncodingType, AllocatorType> SValue;
+#if RAPIDJSON_SCHEMA_USE_INTERNALREGEX
+    typedef internal::GenericRegex<EncodingType> RegexType;
+#elif RAPIDJSON_SCHEMA_USE_STDREGEX
+    typedef std::basic_regex<Ch> RegexType;
+#else
+    typedef char RegexType;
+#endif
     friend class GenericSchemaDocument<ValueType, AllocatorType>;
 
     Schema(SchemaDocumentType* schemaDocument, const PointerType& p, const ValueType& value, const ValueType& document, AllocatorType* allocator) :
         allocator_(allocator),
         enum_(),
         enumCount_(),
+        enumTable_(),
+        enumTableMask_(),
         not_(),
         type_((1 << kTotalSchemaType) - 1), // typeless
         validatorCount_(),
         properties_(),
+        propertyTable_(),
+        propertyTableMask_(),
         additionalPropertiesSchema_(),
         patternProperties_(),
         patternPropertyCount_(),
@@ -395,17 +401,21 @@ public:
                     AddType(*itr);
         }
 
+        // Schema documents parsed with kParsePackedArraysFlag hold numeric enums as packed arrays
         if (const ValueType* v = GetMember(value, GetEnumString()))
-            if (v->IsArray() && v->Size() > 0) {
+            if (v->GetType() == kArrayType && v->Size() > 0) {
+                enumValues_.CopyFrom(*v, *allocator_);
                 enum_ = static_cast<uint64_t*>(allocator_->Malloc(sizeof(uint64_t) * v->Size()));
-                for (ConstValueIterator itr = v->Begin(); itr != v->End(); ++itr) {
+                for (SizeType i = 0; i < v->Size(); i++) {
                     typedef Hasher<EncodingType, MemoryPoolAllocator<> > EnumHasherType;
                     char buffer[256 + 24];
                     MemoryPoolAllocator<> hasherAllocator(buffer, sizeof(buffer));
                     EnumHasherType h(&hasherAllocator, 256);
-                    itr->Accept(h);
+                    ValueType element;
+                    v->ElementAt(i, element).Accept(h);
                     enum_[enumCount_++] = h.GetHashCode();
                 }
+                BuildEnumTable();
             }
 
         if (schemaDocument) {
@@ -455,6 +465,7 @@ public:
                     properties_[i].name = allProperties[i];
                     properties_[i].schema = GetTypeless();
                 }
+                BuildPropertyTable();
             }
         }
 
@@ -577,6 +588,8 @@ public:
     ~Schema() {
         if (allocator_) {
             allocator_->Free(enum_);
+            allocator_->Free(enumTable_);
+            allocator_->Free(propertyTable_);
         }
         if (properties_) {
             for (SizeType i = 0; i < propertyCount_; i++)
@@ -650,11 +663,8 @@ public:
 
         if (enum_) {
             const uint64_t h = context.factory.GetHashCode(context.hasher);
-            for (SizeType i = 0; i < enumCount_; i++)
-                if (enum_[i] == h)
-                    goto foundEnum;
-            RAPIDJSON_INVALID_KEYWORD_RETURN(GetEnumString());
-            foundEnum:;
+            if (!FindEnum(h))
+                RAPIDJSON_INVALID_KEYWORD_RETURN(GetEnumString());
         }
 
         if (allOf_.schemas)
@@ -755,7 +765,7 @@ public:
             }
         }
 
-        if (pattern_ && !IsPatternMatch(pattern_, str, length))
+        if (pattern_ && !IsPatternMatch(context, pattern_, str, length))
             RAPIDJSON_INVALID_KEYWORD_RETURN(GetPatternString());
 
         return CreateParallelValidator(context);
@@ -784,7 +794,7 @@ public:
         if (patternProperties_) {
             context.patternPropertiesSchemaCount = 0;
             for (SizeType i = 0; i < patternPropertyCount_; i++)
-                if (patternProperties_[i].pattern && IsPatternMatch(patternProperties_[i].pattern, str, len))
+                if (patternProperties_[i].pattern && IsPatternMatch(context, patternProperties_[i].pattern, str, len))
                     context.patternPropertiesSchemas[context.patternPropertiesSchemaCount++] = patternProperties_[i].schema;
         }
 
@@ -921,7 +931,6 @@ public:
 
 #undef RAPIDJSON_STRING_
 
-private:
     enum SchemaValueType {
         kNullSchemaType,
         kBooleanSchemaType,
@@ -933,13 +942,56 @@ private:
         kTotalSchemaType
     };
 
-#if RAPIDJSON_SCHEMA_USE_INTERNALREGEX
-        typedef internal::GenericRegex<EncodingType> RegexType;
-#elif RAPIDJSON_SCHEMA_USE_STDREGEX
-        typedef std::basic_regex<Ch> RegexType;
-#else
-        typedef char RegexType;
-#endif
+    //! \name Compiled keywords
+    //! Read-only view for tools generating code from a schema. \c $ref is already resolved.
+    //@{
+    //! Whether "type" admits \c type ("number" admits kIntegerSchemaType as well).
+    bool AllowsType(SchemaValueType type) const { return (type_ & (1u << type)) != 0; }
+    //! Whether the schema has no "type" keyword.
+    bool IsTypeless() const { return type_ == (1u << kTotalSchemaType) - 1; }
+    //! Number of properties named by "properties", "required" and "dependencies".
+    SizeType GetPropertyCount() const { return propertyCount_; }
+    const SValue& GetPropertyName(SizeType index) const { return properties_[index].name; }
+    const SchemaType* GetPropertySchema(SizeType index) const { return properties_[index].schema; }
+    bool IsPropertyRequired(SizeType index) const { return properties_[index].required; }
+    //! False for "additionalProperties": false.
+    bool AllowsAdditionalProperties() const { return additionalProperties_; }
+    //! Schema of "items" when it is a single schema, null otherwise.
+    const SchemaType* GetItemsSchema() const { return itemsList_; }
+    //! "enum" as an array, null when absent.
+    const SValue& GetEnum() const { return enumValues_; }
+    //! "minimum" and "maximum", null when absent.
+    const SValue& GetMinimum() const { return minimum_; }
+    const SValue& GetMaximum() const { return maximum_; }
+    bool IsExclusiveMinimum() const { return exclusiveMinimum_; }
+    bool IsExclusiveMaximum() const { return exclusiveMaximum_; }
+    //! "multipleOf", null when absent.
+    const SValue& GetMultipleOf() const { return multipleOf_; }
+    //! "minLength" and "maxLength" in code points, 0 and ~0 when absent.
+    SizeType GetMinLength() const { return minLength_; }
+    SizeType GetMaxLength() const { return maxLength_; }
+    //! "minItems" and "maxItems", 0 and ~0 when absent.
+    SizeType GetMinItems() const { return minItems_; }
+    SizeType GetMaxItems() const { return maxItems_; }
+    //! Name of a compiled keyword this view does not expose, null if there is none.
+    const char* GetUnexposedKeyword() const {
+        if (allOf_.schemas) return "allOf";
+        if (anyOf_.schemas) return "anyOf";
+        if (oneOf_.schemas) return "oneOf";
+        if (not_) return "not";
+        if (hasDependencies_) return "dependencies";
+        if (patternProperties_) return "patternProperties";
+        if (additionalPropertiesSchema_) return "additionalProperties";
+        if (minProperties_ != 0) return "minProperties";
+        if (maxProperties_ != SizeType(~0)) return "maxProperties";
+        if (itemsTuple_) return "items";
+        if (uniqueItems_) return "uniqueItems";
+        if (pattern_) return "pattern";
+        return 0;
+    }
+    //@}
+
+private:
 
     struct SchemaArray {
         SchemaArray() : schemas(), count() {}
@@ -1010,8 +1062,9 @@ private:
         return 0;
     }
 
-    static bool IsPatternMatch(const RegexType* pattern, const Ch *str, SizeType) {
-        return pattern->Search(str);
+    // The regex is shared by every validator of the document, the search state (DFA) belongs to the validator
+    static bool IsPatternMatch(Context& context, const RegexType* pattern, const Ch *str, SizeType length) {
+        return context.factory.IsPatternMatch(pattern, str, length);
     }
 #elif RAPIDJSON_SCHEMA_USE_STDREGEX
     template <typename ValueType>
@@ -1025,7 +1078,7 @@ private:
         return 0;
     }
 
-    static bool IsPatternMatch(const RegexType* pattern, const Ch *str, SizeType length) {
+    static bool IsPatternMatch(Context&, const RegexType* pattern, const Ch *str, SizeType length) {
         std::match_results<const Ch*> r;
         return std::regex_search(str, str + length, r, *pattern);
     }
@@ -1033,7 +1086,7 @@ private:
     template <typename ValueType>
     RegexType* CreatePattern(const ValueType&) { return 0; }
 
-    static bool IsPatternMatch(const RegexType*, const Ch *, SizeType) { return true; }
+    static bool IsPatternMatch(Context&, const RegexType*, const Ch *, SizeType) { return true; }
 #endif // RAPIDJSON_SCHEMA_USE_STDREGEX
 
     void AddType(const ValueType& type) {
@@ -1082,17 +1135,69 @@ private:
             context.validators[schemas.begin + i] = context.factory.CreateSchemaValidator(*schemas.schemas[i]);
     }
 
-    // O(n)
+    //! Number of open-addressing slots for \c count entries: a power of two at least twice \c count.
+    static SizeType HashTableSize(SizeType count) {
+        SizeType size = 8;
+        while (size < count * 2)
+            size *= 2;
+        return size;
+    }
+
+    //! Builds the property name table. Slots hold property index + 1, 0 is empty.
+    void BuildPropertyTable() {
+        const SizeType size = HashTableSize(propertyCount_);
+        propertyTable_ = static_cast<SizeType*>(allocator_->Malloc(sizeof(SizeType) * size));
+        std::memset(propertyTable_, 0, sizeof(SizeType) * size);
+        propertyTableMask_ = size - 1;
+        for (SizeType index = 0; index < propertyCount_; index++) {
+            SizeType slot = internal::StrHash(properties_[index].name.GetString(), properties_[index].name.GetStringLength()) & propertyTableMask_;
+            while (propertyTable_[slot] != 0)
+                slot = (slot + 1) & propertyTableMask_;
+            propertyTable_[slot] = index + 1;
+        }
+    }
+
+    //! Builds the enum hash table. Slots hold enum_ index + 1, 0 is empty.
+    void BuildEnumTable() {
+        const SizeType size = HashTableSize(enumCount_);
+        enumTable_ = static_cast<SizeType*>(allocator_->Malloc(sizeof(SizeType) * size));
+        std::memset(enumTable_, 0, sizeof(SizeType) * size);
+        enumTableMask_ = size - 1;
+        for (SizeType i = 0; i < enumCount_; i++) {
+            SizeType slot = EnumSlot(enum_[i]);
+            while (enumTable_[slot] != 0)
+                slot = (slot + 1) & enumTableMask_;
+            enumTable_[slot] = i + 1;
+        }
+    }
+
+    SizeType EnumSlot(uint64_t h) const {
+        return static_cast<SizeType>(h ^ (h >> 32)) & enumTableMask_;
+    }
+
+    // O(1) expected
+    bool FindEnum(uint64_t h) const {
+        for (SizeType slot = EnumSlot(h); enumTable_[slot] != 0; slot = (slot + 1) & enumTableMask_)
+            if (enum_[enumTable_[slot] - 1] == h)
+                return true;
+        return false;
+    }
+
+    // O(1) expected
     bool FindPropertyIndex(const ValueType& name, SizeType* outIndex) const {
+        if (!propertyTable_)
+            return false;
         SizeType len = name.GetStringLength();
         const Ch* str = name.GetString();
-        for (SizeType index = 0; index < propertyCount_; index++)
+        for (SizeType slot = internal::StrHash(str, len) & propertyTableMask_; propertyTable_[slot] != 0; slot = (slot + 1) & propertyTableMask_) {
+            const SizeType index = propertyTable_[slot] - 1;
             if (properties_[index].name.GetStringLength() == len && 
                 (std::memcmp(properties_[index].name.GetString(), str, sizeof(Ch) * len) == 0))
             {
                 *outIndex = index;
                 return true;
             }
+        }
         return false;
     }
 
@@ -1218,8 +1323,11 @@ private:
     };
 
     AllocatorType* allocator_;
+    SValue enumValues_;         //!< "enum" as written, for GetEnum()
     uint64_t* enum_;
     SizeType enumCount_;
+    SizeType* enumTable_;       //!< Open-addressing table over enum_ hashes
+    SizeType enumTableMask_;
     SchemaArray allOf_;
     SchemaArray anyOf_;
     SchemaArray oneOf_;
@@ -1229,6 +1337,8 @@ private:
     SizeType notValidatorIndex_;
 
     Property* properties_;
+    SizeType* propertyTable_;   //!< Open-addressing table over property names
+    SizeType propertyTableMask_;
     const SchemaType* additionalPropertiesSchema_;
     PatternProperty* patternProperties_;
     SizeType patternPropertyCount_;
@@ -1438,7 +1548,7 @@ private:
             for (typename ValueType::ConstMemberIterator itr = v.MemberBegin(); itr != v.MemberEnd(); ++itr)
                 CreateSchemaRecursive(0, pointer.Append(itr->name, allocator_), itr->value, document);
         }
-        else if (v.GetType() == kArrayType)
+        else if (v.IsArray())
             for (SizeType i = 0; i < v.Size(); i++)
                 CreateSchemaRecursive(0, pointer.Append(i, allocator_), v[i], document);
     }
@@ -1574,12 +1684,17 @@ public:
         size_t documentStackCapacity = kDefaultDocumentStackCapacity)
         :
         schemaDocument_(&schemaDocument),
-        root_(schemaDocument.GetRoot()),
+        root_(&schemaDocument.GetRoot()),
         outputHandler_(GetNullHandler()),
         stateAllocator_(allocator),
         ownStateAllocator_(0),
         schemaStack_(allocator, schemaStackCapacity),
         documentStack_(allocator, documentStackCapacity),
+        freeValidators_(allocator, 0),
+        freeHashers_(allocator, 0),
+        freeHashCodeSets_(allocator, 0),
+        patternSearches_(allocator, 0),
+        freeStates_(),
         valid_(true)
 #if RAPIDJSON_SCHEMA_VERBOSE
         , depth_(0)
@@ -1602,12 +1717,17 @@ public:
         size_t documentStackCapacity = kDefaultDocumentStackCapacity)
         :
         schemaDocument_(&schemaDocument),
-        root_(schemaDocument.GetRoot()),
+        root_(&schemaDocument.GetRoot()),
         outputHandler_(outputHandler),
         stateAllocator_(allocator),
         ownStateAllocator_(0),
         schemaStack_(allocator, schemaStackCapacity),
         documentStack_(allocator, documentStackCapacity),
+        freeValidators_(allocator, 0),
+        freeHashers_(allocator, 0),
+        freeHashCodeSets_(allocator, 0),
+        patternSearches_(allocator, 0),
+        freeStates_(),
         valid_(true)
 #if RAPIDJSON_SCHEMA_VERBOSE
         , depth_(0)
@@ -1618,10 +1738,16 @@ public:
     //! Destructor.
     ~GenericSchemaValidator() {
         Reset();
+        ReleasePools();
         RAPIDJSON_DELETE(ownStateAllocator_);
     }
 
     //! Reset the internal states.
+    /*!
+        Sub-validators, hashers, state buffers and the pattern DFAs built by the
+        previous validation are kept for reuse, so validating similar documents
+        again does not allocate.
+    */
     void Reset() {
         while (!schemaStack_.Empty())
             PopSchema();
@@ -1739,6 +1865,11 @@ RAPIDJSON_MULTILINEMACRO_END
 
     // Implementation of ISchemaStateFactory<SchemaType>
     virtual ISchemaValidator* CreateSchemaValidator(const SchemaType& root) {
+        if (!freeValidators_.Empty()) {
+            GenericSchemaValidator* v = *freeValidators_.template Pop<GenericSchemaValidator*>(1);
+            v->root_ = &root;
+            return v;
+        }
         return new (GetStateAllocator().Malloc(sizeof(GenericSchemaValidator))) GenericSchemaValidator(*schemaDocument_, root,
 #if RAPIDJSON_SCHEMA_VERBOSE
         depth_ + 1,
@@ -1748,11 +1879,13 @@ RAPIDJSON_MULTILINEMACRO_END
 
     virtual void DestroySchemaValidator(ISchemaValidator* validator) {
         GenericSchemaValidator* v = static_cast<GenericSchemaValidator*>(validator);
-        v->~GenericSchemaValidator();
-        StateAllocator::Free(v);
+        v->Reset();
+        *freeValidators_.template Push<GenericSchemaValidator*>() = v;
     }
 
     virtual void* CreateHasher() {
+        if (!freeHashers_.Empty())
+            return *freeHashers_.template Pop<HasherType*>(1);
         return new (GetStateAllocator().Malloc(sizeof(HasherType))) HasherType(&GetStateAllocator());
     }
 
@@ -1762,22 +1895,68 @@ RAPIDJSON_MULTILINEMACRO_END
 
     virtual void DestroryHasher(void* hasher) {
         HasherType* h = static_cast<HasherType*>(hasher);
-        h->~HasherType();
-        StateAllocator::Free(h);
+        h->Reset();
+        *freeHashers_.template Push<HasherType*>() = h;
     }
 
     virtual void* MallocState(size_t size) {
-        return GetStateAllocator().Malloc(size);
+        size_t sizeClass = 0;
+        while (sizeClass < kStateSizeClassCount && (kMinStateSize << sizeClass) < size)
+            sizeClass++;
+        size_t* block;
+        if (sizeClass < kStateSizeClassCount && freeStates_[sizeClass]) {
+            block = static_cast<size_t*>(freeStates_[sizeClass]);
+            freeStates_[sizeClass] = *reinterpret_cast<void**>(block + 1);
+        }
+        else
+            block = static_cast<size_t*>(GetStateAllocator().Malloc(sizeof(size_t) + (sizeClass < kStateSizeClassCount ? kMinStateSize << sizeClass : size)));
+        *block = sizeClass;
+        return block + 1;
     }
 
     virtual void FreeState(void* p) {
-        return StateAllocator::Free(p);
+        size_t* block = static_cast<size_t*>(p) - 1;
+        if (*block < kStateSizeClassCount) {
+            *static_cast<void**>(p) = freeStates_[*block];
+            freeStates_[*block] = block;
+        }
+        else
+            StateAllocator::Free(block);
     }
 
+#if RAPIDJSON_SCHEMA_USE_INTERNALREGEX
+    virtual bool IsPatternMatch(const typename SchemaType::RegexType* pattern, const Ch* str, SizeType length) {
+        PatternSearch* searches = patternSearches_.template Bottom<PatternSearch>();
+        const size_t count = patternSearches_.GetSize() / sizeof(PatternSearch);
+        for (size_t i = 0; i < count; i++)
+            if (searches[i].pattern == pattern)
+                return searches[i].search->Search(str, length);
+        PatternSearch* entry = patternSearches_.template Push<PatternSearch>();
+        entry->pattern = pattern;
+        entry->search = new (GetStateAllocator().Malloc(sizeof(RegexSearchType))) RegexSearchType(*pattern, &GetStateAllocator());
+        return entry->search->Search(str, length);
+    }
+#endif
+
 private:
     typedef typename SchemaType::Context Context;
-    typedef GenericValue<UTF8<>, StateAllocator> HashCodeArray;
+    //! Hash codes of the elements seen so far in an array with uniqueItems.
+    struct HashCodeSet {
+        HashCodeSet() : codes(), capacity(), count(), hasZero() {}
+        uint64_t* codes;    //!< open-addressing slots, 0 marks an empty slot
+        SizeType capacity;
+        SizeType count;
+        bool hasZero;
+    };
     typedef internal::Hasher<EncodingType, StateAllocator> HasherType;
+#if RAPIDJSON_SCHEMA_USE_INTERNALREGEX
+    typedef internal::GenericRegexSearch<typename SchemaType::RegexType, StateAllocator> RegexSearchType;
+    //! Search state of one regex of the schema document, owned by this validator.
+    struct PatternSearch {
+        const typename SchemaType::RegexType* pattern;
+        RegexSearchType* search;
+    };
+#endif
 
     GenericSchemaValidator( 
         const SchemaDocumentType& schemaDocument,
@@ -1790,12 +1969,17 @@ private:
         size_t documentStackCapacity = kDefaultDocumentStackCapacity)
         :
         schemaDocument_(&schemaDocument),
-        root_(root),
+        root_(&root),
         outputHandler_(GetNullHandler()),
         stateAllocator_(allocator),
         ownStateAllocator_(0),
         schemaStack_(allocator, schemaStackCapacity),
         documentStack_(allocator, documentStackCapacity),
+        freeValidators_(allocator, 0),
+        freeHashers_(allocator, 0),
+        freeHashCodeSets_(allocator, 0),
+        patternSearches_(allocator, 0),
+        freeStates_(),
         valid_(true)
 #if RAPIDJSON_SCHEMA_VERBOSE
         , depth_(depth)
@@ -1809,9 +1993,40 @@ private:
         return *stateAllocator_;
     }
 
+    //! Destroys the pooled sub-validators, hashers, regex searches and state buffers.
+    void ReleasePools() {
+        while (!freeValidators_.Empty()) {
+            GenericSchemaValidator* v = *freeValidators_.template Pop<GenericSchemaValidator*>(1);
+            v->~GenericSchemaValidator();
+            StateAllocator::Free(v);
+        }
+        while (!freeHashers_.Empty()) {
+            HasherType* h = *freeHashers_.template Pop<HasherType*>(1);
+            h->~HasherType();
+            StateAllocator::Free(h);
+        }
+        while (!freeHashCodeSets_.Empty()) {
+            HashCodeSet* a = *freeHashCodeSets_.template Pop<HashCodeSet*>(1);
+            StateAllocator::Free(a->codes);
+            StateAllocator::Free(a);
+        }
+#if RAPIDJSON_SCHEMA_USE_INTERNALREGEX
+        while (!patternSearches_.Empty()) {
+            PatternSearch* p = patternSearches_.template Pop<PatternSearch>(1);
+            p->search->~RegexSearchType();
+            StateAllocator::Free(p->search);
+        }
+#endif
+        for (size_t i = 0; i < kStateSizeClassCount; i++)
+            while (void* block = freeStates_[i]) {
+                freeStates_[i] = *reinterpret_cast<void**>(static_cast<size_t*>(block) + 1);
+                StateAllocator::Free(block);
+            }
+    }
+
     bool BeginValue() {
         if (schemaStack_.Empty())
-            PushSchema(root_);
+            PushSchema(*root_);
         else {
             if (CurrentContext().inArray)
                 internal::TokenHelper<internal::Stack<StateAllocator>, Ch>::AppendIndexToken(documentStack_, CurrentContext().arrayElementIndex);
@@ -1860,13 +2075,16 @@ private:
         if (!schemaStack_.Empty()) {
             Context& context = CurrentContext();
             if (context.valueUniqueness) {
-                HashCodeArray* a = static_cast<HashCodeArray*>(context.arrayElementHashCodes);
-                if (!a)
-                    CurrentContext().arrayElementHashCodes = a = new (GetStateAllocator().Malloc(sizeof(HashCodeArray))) HashCodeArray(kArrayType);
-                for (typename HashCodeArray::ConstValueIterator itr = a->Begin(); itr != a->End(); ++itr)
-                    if (itr->GetUint64() == h)
-                        RAPIDJSON_INVALID_KEYWORD_RETURN(SchemaType::GetUniqueItemsString());
-                a->PushBack(h, GetStateAllocator());
+                HashCodeSet* a = static_cast<HashCodeSet*>(context.arrayElementHashCodes);
+                if (!a) {
+                    if (!freeHashCodeSets_.Empty())
+                        a = *freeHashCodeSets_.template Pop<HashCodeSet*>(1);
+                    else
+                        a = new (GetStateAllocator().Malloc(sizeof(HashCodeSet))) HashCodeSet();
+                    CurrentContext().arrayElementHashCodes = a;
+                }
+                if (!AddHashCode(*a, h))
+                    RAPIDJSON_INVALID_KEYWORD_RETURN(SchemaType::GetUniqueItemsString());
             }
         }
 
@@ -1877,6 +2095,39 @@ private:
         return true;
     }
 
+    //! Inserts \c h, returns false if it was already present.
+    bool AddHashCode(HashCodeSet& set, uint64_t h) {
+        if (h == 0) {
+            if (set.hasZero)
+                return false;
+            return set.hasZero = true;
+        }
+        if ((set.count + 1) * 2 > set.capacity) {
+            const SizeType capacity = set.capacity ? set.capacity * 2 : 16;
+            uint64_t* codes = static_cast<uint64_t*>(GetStateAllocator().Malloc(sizeof(uint64_t) * capacity));
+            std::memset(codes, 0, sizeof(uint64_t) * capacity);
+            for (SizeType i = 0; i < set.capacity; i++)
+                if (set.codes[i]) {
+                    SizeType slot = static_cast<SizeType>(set.codes[i] ^ (set.codes[i] >> 32)) & (capacity - 1);
+                    while (codes[slot])
+                        slot = (slot + 1) & (capacity - 1);
+                    codes[slot] = set.codes[i];
+                }
+            StateAllocator::Free(set.codes);
+            set.codes = codes;
+            set.capacity = capacity;
+        }
+        for (SizeType slot = static_cast<SizeType>(h ^ (h >> 32)) & (set.capacity - 1); ; slot = (slot + 1) & (set.capacity - 1)) {
+            if (set.codes[slot] == h)
+                return false;
+            if (set.codes[slot] == 0) {
+                set.codes[slot] = h;
+                set.count++;
+                return true;
+            }
+        }
+    }
+
     void AppendToken(const Ch* str, SizeType len) {
         documentStack_.template Reserve<Ch>(1 + len * 2); // worst case all characters are escaped as two characters
         *documentStack_.template PushUnsafe<Ch>() = '/';
@@ -1898,9 +2149,12 @@ private:
     
     RAPIDJSON_FORCEINLINE void PopSchema() {
         Context* c = schemaStack_.template Pop<Context>(1);
-        if (HashCodeArray* a = static_cast<HashCodeArray*>(c->arrayElementHashCodes)) {
-            a->~HashCodeArray();
-            StateAllocator::Free(a);
+        if (HashCodeSet* a = static_cast<HashCodeSet*>(c->arrayElementHashCodes)) {
+            if (a->count)
+                std::memset(a->codes, 0, sizeof(uint64_t) * a->capacity);
+            a->count = 0;
+            a->hasZero = false;
+            *freeHashCodeSets_.template Push<HashCodeSet*>() = a;
         }
         c->~Context();
     }
@@ -1916,13 +2170,20 @@ private:
 
     static const size_t kDefaultSchemaStackCapacity = 1024;
     static const size_t kDefaultDocumentStackCapacity = 256;
+    static const size_t kMinStateSize = 16;
+    static const size_t kStateSizeClassCount = 8;   //!< Pooled state buffers of 16 to 2048 bytes
     const SchemaDocumentType* schemaDocument_;
-    const SchemaType& root_;
+    const SchemaType* root_;
     OutputHandler& outputHandler_;
     StateAllocator* stateAllocator_;
     StateAllocator* ownStateAllocator_;
     internal::Stack<StateAllocator> schemaStack_;    //!< stack to store the current path of schema (BaseSchemaType *)
     internal::Stack<StateAllocator> documentStack_;  //!< stack to store the current path of validating document (Ch)
+    internal::Stack<StateAllocator> freeValidators_; //!< released sub-validators (GenericSchemaValidator*)
+    internal::Stack<StateAllocator> freeHashers_;    //!< released hashers (HasherType*)
+    internal::Stack<StateAllocator> freeHashCodeSets_; //!< released uniqueItems hash sets (HashCodeSet*)
+    internal::Stack<StateAllocator> patternSearches_;  //!< search state of each regex matched so far (PatternSearch)
+    void* freeStates_[kStateSizeClassCount];        //!< released state buffers per size class, linked through their first word
     bool valid_;
 #if RAPIDJSON_SCHEMA_VERBOSE
     unsigned depth_;
@@ -0,0 +1,622 @@
+// Tencent is pleased to support the open source community by making RapidJSON available.
+//
+// Copyright (C) 2015 THL A29 Limited, a Tencent company, and Milo Yip. All rights reserved.
+//
+// Licensed under the MIT License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// http://opensource.org/licenses/MIT
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef RAPIDJSON_SIMD_H_
+#define RAPIDJSON_SIMD_H_
+
+#include "rapidjson.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#ifdef RAPIDJSON_SIMD_DISPATCH
+#ifndef _MSC_VER
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+#if RAPIDJSON_HAS_CXX11_ATOMIC
+#include <atomic>
+#endif
+#elif defined(RAPIDJSON_AVX2) || defined(RAPIDJSON_AVX512)
+#include <immintrin.h>
+#elif defined(RAPIDJSON_SSE42)
+#include <nmmintrin.h>
+#elif defined(RAPIDJSON_SSE2)
+#include <emmintrin.h>
+#endif
+
+RAPIDJSON_NAMESPACE_BEGIN
+
+///////////////////////////////////////////////////////////////////////////////
+// SimdKernel
+
+//! Sets of vectorized kernels used by the reader and the writer.
+enum SimdKernel {
+    kSimdKernelScalar = 0,  //!< No SIMD.
+    kSimdKernelSSE2,        //!< SSE2, 16 bytes per iteration.
+    kSimdKernelSSE42,       //!< SSE4.2 (pcmpistrm) whitespace skipping, SSE2 string scanning.
+    kSimdKernelAVX2,        //!< AVX2, 32 bytes per iteration.
+    kSimdKernelAVX512,      //!< AVX-512BW, 64 bytes per iteration.
+    kSimdKernelCount
+};
+
+//! Name of a kernel set, e.g. "avx2".
+inline const char* GetSimdKernelName(SimdKernel kernel) {
+    static const char* const names[] = { "scalar", "sse2", "sse4.2", "avx2", "avx512bw" };
+    return static_cast<unsigned>(kernel) < kSimdKernelCount ? names[kernel] : "unknown";
+}
+
+namespace internal {
+
+// With RAPIDJSON_SIMD_DISPATCH every kernel set is compiled for its own target;
+// otherwise only the sets enabled by the compile-time symbols are compiled.
+#if defined(RAPIDJSON_SIMD_DISPATCH) && (defined(__GNUC__) || defined(__clang__))
+#define RAPIDJSON_SIMD_TARGET(x) __attribute__((target(x)))
+#else
+#define RAPIDJSON_SIMD_TARGET(x)
+#endif
+
+// The zero-terminated kernels load whole aligned blocks: the block holding the terminator
+// never reaches into the next page, but may cover bytes past the end of the allocation,
+// which address and thread sanitizers would report.
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)
+#define RAPIDJSON_SIMD_BLOCK_READ __attribute__((no_sanitize_address, no_sanitize_thread))
+#elif defined(_MSC_VER) && _MSC_VER >= 1927
+#define RAPIDJSON_SIMD_BLOCK_READ __declspec(no_sanitize_address)
+#else
+#define RAPIDJSON_SIMD_BLOCK_READ
+#endif
+
+#ifdef RAPIDJSON_SIMD_DISPATCH
+///////////////////////////////////////////////////////////////////////////////
+// CPU detection
+
+inline void SimdCpuid(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+#ifdef _MSC_VER
+    int r[4];
+    __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; i++)
+        regs[i] = static_cast<unsigned>(r[i]);
+#else
+    if (!__get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3]))
+        regs[0] = regs[1] = regs[2] = regs[3] = 0;
+#endif
+}
+
+//! Register state enabled by the OS (XCR0). \pre OSXSAVE
+inline uint64_t SimdXgetbv() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+//! Bit set of the kernels supported by the CPU and the OS, bit \c i being SimdKernel \c i.
+inline unsigned SimdSupportedKernels() {
+    unsigned supported = 1u << kSimdKernelScalar;
+    unsigned r[4];
+    SimdCpuid(0, 0, r);
+    const unsigned maxLeaf = r[0];
+    if (maxLeaf < 1)
+        return supported;
+
+    SimdCpuid(1, 0, r);
+    if (r[3] & (1u << 26))
+        supported |= 1u << kSimdKernelSSE2;
+    if ((r[3] & (1u << 26)) && (r[2] & (1u << 20)))
+        supported |= 1u << kSimdKernelSSE42;
+
+    // AVX state must be enabled by the OS (OSXSAVE and XCR0), not only by the CPU
+    if (!(r[2] & (1u << 27)) || !(r[2] & (1u << 28)) || maxLeaf < 7)
+        return supported;
+    const uint64_t xcr0 = SimdXgetbv();
+    SimdCpuid(7, 0, r);
+    if ((xcr0 & 0x6) == 0x6 && (r[1] & (1u << 5)))
+        supported |= 1u << kSimdKernelAVX2;
+    if ((xcr0 & 0xE6) == 0xE6 && (r[1] & (1u << 16)) && (r[1] & (1u << 30)))
+        supported |= 1u << kSimdKernelAVX512;
+    return supported;
+}
+#endif // RAPIDJSON_SIMD_DISPATCH
+
+///////////////////////////////////////////////////////////////////////////////
+// Kernels
+//
+// Each kernel set provides:
+// - SkipWhitespace(p): first non-whitespace byte of a zero-terminated string;
+// - SkipWhitespace(p, end): first non-whitespace byte in [p, end), or end;
+// - ScanString(p): first '\"', '\\' or control character (< 0x20) of a zero-terminated string;
+// - ScanString(p, end): same in [p, end), or end.
+// Zero-terminated scans load the first block from the aligned address below p and shift
+// out the bits of the bytes before p, so no load crosses a page boundary. Bounded scans
+// use unaligned loads while a full block remains and finish byte by byte.
+
+inline bool SimdIsWhitespace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+inline bool SimdIsStringStop(char c) { return c == '\"' || c == '\\' || static_cast<unsigned char>(c) < 0x20; }
+
+//! Index of the lowest set bit. \pre mask != 0
+inline size_t SimdFirstBit32(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long offset;
+    _BitScanForward(&offset, mask);
+    return offset;
+#else
+    return static_cast<size_t>(__builtin_ctz(mask));
+#endif
+}
+
+//! Index of the lowest set bit. \pre mask != 0
+inline size_t SimdFirstBit64(uint64_t mask) {
+#if defined(_MSC_VER) && defined(_WIN64)
+    unsigned long offset;
+    _BitScanForward64(&offset, mask);
+    return offset;
+#elif defined(_MSC_VER)
+    const uint32_t low = static_cast<uint32_t>(mask);
+    return low ? SimdFirstBit32(low) : 32 + SimdFirstBit32(static_cast<uint32_t>(mask >> 32));
+#else
+    return static_cast<size_t>(__builtin_ctzll(mask));
+#endif
+}
+
+inline size_t SimdMisalignment(const char* p, size_t width) { return reinterpret_cast<size_t>(p) & (width - 1); }
+
+#if RAPIDJSON_ENDIAN == RAPIDJSON_LITTLEENDIAN
+// SWAR (SIMD within a register): up to 8 decimal digits converted with three multiplications.
+
+//! Loads 8 bytes of a bounded buffer.
+inline uint64_t SwarLoad8(const char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+//! Loads 8 bytes from a zero-terminated string. \pre The 8 bytes lie within the page of p.
+/*! The bytes past the terminator are read but never used: SwarTakeDigits8() stops at the terminator.
+*/
+RAPIDJSON_SIMD_BLOCK_READ inline uint64_t SwarLoad8Terminated(const char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+//! Whether an 8-byte load at p stays within its page and so cannot fault.
+inline bool SwarLoadable8(const char* p) { return SimdMisalignment(p, 4096) <= 4096 - 8; }
+
+//! Accumulates the run of decimal digits at the start of 8 bytes.
+/*! \param v 8 bytes loaded with SwarLoad8() or SwarLoad8Terminated().
+    \param acc Accumulator, updated to acc * 10^n + (value of the n digits).
+    \return Number of leading digits n, 0 to 8.
+*/
+inline unsigned SwarTakeDigits8(uint64_t v, uint64_t* acc) {
+    static const uint32_t kPow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+
+    // A byte is a digit iff its high nibble is 3 both as is and after adding 6.
+    // Carries from bytes >= 0xFA only reach bytes after a non-digit.
+    const uint64_t kF0 = RAPIDJSON_UINT64_C2(0xF0F0F0F0, 0xF0F0F0F0);
+    const uint64_t nonDigit = ((v & kF0) | (((v + RAPIDJSON_UINT64_C2(0x06060606, 0x06060606)) & kF0) >> 4)) ^ RAPIDJSON_UINT64_C2(0x33333333, 0x33333333);
+    const unsigned n = nonDigit ? static_cast<unsigned>(SimdFirstBit64(nonDigit) >> 3) : 8u;
+    if (n == 0)
+        return 0;
+
+    // Drop the bytes after the digits; the vacated low bytes act as leading zeros
+    v = (v - RAPIDJSON_UINT64_C2(0x30303030, 0x30303030)) << (8 * (8 - n));
+    v = v * 10 + (v >> 8);  // adjacent pairs
+    const uint64_t kMask = RAPIDJSON_UINT64_C2(0x000000FF, 0x000000FF);
+    v = ((v & kMask) * RAPIDJSON_UINT64_C2(0x000F4240, 0x00000064) + ((v >> 16) & kMask) * RAPIDJSON_UINT64_C2(0x00002710, 0x00000001)) >> 32;
+    *acc = *acc * kPow10[n] + static_cast<uint32_t>(v);
+    return n;
+}
+#endif // RAPIDJSON_ENDIAN == RAPIDJSON_LITTLEENDIAN
+
+// Scalar
+
+inline const char* SkipWhitespace_Scalar(const char* p) {
+    while (SimdIsWhitespace(*p))
+        ++p;
+    return p;
+}
+
+inline const char* SkipWhitespaceBounded_Scalar(const char* p, const char* end) {
+    while (p != end && SimdIsWhitespace(*p))
+        ++p;
+    return p;
+}
+
+inline const char* ScanString_Scalar(const char* p) {
+    while (!SimdIsStringStop(*p))
+        ++p;
+    return p;
+}
+
+inline const char* ScanStringBounded_Scalar(const char* p, const char* end) {
+    while (p != end && !SimdIsStringStop(*p))
+        ++p;
+    return p;
+}
+
+#if defined(RAPIDJSON_SIMD_DISPATCH) || defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SSE42)
+// SSE2
+
+RAPIDJSON_SIMD_TARGET("sse2") inline uint32_t NonWhitespaceMask_SSE2(__m128i s) {
+    __m128i x = _mm_cmpeq_epi8(s, _mm_set1_epi8(' '));
+    x = _mm_or_si128(x, _mm_cmpeq_epi8(s, _mm_set1_epi8('\n')));
+    x = _mm_or_si128(x, _mm_cmpeq_epi8(s, _mm_set1_epi8('\r')));
+    x = _mm_or_si128(x, _mm_cmpeq_epi8(s, _mm_set1_epi8('\t')));
+    return ~static_cast<uint32_t>(_mm_movemask_epi8(x)) & 0xFFFFu;
+}
+
+RAPIDJSON_SIMD_TARGET("sse2") inline uint32_t StringStopMask_SSE2(__m128i s) {
+    const __m128i sp = _mm_set1_epi8(0x1F);
+    const __m128i t1 = _mm_cmpeq_epi8(s, _mm_set1_epi8('\"'));
+    const __m128i t2 = _mm_cmpeq_epi8(s, _mm_set1_epi8('\\'));
+    const __m128i t3 = _mm_cmpeq_epi8(_mm_max_epu8(s, sp), sp); // s < 0x20 <=> max(s, 0x1F) == 0x1F
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(t1, t2), t3)));
+}
+
+RAPIDJSON_SIMD_TARGET("sse2") RAPIDJSON_SIMD_BLOCK_READ inline const char* SkipWhitespace_SSE2(const char* p) {
+    const size_t misalign = SimdMisalignment(p, 16);
+    uint32_t r = NonWhitespaceMask_SSE2(_mm_load_si128(reinterpret_cast<const __m128i *>(p - misalign))) >> misalign;
+    if (r != 0)
+        return p + SimdFirstBit32(r);
+    for (p += 16 - misalign;; p += 16)
+        if ((r = NonWhitespaceMask_SSE2(_mm_load_si128(reinterpret_cast<const __m128i *>(p)))) != 0)
+            return p + SimdFirstBit32(r);
+}
+
+RAPIDJSON_SIMD_TARGET("sse2") inline const char* SkipWhitespaceBounded_SSE2(const char* p, const char* end) {
+    for (; end - p >= 16; p += 16) {
+        const uint32_t r = NonWhitespaceMask_SSE2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+        if (r != 0)
+            return p + SimdFirstBit32(r);
+    }
+    return SkipWhitespaceBounded_Scalar(p, end);
+}
+
+RAPIDJSON_SIMD_TARGET("sse2") RAPIDJSON_SIMD_BLOCK_READ inline const char* ScanString_SSE2(const char* p) {
+    const size_t misalign = SimdMisalignment(p, 16);
+    uint32_t r = StringStopMask_SSE2(_mm_load_si128(reinterpret_cast<const __m128i *>(p - misalign))) >> misalign;
+    if (r != 0)
+        return p + SimdFirstBit32(r);
+    for (p += 16 - misalign;; p += 16)
+        if ((r = StringStopMask_SSE2(_mm_load_si128(reinterpret_cast<const __m128i *>(p)))) != 0)
+            return p + SimdFirstBit32(r);
+}
+
+RAPIDJSON_SIMD_TARGET("sse2") inline const char* ScanStringBounded_SSE2(const char* p, const char* end) {
+    for (; end - p >= 16; p += 16) {
+        const uint32_t r = StringStopMask_SSE2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+        if (r != 0)
+            return p + SimdFirstBit32(r);
+    }
+    return ScanStringBounded_Scalar(p, end);
+}
+
+#endif
+
+#if defined(RAPIDJSON_SIMD_DISPATCH) || defined(RAPIDJSON_SSE42)
+// SSE4.2
+
+RAPIDJSON_SIMD_TARGET("sse4.2") inline uint32_t NonWhitespaceMask_SSE42(__m128i s) {
+    static const char whitespace[16] = " \n\r\t";
+    const __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&whitespace[0]));
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_cmpistrm(w, s, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK | _SIDD_NEGATIVE_POLARITY)));
+}
+
+RAPIDJSON_SIMD_TARGET("sse4.2") RAPIDJSON_SIMD_BLOCK_READ inline const char* SkipWhitespace_SSE42(const char* p) {
+    // pcmpistrm stops at the first zero byte, so bytes before p may not be loaded:
+    // scan one by one until alignment
+    const char* nextAligned = reinterpret_cast<const char*>((reinterpret_cast<size_t>(p) + 15) & static_cast<size_t>(~15));
+    for (; p != nextAligned; ++p)
+        if (!SimdIsWhitespace(*p))
+            return p;
+    for (;; p += 16) {
+        const uint32_t r = NonWhitespaceMask_SSE42(_mm_load_si128(reinterpret_cast<const __m128i *>(p)));
+        if (r != 0)
+            return p + SimdFirstBit32(r);
+    }
+}
+
+RAPIDJSON_SIMD_TARGET("sse4.2") inline const char* SkipWhitespaceBounded_SSE42(const char* p, const char* end) {
+    for (; end - p >= 16; p += 16) {
+        const uint32_t r = NonWhitespaceMask_SSE42(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+        if (r != 0)
+            return p + SimdFirstBit32(r);
+    }
+    return SkipWhitespaceBounded_Scalar(p, end);
+}
+
+#endif
+
+#if defined(RAPIDJSON_SIMD_DISPATCH) || defined(RAPIDJSON_AVX2) || defined(RAPIDJSON_AVX512)
+// AVX2
+
+RAPIDJSON_SIMD_TARGET("avx2") inline uint32_t NonWhitespaceMask_AVX2(__m256i s) {
+    __m256i x = _mm256_cmpeq_epi8(s, _mm256_set1_epi8(' '));
+    x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\n')));
+    x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\r')));
+    x = _mm256_or_si256(x, _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\t')));
+    return ~static_cast<uint32_t>(_mm256_movemask_epi8(x));
+}
+
+RAPIDJSON_SIMD_TARGET("avx2") inline uint32_t StringStopMask_AVX2(__m256i s) {
+    const __m256i sp = _mm256_set1_epi8(0x1F);
+    const __m256i t1 = _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\"'));
+    const __m256i t2 = _mm256_cmpeq_epi8(s, _mm256_set1_epi8('\\'));
+    const __m256i t3 = _mm256_cmpeq_epi8(_mm256_max_epu8(s, sp), sp);
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(t1, t2), t3)));
+}
+
+RAPIDJSON_SIMD_TARGET("avx2") RAPIDJSON_SIMD_BLOCK_READ inline const char* SkipWhitespace_AVX2(const char* p) {
+    const size_t misalign = SimdMisalignment(p, 32);
+    uint32_t r = NonWhitespaceMask_AVX2(_mm256_load_si256(reinterpret_cast<const __m256i *>(p - misalign))) >> misalign;
+    if (r != 0)
+        return p + SimdFirstBit32(r);
+    for (p += 32 - misalign;; p += 32)
+        if ((r = NonWhitespaceMask_AVX2(_mm256_load_si256(reinterpret_cast<const __m256i *>(p)))) != 0)
+            return p + SimdFirstBit32(r);
+}
+
+RAPIDJSON_SIMD_TARGET("avx2") inline const char* SkipWhitespaceBounded_AVX2(const char* p, const char* end) {
+    for (; end - p >= 32; p += 32) {
+        const uint32_t r = NonWhitespaceMask_AVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+        if (r != 0)
+            return p + SimdFirstBit32(r);
+    }
+    return SkipWhitespaceBounded_SSE2(p, end);
+}
+
+RAPIDJSON_SIMD_TARGET("avx2") RAPIDJSON_SIMD_BLOCK_READ inline const char* ScanString_AVX2(const char* p) {
+    const size_t misalign = SimdMisalignment(p, 32);
+    uint32_t r = StringStopMask_AVX2(_mm256_load_si256(reinterpret_cast<const __m256i *>(p - misalign))) >> misalign;
+    if (r != 0)
+        return p + SimdFirstBit32(r);
+    for (p += 32 - misalign;; p += 32)
+        if ((r = StringStopMask_AVX2(_mm256_load_si256(reinterpret_cast<const __m256i *>(p)))) != 0)
+            return p + SimdFirstBit32(r);
+}
+
+RAPIDJSON_SIMD_TARGET("avx2") inline const char* ScanStringBounded_AVX2(const char* p, const char* end) {
+    for (; end - p >= 32; p += 32) {
+        const uint32_t r = StringStopMask_AVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+        if (r != 0)
+            return p + SimdFirstBit32(r);
+    }
+    return ScanStringBounded_SSE2(p, end);
+}
+
+#endif
+
+#if defined(RAPIDJSON_SIMD_DISPATCH) || defined(RAPIDJSON_AVX512)
+// AVX-512BW
+
+RAPIDJSON_SIMD_TARGET("avx512f,avx512bw") inline uint64_t NonWhitespaceMask_AVX512(__m512i s) {
+    return ~(_mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8(' '))
+           | _mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8('\n'))
+           | _mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8('\r'))
+           | _mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8('\t')));
+}
+
+RAPIDJSON_SIMD_TARGET("avx512f,avx512bw") inline uint64_t StringStopMask_AVX512(__m512i s) {
+    return _mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8('\"'))
+         | _mm512_cmpeq_epi8_mask(s, _mm512_set1_epi8('\\'))
+         | _mm512_cmplt_epu8_mask(s, _mm512_set1_epi8(0x20));
+}
+
+RAPIDJSON_SIMD_TARGET("avx512f,avx512bw") RAPIDJSON_SIMD_BLOCK_READ inline const char* SkipWhitespace_AVX512(const char* p) {
+    const size_t misalign = SimdMisalignment(p, 64);
+    uint64_t r = NonWhitespaceMask_AVX512(_mm512_load_si512(reinterpret_cast<const void*>(p - misalign))) >> misalign;
+    if (r != 0)
+        return p + SimdFirstBit64(r);
+    for (p += 64 - misalign;; p += 64)
+        if ((r = NonWhitespaceMask_AVX512(_mm512_load_si512(reinterpret_cast<const void*>(p)))) != 0)
+            return p + SimdFirstBit64(r);
+}
+
+RAPIDJSON_SIMD_TARGET("avx512f,avx512bw") inline const char* SkipWhitespaceBounded_AVX512(const char* p, const char* end) {
+    for (; end - p >= 64; p += 64) {
+        const uint64_t r = NonWhitespaceMask_AVX512(_mm512_loadu_si512(reinterpret_cast<const void*>(p)));
+        if (r != 0)
+            return p + SimdFirstBit64(r);
+    }
+    return SkipWhitespaceBounded_SSE2(p, end);
+}
+
+RAPIDJSON_SIMD_TARGET("avx512f,avx512bw") RAPIDJSON_SIMD_BLOCK_READ inline const char* ScanString_AVX512(const char* p) {
+    const size_t misalign = SimdMisalignment(p, 64);
+    uint64_t r = StringStopMask_AVX512(_mm512_load_si512(reinterpret_cast<const void*>(p - misalign))) >> misalign;
+    if (r != 0)
+        return p + SimdFirstBit64(r);
+    for (p += 64 - misalign;; p += 64)
+        if ((r = StringStopMask_AVX512(_mm512_load_si512(reinterpret_cast<const void*>(p)))) != 0)
+            return p + SimdFirstBit64(r);
+}
+
+RAPIDJSON_SIMD_TARGET("avx512f,avx512bw") inline const char* ScanStringBounded_AVX512(const char* p, const char* end) {
+    for (; end - p >= 64; p += 64) {
+        const uint64_t r = StringStopMask_AVX512(_mm512_loadu_si512(reinterpret_cast<const void*>(p)));
+        if (r != 0)
+            return p + SimdFirstBit64(r);
+    }
+    return ScanStringBounded_SSE2(p, end);
+}
+#endif
+
+#ifdef RAPIDJSON_SIMD_DISPATCH
+///////////////////////////////////////////////////////////////////////////////
+// Dispatch
+
+//! Entry points of one kernel set.
+struct SimdKernelTable {
+    SimdKernel kernel;
+    const char* (*skipWhitespace)(const char* p);
+    const char* (*skipWhitespaceBounded)(const char* p, const char* end);
+    const char* (*scanString)(const char* p);
+    const char* (*scanStringBounded)(const char* p, const char* end);
+};
+
+//! Active kernel table, shared by all translation units.
+/*! \c table initially points to \c kResolver, whose entries detect the CPU on
+    their first call, install the best supported table and forward to it. Every
+    thread racing on the first call stores the same pointer. The pointer is read
+    with acquire and written with release ordering (std::atomic in C++11, the
+    \c __atomic builtins or a volatile pointer otherwise).
+*/
+template <typename T = void>
+struct SimdDispatch {
+    static const SimdKernelTable kTables[kSimdKernelCount];
+    static const SimdKernelTable kResolver;
+#if RAPIDJSON_HAS_CXX11_ATOMIC
+    static std::atomic<const SimdKernelTable*> table;
+
+    static const SimdKernelTable* Table() { return table.load(std::memory_order_acquire); }
+    static void SetTable(const SimdKernelTable* t) { table.store(t, std::memory_order_release); }
+#elif defined(__GNUC__)
+    static const SimdKernelTable* table;
+
+    static const SimdKernelTable* Table() { return __atomic_load_n(&table, __ATOMIC_ACQUIRE); }
+    static void SetTable(const SimdKernelTable* t) { __atomic_store_n(&table, t, __ATOMIC_RELEASE); }
+#else
+    // MSVC gives volatile accesses acquire/release semantics (/volatile:ms)
+    static const SimdKernelTable* volatile table;
+
+    static const SimdKernelTable* Table() { return table; }
+    static void SetTable(const SimdKernelTable* t) { table = t; }
+#endif
+
+    static unsigned Supported() {
+        static const unsigned supported = SimdSupportedKernels();
+        return supported;
+    }
+
+    static const SimdKernelTable& Resolve() {
+        const unsigned supported = Supported();
+        int kernel = kSimdKernelCount - 1;
+        while (!(supported & (1u << kernel)))
+            --kernel;
+        SetTable(&kTables[kernel]);
+        return kTables[kernel];
+    }
+
+    static const SimdKernelTable& Get() {
+        const SimdKernelTable* t = Table();
+        return t != &kResolver ? *t : Resolve();
+    }
+
+    static const char* ResolveSkipWhitespace(const char* p) { return Resolve().skipWhitespace(p); }
+    static const char* ResolveSkipWhitespaceBounded(const char* p, const char* end) { return Resolve().skipWhitespaceBounded(p, end); }
+    static const char* ResolveScanString(const char* p) { return Resolve().scanString(p); }
+    static const char* ResolveScanStringBounded(const char* p, const char* end) { return Resolve().scanStringBounded(p, end); }
+};
+
+template <typename T>
+const SimdKernelTable SimdDispatch<T>::kTables[kSimdKernelCount] = {
+    { kSimdKernelScalar, &SkipWhitespace_Scalar, &SkipWhitespaceBounded_Scalar, &ScanString_Scalar, &ScanStringBounded_Scalar },
+    { kSimdKernelSSE2, &SkipWhitespace_SSE2, &SkipWhitespaceBounded_SSE2, &ScanString_SSE2, &ScanStringBounded_SSE2 },
+    { kSimdKernelSSE42, &SkipWhitespace_SSE42, &SkipWhitespaceBounded_SSE42, &ScanString_SSE2, &ScanStringBounded_SSE2 },
+    { kSimdKernelAVX2, &SkipWhitespace_AVX2, &SkipWhitespaceBounded_AVX2, &ScanString_AVX2, &ScanStringBounded_AVX2 },
+    { kSimdKernelAVX512, &SkipWhitespace_AVX512, &SkipWhitespaceBounded_AVX512, &ScanString_AVX512, &ScanStringBounded_AVX512 }
+};
+
+template <typename T>
+const SimdKernelTable SimdDispatch<T>::kResolver = {
+    kSimdKernelScalar, &ResolveSkipWhitespace, &ResolveSkipWhitespaceBounded, &ResolveScanString, &ResolveScanStringBounded
+};
+
+#if RAPIDJSON_HAS_CXX11_ATOMIC
+template <typename T>
+std::atomic<const SimdKernelTable*> SimdDispatch<T>::table(&SimdDispatch<T>::kResolver);
+#elif defined(__GNUC__)
+template <typename T>
+const SimdKernelTable* SimdDispatch<T>::table = &SimdDispatch<T>::kResolver;
+#else
+template <typename T>
+const SimdKernelTable* volatile SimdDispatch<T>::table = &SimdDispatch<T>::kResolver;
+#endif
+#endif // RAPIDJSON_SIMD_DISPATCH
+
+//! First character of [p, end) which must be escaped in a JSON string, or end.
+inline const char* ScanStringBounded(const char* p, const char* end) {
+#if defined(RAPIDJSON_SIMD_DISPATCH)
+    return SimdDispatch<>::Table()->scanStringBounded(p, end);
+#elif defined(RAPIDJSON_AVX512)
+    return ScanStringBounded_AVX512(p, end);
+#elif defined(RAPIDJSON_AVX2)
+    return ScanStringBounded_AVX2(p, end);
+#elif defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SSE42)
+    return ScanStringBounded_SSE2(p, end);
+#else
+    return ScanStringBounded_Scalar(p, end);
+#endif
+}
+
+} // namespace internal
+
+#ifdef RAPIDJSON_SIMD_DISPATCH
+
+//! Kernel set used by the reader and the writer.
+/*! With \c RAPIDJSON_SIMD_DISPATCH, the best set supported by the running CPU,
+    unless SetSimdKernel() selected another one. Otherwise the set chosen at
+    compile time.
+*/
+inline SimdKernel GetSimdKernel() {
+    return internal::SimdDispatch<>::Get().kernel;
+}
+
+//! Whether a kernel set can run on this CPU and OS.
+inline bool IsSimdKernelSupported(SimdKernel kernel) {
+    return static_cast<unsigned>(kernel) < kSimdKernelCount && (internal::SimdDispatch<>::Supported() & (1u << kernel));
+}
+
+//! Force a kernel set, e.g. for testing or benchmarking.
+/*! \return false if the set is not supported, leaving the current one active.
+    \note May be called while other threads parse or write; each kernel call
+        uses whichever set was active when it started, and all sets produce the
+        same results.
+*/
+inline bool SetSimdKernel(SimdKernel kernel) {
+    if (!IsSimdKernelSupported(kernel))
+        return false;
+    internal::SimdDispatch<>::SetTable(&internal::SimdDispatch<>::kTables[kernel]);
+    return true;
+}
+
+#else // RAPIDJSON_SIMD_DISPATCH
+
+inline SimdKernel GetSimdKernel() {
+#if defined(RAPIDJSON_AVX512)
+    return kSimdKernelAVX512;
+#elif defined(RAPIDJSON_AVX2)
+    return kSimdKernelAVX2;
+#elif defined(RAPIDJSON_SSE42)
+    return kSimdKernelSSE42;
+#elif defined(RAPIDJSON_SSE2)
+    return kSimdKernelSSE2;
+#else
+    return kSimdKernelScalar;
+#endif
+}
+
+inline bool IsSimdKernelSupported(SimdKernel kernel) { return kernel == GetSimdKernel(); }
+
+inline bool SetSimdKernel(SimdKernel kernel) { return kernel == GetSimdKernel(); }
+
+#endif // RAPIDJSON_SIMD_DISPATCH
+
+RAPIDJSON_NAMESPACE_END
+
+#endif // RAPIDJSON_SIMD_H_
@@ -92,6 +92,13 @@ inline void PutUnsafe(Stream& stream, typename Stream::Ch c) {
     stream.Put(c);
 }
 
+//! Write N characters to a stream, presuming buffer is reserved.
+template<typename Stream>
+inline void PutUnsafeN(Stream& stream, const typename Stream::Ch* str, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        PutUnsafe(stream, str[i]);
+}
+
 //! Put N copies of a character to a stream.
 template<typename Stream, typename Ch>
 inline void PutN(Stream& stream, Ch c, size_t n) {
@@ -102,6 +102,12 @@ inline void PutUnsafe(GenericStringBuffer<Encoding, Allocator>& stream, typename
     stream.PutUnsafe(c);
 }
 
+//! Implement specialized version of PutUnsafeN() with memcpy() for better performance.
+template<typename Encoding, typename Allocator>
+inline void PutUnsafeN(GenericStringBuffer<Encoding, Allocator>& stream, const typename Encoding::Ch* str, size_t n) {
+    std::memcpy(stream.stack_.template PushUnsafe<typename Encoding::Ch>(n), str, n * sizeof(*str));
+}
+
 //! Implement specialized version of PutN() with memset() for better performance.
 template<>
 inline void PutN(GenericStringBuffer<UTF8<> >& stream, char c, size_t n) {
@@ -17,22 +17,15 @@
 
 #include "stream.h"
 #include "internal/stack.h"
+#include "internal/meta.h"
 #include "internal/strfunc.h"
 #include "internal/dtoa.h"
+#include "internal/ryu.h"
 #include "internal/itoa.h"
 #include "stringbuffer.h"
+#include "simd.h"
 #include <new>      // placement new
 
-#if defined(RAPIDJSON_SIMD) && defined(_MSC_VER)
-#include <intrin.h>
-#pragma intrinsic(_BitScanForward)
-#endif
-#ifdef RAPIDJSON_SSE42
-#include <nmmintrin.h>
-#elif defined(RAPIDJSON_SSE2)
-#include <emmintrin.h>
-#endif
-
 #ifdef _MSC_VER
 RAPIDJSON_DIAG_PUSH
 RAPIDJSON_DIAG_OFF(4127) // conditional expression is constant
@@ -64,6 +57,7 @@ enum WriteFlag {
     kWriteNoFlags = 0,              //!< No flags are set.
     kWriteValidateEncodingFlag = 1, //!< Validate encoding of JSON strings.
     kWriteNanAndInfFlag = 2,        //!< Allow writing of Infinity, -Infinity and NaN.
+    kWriteShortestDoubleFlag = 4,   //!< Write doubles with the shortest round-trip digits (Ryu) instead of Grisu2.
     kWriteDefaultFlags = RAPIDJSON_WRITE_DEFAULT_FLAGS  //!< Default write flags. Can be customized by defining RAPIDJSON_WRITE_DEFAULT_FLAGS
 };
 
@@ -281,36 +275,28 @@ protected:
     bool WriteInt(int i) {
         char buffer[11];
         const char* end = internal::i32toa(i, buffer);
-        PutReserve(*os_, static_cast<size_t>(end - buffer));
-        for (const char* p = buffer; p != end; ++p)
-            PutUnsafe(*os_, static_cast<typename TargetEncoding::Ch>(*p));
+        PutNumber(buffer, end);
         return true;
     }
 
     bool WriteUint(unsigned u) {
         char buffer[10];
         const char* end = internal::u32toa(u, buffer);
-        PutReserve(*os_, static_cast<size_t>(end - buffer));
-        for (const char* p = buffer; p != end; ++p)
-            PutUnsafe(*os_, static_cast<typename TargetEncoding::Ch>(*p));
+        PutNumber(buffer, end);
         return true;
     }
 
     bool WriteInt64(int64_t i64) {
         char buffer[21];
         const char* end = internal::i64toa(i64, buffer);
-        PutReserve(*os_, static_cast<size_t>(end - buffer));
-        for (const char* p = buffer; p != end; ++p)
-            PutUnsafe(*os_, static_cast<typename TargetEncoding::Ch>(*p));
+        PutNumber(buffer, end);
         return true;
     }
 
     bool WriteUint64(uint64_t u64) {
         char buffer[20];
         char* end = internal::u64toa(u64, buffer);
-        PutReserve(*os_, static_cast<size_t>(end - buffer));
-        for (char* p = buffer; p != end; ++p)
-            PutUnsafe(*os_, static_cast<typename TargetEncoding::Ch>(*p));
+        PutNumber(buffer, end);
         return true;
     }
 
@@ -335,10 +321,8 @@ protected:
         }
 
         char buffer[25];
-        char* end = internal::dtoa(d, buffer, maxDecimalPlaces_);
-        PutReserve(*os_, static_cast<size_t>(end - buffer));
-        for (char* p = buffer; p != end; ++p)
-            PutUnsafe(*os_, static_cast<typename TargetEncoding::Ch>(*p));
+        char* end = (writeFlags & kWriteShortestDoubleFlag) ? internal::dtoaShortest(d, buffer, maxDecimalPlaces_) : internal::dtoa(d, buffer, maxDecimalPlaces_);
+        PutNumber(buffer, end);
         return true;
     }
 
@@ -416,10 +400,47 @@ protected:
         return true;
     }
 
+    //! Puts the ASCII text of a number, in one block when the stream takes char.
+    void PutNumber(const char* buffer, const char* end) {
+        PutReserve(*os_, static_cast<size_t>(end - buffer));
+        PutNumber(buffer, end, internal::BoolType<internal::IsSame<typename OutputStream::Ch, char>::Value>());
+    }
+
+    void PutNumber(const char* buffer, const char* end, internal::FalseType) {
+        for (const char* p = buffer; p != end; ++p)
+            PutUnsafe(*os_, static_cast<typename TargetEncoding::Ch>(*p));
+    }
+
+    void PutNumber(const char* buffer, const char* end, internal::TrueType) {
+        PutUnsafeN(*os_, buffer, static_cast<size_t>(end - buffer));
+    }
+
+    //! Whether unescaped runs can be copied verbatim (UTF-8 to UTF-8 without validation).
+    static const bool kBulkCopy = internal::IsSame<SourceEncoding, UTF8<> >::Value && internal::IsSame<TargetEncoding, UTF8<> >::Value && !(writeFlags & kWriteValidateEncodingFlag);
+
     bool ScanWriteUnescapedString(GenericStringStream<SourceEncoding>& is, size_t length) {
+        return ScanWriteUnescapedString(is, length, internal::BoolType<kBulkCopy>());
+    }
+
+    bool ScanWriteUnescapedString(GenericStringStream<SourceEncoding>& is, size_t length, internal::FalseType) {
         return RAPIDJSON_LIKELY(is.Tell() < length);
     }
 
+    // Copy the run up to the next character to escape in one block; consecutive escapes skip the scan
+    bool ScanWriteUnescapedString(GenericStringStream<SourceEncoding>& is, size_t length, internal::TrueType) {
+        const char* p = reinterpret_cast<const char*>(is.src_);
+        const char* end = reinterpret_cast<const char*>(is.head_) + length;
+        if (p == end)
+            return false;
+        if (internal::SimdIsStringStop(*p))
+            return true;
+
+        const char* q = internal::ScanStringBounded(p, end);
+        PutUnsafeN(*os_, p, static_cast<size_t>(q - p));
+        is.src_ = reinterpret_cast<const Ch*>(q);
+        return RAPIDJSON_LIKELY(q != end);
+    }
+
     bool WriteStartObject() { os_->Put('{'); return true; }
     bool WriteEndObject()   { os_->Put('}'); return true; }
     bool WriteStartArray()  { os_->Put('['); return true; }
@@ -529,74 +550,11 @@ inline bool Writer<StringBuffer>::WriteDouble(double d) {
     }
     
     char *buffer = os_->Push(25);
-    char* end = internal::dtoa(d, buffer, maxDecimalPlaces_);
+    char* end = (kWriteDefaultFlags & kWriteShortestDoubleFlag) ? internal::dtoaShortest(d, buffer, maxDecimalPlaces_) : internal::dtoa(d, buffer, maxDecimalPlaces_);
     os_->Pop(static_cast<size_t>(25 - (end - buffer)));
     return true;
 }
 
-#if defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SSE42)
-template<>
-inline bool Writer<StringBuffer>::ScanWriteUnescapedString(StringStream& is, size_t length) {
-    if (length < 16)
-        return RAPIDJSON_LIKELY(is.Tell() < length);
-
-    if (!RAPIDJSON_LIKELY(is.Tell() < length))
-        return false;
-
-    const char* p = is.src_;
-    const char* end = is.head_ + length;
-    const char* nextAligned = reinterpret_cast<const char*>((reinterpret_cast<size_t>(p) + 15) & static_cast<size_t>(~15));
-    const char* endAligned = reinterpret_cast<const char*>(reinterpret_cast<size_t>(end) & static_cast<size_t>(~15));
-    if (nextAligned > end)
-        return true;
-
-    while (p != nextAligned)
-        if (*p < 0x20 || *p == '\"' || *p == '\\') {
-            is.src_ = p;
-            return RAPIDJSON_LIKELY(is.Tell() < length);
-        }
-        else
-            os_->PutUnsafe(*p++);
-
-    // The rest of string using SIMD
-    static const char dquote[16] = { '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"', '\"' };
-    static const char bslash[16] = { '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\', '\\' };
-    static const char space[16]  = { 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19, 0x19 };
-    const __m128i dq = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&dquote[0]));
-    const __m128i bs = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&bslash[0]));
-    const __m128i sp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&space[0]));
-
-    for (; p != endAligned; p += 16) {
-        const __m128i s = _mm_load_si128(reinterpret_cast<const __m128i *>(p));
-        const __m128i t1 = _mm_cmpeq_epi8(s, dq);
-        const __m128i t2 = _mm_cmpeq_epi8(s, bs);
-        const __m128i t3 = _mm_cmpeq_epi8(_mm_max_epu8(s, sp), sp); // s < 0x20 <=> max(s, 0x19) == 0x19
-        const __m128i x = _mm_or_si128(_mm_or_si128(t1, t2), t3);
-        unsigned short r = static_cast<unsigned short>(_mm_movemask_epi8(x));
-        if (RAPIDJSON_UNLIKELY(r != 0)) {   // some of characters is escaped
-            SizeType len;
-#ifdef _MSC_VER         // Find the index of first escaped
-            unsigned long offset;
-            _BitScanForward(&offset, r);
-            len = offset;
-#else
-            len = static_cast<SizeType>(__builtin_ffs(r) - 1);
-#endif
-            char* q = reinterpret_cast<char*>(os_->PushUnsafe(len));
-            for (size_t i = 0; i < len; i++)
-                q[i] = p[i];
-
-            p += len;
-            break;
-        }
-        _mm_storeu_si128(reinterpret_cast<__m128i *>(os_->PushUnsafe(16)), s);
-    }
-
-    is.src_ = p;
-    return RAPIDJSON_LIKELY(is.Tell() < length);
-}
-#endif // defined(RAPIDJSON_SSE2) || defined(RAPIDJSON_SSE42)
-
 RAPIDJSON_NAMESPACE_END
 
 #ifdef _MSC_VER
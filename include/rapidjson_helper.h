@@ -21,253 +21,232 @@
 #include <rapidjson/error/en.h>
 #include <rapidjson/filereadstream.h>
 #include <rapidjson/filewritestream.h>
+#include <rapidjson/hugepageallocator.h>
 #include <rapidjson/istreamwrapper.h>
+#include <rapidjson/pointer.h>
 #include <rapidjson/prettywriter.h>
+#include <rapidjson/schema.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <chrono>
+#include <cmath>
 #include <cstdio>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace rapidjsonHelper {
-	namespace details {
-		inline std::optional<int> getInt(const rapidjson::Value& value, const std::string& key) {
-			// checking member exists
-			if (!value.HasMember(key.c_str()))
-				return std::nullopt;
-
-			//getting member reference
-			const rapidjson::Value& member = value[key.c_str()];
-
-			// checking for integer
-			if (member.IsInt() == false)
-				return std::nullopt;
-
-			// making optional with value
-			return std::optional<int>{member.GetInt()};
-		}
-
-		inline std::optional<int64_t> getInt64(const rapidjson::Value& value, const std::string& key) {
-			// checking member exists
-			if (!value.HasMember(key.c_str()))
-				return std::nullopt;
-
-			//getting member reference
-			const rapidjson::Value& member = value[key.c_str()];
+	// document whose pool takes its chunks from 2 MB huge-page regions (see rapidjson/hugepageallocator.h); it
+	// speeds up random access into large documents, not parsing
+	using HugePageDocument = rapidjson::GenericDocument<rapidjson::UTF8<>, rapidjson::MemoryPoolAllocator<rapidjson::HugePageAllocator>>;
 
-			// checking for integer
-			if (member.IsInt64() == false)
-				return std::nullopt;
-
-			// making optional with value
-			return std::optional<int64_t>{member.GetInt64()};
-		}
-
-		inline std::optional<unsigned int> getUint(const rapidjson::Value& value, const std::string& key) {
-			// checking member exists
-			if (!value.HasMember(key.c_str()))
-				return std::nullopt;
-
-			//getting member reference
-			const rapidjson::Value& member = value[key.c_str()];
-
-			// checking for integer
-			if (member.IsUint() == false)
-				return std::nullopt;
-
-			// making optional with value
-			return std::optional<unsigned int>{member.GetUint()};
-		}
-
-		inline std::optional<uint64_t> getUint64(const rapidjson::Value& value, const std::string& key) {
-			// checking member exists
-			if (!value.HasMember(key.c_str()))
-				return std::nullopt;
-
-			//getting member reference
-			const rapidjson::Value& member = value[key.c_str()];
-
-			// checking for integer
-			if (member.IsUint64() == false)
-				return std::nullopt;
+	namespace details {
+		// value type of a GenericValue or GenericDocument argument
+		template<class T>
+		using ValueTypeOf = typename std::remove_cvref_t<T>::ValueType;
 
-			// making optional with value
-			return std::optional<uint64_t>{member.GetUint64()};
+		template<class T>
+		inline std::optional<T> getAs(const auto& member) {
+			// checking for the requested type
+			if constexpr (std::is_same_v<T, int>) {
+				if (member.IsInt())
+					return member.GetInt();
+			}
+			else if constexpr (std::is_same_v<T, int64_t>) {
+				if (member.IsInt64())
+					return member.GetInt64();
+			}
+			else if constexpr (std::is_same_v<T, unsigned int>) {
+				if (member.IsUint())
+					return member.GetUint();
+			}
+			else if constexpr (std::is_same_v<T, uint64_t>) {
+				if (member.IsUint64())
+					return member.GetUint64();
+			}
+			else if constexpr (std::is_same_v<T, std::string>) {
+				if (member.IsString())
+					return std::string{member.GetString()};
+			}
+			else if constexpr (std::is_same_v<T, double>) {
+				if (member.IsDouble())
+					return member.GetDouble();
+			}
+			else if constexpr (std::is_same_v<T, float>) {
+				if (member.IsFloat())
+					return member.GetFloat();
+			}
+			else if constexpr (std::is_same_v<T, bool>) {
+				if (member.IsBool())
+					return member.GetBool();
+			}
+			return std::nullopt;
 		}
 
-		inline std::optional<std::string> getString(const rapidjson::Value& value, const std::string& key) {
-			// checking member exists
-			if (!value.HasMember(key.c_str()))
-				return std::nullopt;
-
-			//getting member reference
-			const rapidjson::Value& member = value[key.c_str()];
-
-			// checking for integer
-			if (member.IsString() == false)
+		template<class T>
+		inline std::optional<T> getValue(const auto& value, const std::string& key) {
+			// checking member exists (a single lookup, the name length is known)
+			const ValueTypeOf<decltype(value)> name(rapidjson::StringRef(key.data(), static_cast<rapidjson::SizeType>(key.size())));
+			auto it = value.FindMember(name);
+			if (it == value.MemberEnd())
 				return std::nullopt;
-
-			// making optional with value
-			return std::string{member.GetString()};
+			return getAs<T>(it->value);
 		}
+	}
 
-		inline std::optional<double> getDouble(const rapidjson::Value& value, const std::string& key) {
-			// checking member exists
-			if (!value.HasMember(key.c_str()))
-				return std::nullopt;
-
-			//getting member reference
-			const rapidjson::Value& member = value[key.c_str()];
-
-			// checking for integer
-			if (member.IsDouble() == false)
-				return std::nullopt;
-
-			// making optional with value
-			return member.GetDouble();
-		}
-
-		inline std::optional<float> getFloat(const rapidjson::Value& value, const std::string& key) {
-			// checking member exists
-			if (!value.HasMember(key.c_str()))
-				return std::nullopt;
-
-			//getting member reference
-			const rapidjson::Value& member = value[key.c_str()];
+	// Lookup-site cache for reading the same key from many objects sharing a layout (e.g. the rows
+	// of a table): the member position where the key was found last is checked first, and
+	// FindMember is only used on a miss, like an inline cache of a JS engine.
+	struct MemberCache {
+		explicit MemberCache(std::string key) : key(std::move(key)) {}
 
-			// checking for integer
-			if (member.IsFloat() == false)
-				return std::nullopt;
+		std::string key;
+		rapidjson::SizeType position{};
+		size_t hits{};
+		size_t misses{};
+	};
 
-			// making optional with value
-			return member.GetFloat();
+	inline auto findMember(auto& value, MemberCache& cache) {
+		assert(value.IsObject());
+		if (cache.position < value.MemberCount()) {
+			auto it = value.MemberBegin() + cache.position;
+			if (it->name.GetStringLength() == cache.key.size() && std::memcmp(it->name.GetString(), cache.key.data(), cache.key.size()) == 0) {
+				cache.hits++;
+				return it;
+			}
 		}
 
-		inline std::optional<bool> getBool(const rapidjson::Value& value, const std::string& key) {
-			// checking member exists
-			if (!value.HasMember(key.c_str()))
-				return std::nullopt;
-
-			//getting member reference
-			const rapidjson::Value& member = value[key.c_str()];
-
-			// checking for integer
-			if (member.IsBool() == false)
-				return std::nullopt;
-
-			// making optional with value
-			return member.GetBool();
-		}
+		cache.misses++;
+		const details::ValueTypeOf<decltype(value)> name(rapidjson::StringRef(cache.key.data(), static_cast<rapidjson::SizeType>(cache.key.size())));
+		auto it = value.FindMember(name);
+		if (it != value.MemberEnd())
+			cache.position = static_cast<rapidjson::SizeType>(it - value.MemberBegin());
+		return it;
+	}
 
-		template<class T>
-		inline std::optional<T> getValue(const rapidjson::Value& value, const std::string& key) {
-			if constexpr (std::is_same_v<T, int>)
-				return getInt(value, key);
-			else if constexpr (std::is_same_v<T, int64_t>)
-				return getInt64(value, key);
-			else if constexpr (std::is_same_v<T, unsigned int>)
-				return getUint(value, key);
-			else if constexpr (std::is_same_v<T, uint64_t>)
-				return getUint64(value, key);
-			else if constexpr (std::is_same_v<T, std::string>)
-				return getString(value, key);
-			else if constexpr (std::is_same_v<T, double>)
-				return getDouble(value, key);
-			else if constexpr (std::is_same_v<T, float>)
-				return getFloat(value, key);
-			else if constexpr (std::is_same_v<T, bool>)
-				return getBool(value, key);
-			else
-				return std::nullopt;
-		}
+	template<class T>
+	inline T getValue(auto& value, MemberCache& cache) {
+		auto it = findMember(value, cache);
+		auto ret = it != value.MemberEnd() ? details::getAs<T>(it->value) : std::nullopt;
+		if (!ret)
+			std::fprintf(stderr, "RAPIDJSON HELPER: FAILED TO OBTAIN VALUE BY KEY %s\n", cache.key.c_str());
+		return ret.value_or(T{});
 	}
 
 	template<class T>
-	inline T getValue(rapidjson::Value& value, const std::string& key) {
+	inline T getValue(auto& value, const std::string& key) {
 		auto ret = details::getValue<T>(value, key);
 		if (!ret)
 			std::fprintf(stderr, "RAPIDJSON HELPER: FAILED TO OBTAIN VALUE BY KEY %s\n", key.c_str());
 		return ret.value_or(T{});
 	}
 
-	inline void insertValue(rapidjson::Value& value, const std::string& key, const int& insertValue, auto&& allocator) {
+	// elements of a packed array (kParsePackedArraysFlag) of int64_t or double, empty for any other value
+	template<class T>
+	inline std::span<const T> getPackedArray(const auto& value) {
+		if constexpr (std::is_same_v<T, int64_t>) {
+			if (value.IsInt64Array())
+				return {value.GetInt64Array(), value.Size()};
+		}
+		else {
+			static_assert(std::is_same_v<T, double>, "packed arrays hold int64_t or double values");
+			if (value.IsDoubleArray())
+				return {value.GetDoubleArray(), value.Size()};
+		}
+		return {};
+	}
+
+	inline void insertValue(auto& value, const std::string& key, const int& insertValue, auto&& allocator) {
 		assert(value.IsObject());
-		rapidjson::Value keyValue;
+		details::ValueTypeOf<decltype(value)> keyValue;
 		keyValue.SetString(key.c_str(), allocator);
-		rapidjson::Value newValue;
+		details::ValueTypeOf<decltype(value)> newValue;
 		newValue.SetInt(insertValue);
 		value.AddMember(keyValue, newValue, allocator);
 	}
 
-	inline void insertValue(rapidjson::Value& value, const std::string& key, const int64_t& insertValue, auto&& allocator) {
+	inline void insertValue(auto& value, const std::string& key, const int64_t& insertValue, auto&& allocator) {
 		assert(value.IsObject());
-		rapidjson::Value keyValue;
+		details::ValueTypeOf<decltype(value)> keyValue;
 		keyValue.SetString(key.c_str(), allocator);
-		rapidjson::Value newValue;
+		details::ValueTypeOf<decltype(value)> newValue;
 		newValue.SetInt64(insertValue);
 		value.AddMember(keyValue, newValue, allocator);
 	}
 
-	inline void insertValue(rapidjson::Value& value, const std::string& key, const unsigned int& insertValue, auto&& allocator) {
+	inline void insertValue(auto& value, const std::string& key, const unsigned int& insertValue, auto&& allocator) {
 		assert(value.IsObject());
-		rapidjson::Value keyValue;
+		details::ValueTypeOf<decltype(value)> keyValue;
 		keyValue.SetString(key.c_str(), allocator);
-		rapidjson::Value newValue;
+		details::ValueTypeOf<decltype(value)> newValue;
 		newValue.SetUint(insertValue);
 		value.AddMember(keyValue, newValue, allocator);
 	}
 
-	inline void insertValue(rapidjson::Value& value, const std::string& key, const uint64_t& insertValue, auto&& allocator) {
+	inline void insertValue(auto& value, const std::string& key, const uint64_t& insertValue, auto&& allocator) {
 		assert(value.IsObject());
-		rapidjson::Value keyValue;
+		details::ValueTypeOf<decltype(value)> keyValue;
 		keyValue.SetString(key.c_str(), allocator);
-		rapidjson::Value newValue;
+		details::ValueTypeOf<decltype(value)> newValue;
 		newValue.SetUint64(insertValue);
 		value.AddMember(keyValue, newValue, allocator);
 	}
 
-	inline void insertValue(rapidjson::Value& value, const std::string& key, const double& insertValue, auto&& allocator) {
+	inline void insertValue(auto& value, const std::string& key, const double& insertValue, auto&& allocator) {
 		assert(value.IsObject());
-		rapidjson::Value keyValue;
+		details::ValueTypeOf<decltype(value)> keyValue;
 		keyValue.SetString(key.c_str(), allocator);
-		rapidjson::Value newValue;
+		details::ValueTypeOf<decltype(value)> newValue;
 		newValue.SetDouble(insertValue);
 		value.AddMember(keyValue, newValue, allocator);
 	}
 
-	inline void insertValue(rapidjson::Value& value, const std::string& key, const float& insertValue, auto&& allocator) {
+	inline void insertValue(auto& value, const std::string& key, const float& insertValue, auto&& allocator) {
 		assert(value.IsObject());
-		rapidjson::Value keyValue;
+		details::ValueTypeOf<decltype(value)> keyValue;
 		keyValue.SetString(key.c_str(), allocator);
-		rapidjson::Value newValue;
+		details::ValueTypeOf<decltype(value)> newValue;
 		newValue.SetFloat(insertValue);
 		value.AddMember(keyValue, newValue, allocator);
 	}
 
-	inline void insertValue(rapidjson::Value& value, const std::string& key, const bool& insertValue, auto&& allocator) {
+	inline void insertValue(auto& value, const std::string& key, const bool& insertValue, auto&& allocator) {
 		assert(value.IsObject());
-		rapidjson::Value keyValue;
+		details::ValueTypeOf<decltype(value)> keyValue;
 		keyValue.SetString(key.c_str(), allocator);
-		rapidjson::Value newValue;
+		details::ValueTypeOf<decltype(value)> newValue;
 		newValue.SetBool(insertValue);
 		value.AddMember(keyValue, newValue, allocator);
 	}
 
-	inline void insertValue(rapidjson::Value& value, const std::string& key, const std::string& insertValue, auto&& allocator) {
+	inline void insertValue(auto& value, const std::string& key, const std::string& insertValue, auto&& allocator) {
 		assert(value.IsObject());
-		rapidjson::Value keyValue;
+		details::ValueTypeOf<decltype(value)> keyValue;
 		keyValue.SetString(key.c_str(), allocator);
-		rapidjson::Value newValue;
+		details::ValueTypeOf<decltype(value)> newValue;
 		newValue.SetString(insertValue.c_str(), allocator);
 		value.AddMember(keyValue, newValue, allocator);
 	}
 
-	inline auto parseFromFile(rapidjson::Document & jsonDoc, const std::string_view& filename) {
+	template <unsigned parseFlags = rapidjson::kParseDefaultFlags>
+	inline auto parseFromFile(auto& jsonDoc, const std::string_view& filename) {
 		// 1. Open the JSON file
 		std::ifstream inFile(filename.data(), std::ios::in | std::ios::binary);
 		if (!inFile.is_open()) {
@@ -279,7 +258,7 @@ namespace rapidjsonHelper {
 		rapidjson::IStreamWrapper isw(inFile);
 
 		// 3. Parse the JSON string
-		jsonDoc.ParseStream(isw);
+		jsonDoc.template ParseStream<parseFlags>(isw);
 
 		// 4. Checking for parser errors
 		if (jsonDoc.HasParseError()) {
@@ -290,9 +269,10 @@ namespace rapidjsonHelper {
 		return true;
 	}
 
-	inline auto parseFromStream(rapidjson::Document & jsonDoc, const std::string_view& stream) {
+	template <unsigned parseFlags = rapidjson::kParseDefaultFlags>
+	inline auto parseFromStream(auto& jsonDoc, const std::string_view& stream) {
 		// Parse the JSON string
-		jsonDoc.Parse(stream.data());
+		jsonDoc.template Parse<parseFlags>(stream.data());
 
 		// Checking for parser errors
 		if (jsonDoc.HasParseError()) {
@@ -303,7 +283,161 @@ namespace rapidjsonHelper {
 		return true;
 	}
 
-	inline std::string writeToStream(rapidjson::Document& jsonDoc, bool prettify = false) {
+	// time of a schema-validated load: parsing and validation share a single SAX pass
+	struct LoadTiming {
+		double milliseconds{};
+		size_t bytes{};
+	};
+
+	namespace details {
+		template <unsigned parseFlags>
+		inline bool parseValidated(auto& jsonDoc, auto& is, const auto& schemaDoc, const std::string_view& source, LoadTiming* timing) {
+			using SchemaDocumentType = std::remove_cvref_t<decltype(schemaDoc)>;
+			using InputStream = std::remove_cvref_t<decltype(is)>;
+			const auto start = std::chrono::steady_clock::now();
+
+			// the validator sits between the reader and the document, which interns keys and packs arrays as
+			// the flags ask
+			rapidjson::SchemaValidatingReader<parseFlags, InputStream, typename SchemaDocumentType::EncodingType, SchemaDocumentType> reader(is, schemaDoc);
+			jsonDoc.template Populate<parseFlags>(reader);
+
+			if (timing) {
+				timing->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+				timing->bytes = is.Tell();
+			}
+
+			if (!reader.IsValid()) {
+				rapidjson::StringBuffer schemaPointer, documentPointer;
+				reader.GetInvalidSchemaPointer().StringifyUriFragment(schemaPointer);
+				reader.GetInvalidDocumentPointer().StringifyUriFragment(documentPointer);
+				std::fprintf(stderr, "JSON SCHEMA VALIDATION ERROR %s: keyword %s, schema %s, document %s\n",
+					source.data(), reader.GetInvalidSchemaKeyword(), schemaPointer.GetString(), documentPointer.GetString());
+				return false;
+			}
+
+			if (reader.GetParseResult().IsError()) {
+				std::fprintf(stderr, "JSON LOAD ERROR %s: [%d] %s\n", source.data(), (int)reader.GetParseResult().Code(), rapidjson::GetParseError_En(reader.GetParseResult().Code()));
+				return false;
+			}
+
+			return true;
+		}
+	}
+
+	// loads and validates against a compiled schema in the same pass
+	template <unsigned parseFlags = rapidjson::kParseDefaultFlags>
+	inline auto parseFromFile(auto& jsonDoc, const std::string_view& filename, const auto& schemaDoc, LoadTiming* timing = nullptr) {
+		std::ifstream inFile(filename.data(), std::ios::in | std::ios::binary);
+		if (!inFile.is_open()) {
+			std::cerr << "Error opening file: " << filename << std::endl;
+			return false;
+		}
+
+		rapidjson::IStreamWrapper isw(inFile);
+		return details::parseValidated<parseFlags>(jsonDoc, isw, schemaDoc, filename, timing);
+	}
+
+	template <unsigned parseFlags = rapidjson::kParseDefaultFlags>
+	inline auto parseFromStream(auto& jsonDoc, const std::string_view& stream, const auto& schemaDoc, LoadTiming* timing = nullptr) {
+		rapidjson::StringStream ss(stream.data());
+		return details::parseValidated<parseFlags>(jsonDoc, ss, schemaDoc, stream, timing);
+	}
+
+	// hands out schema validators to concurrent callers; a returned validator keeps its
+	// sub-validators, state buffers and regex search state, so steady-state validation
+	// does not allocate and the shared schema document is only ever read
+	template <class SchemaDocumentType = rapidjson::SchemaDocument>
+	class ValidatorPool {
+	public:
+		using Validator = rapidjson::GenericSchemaValidator<SchemaDocumentType>;
+
+		explicit ValidatorPool(const SchemaDocumentType& schemaDoc) : schemaDoc(schemaDoc) {}
+
+		// exclusive use of one validator, returned to the pool on destruction
+		class Lease {
+		public:
+			Lease(ValidatorPool& pool, std::unique_ptr<Validator> validator) : pool(&pool), validator(std::move(validator)) {}
+			Lease(Lease&&) = default;
+			// the validator held so far goes back to its pool
+			Lease& operator=(Lease&& other) {
+				if (this != &other) {
+					if (validator)
+						pool->release(std::move(validator));
+					pool = other.pool;
+					validator = std::move(other.validator);
+				}
+				return *this;
+			}
+			~Lease() {
+				if (validator)
+					pool->release(std::move(validator));
+			}
+
+			Validator& operator*() const { return *validator; }
+			Validator* operator->() const { return validator.get(); }
+
+		private:
+			ValidatorPool* pool;
+			std::unique_ptr<Validator> validator;
+		};
+
+		Lease acquire() {
+			std::unique_ptr<Validator> validator;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!idle.empty()) {
+					validator = std::move(idle.back());
+					idle.pop_back();
+				}
+			}
+			if (!validator)
+				validator = std::make_unique<Validator>(schemaDoc);
+			validator->Reset();
+			return Lease(*this, std::move(validator));
+		}
+
+		// number of idle validators
+		size_t size() {
+			std::lock_guard<std::mutex> lock(mutex);
+			return idle.size();
+		}
+
+	private:
+		void release(std::unique_ptr<Validator> validator) {
+			std::lock_guard<std::mutex> lock(mutex);
+			idle.push_back(std::move(validator));
+		}
+
+		const SchemaDocumentType& schemaDoc;
+		std::mutex mutex;
+		std::vector<std::unique_ptr<Validator>> idle;
+	};
+
+	// validates an in-memory value with a pooled validator
+	template <class SchemaDocumentType>
+	inline bool validate(const auto& value, ValidatorPool<SchemaDocumentType>& pool) {
+		auto validator = pool.acquire();
+		if (value.Accept(*validator))
+			return true;
+
+		rapidjson::StringBuffer schemaPointer, documentPointer;
+		validator->GetInvalidSchemaPointer().StringifyUriFragment(schemaPointer);
+		validator->GetInvalidDocumentPointer().StringifyUriFragment(documentPointer);
+		std::fprintf(stderr, "JSON SCHEMA VALIDATION ERROR: keyword %s, schema %s, document %s\n",
+			validator->GetInvalidSchemaKeyword(), schemaPointer.GetString(), documentPointer.GetString());
+		return false;
+	}
+
+	// 64-bit content hash for cache keys and change detection: member order does not
+	// matter and equal integer and floating point numbers hash alike (same hash as schema enum/uniqueItems)
+	inline uint64_t hashValue(const auto& value) {
+		using Encoding = typename details::ValueTypeOf<decltype(value)>::EncodingType;
+		rapidjson::internal::Hasher<Encoding, rapidjson::CrtAllocator> hasher;
+		value.Accept(hasher);
+		return hasher.GetHashCode();
+	}
+
+	inline std::string writeToStream(auto& jsonDoc, bool prettify = false) {
 		// making json string
 		rapidjson::StringBuffer buffer;
 		buffer.Clear();
@@ -321,7 +455,7 @@ namespace rapidjsonHelper {
 		return std::string(buffer.GetString(), buffer.GetSize());
 	}
 
-	inline bool writeToFile(rapidjson::Document& jsonDoc, const std::string_view& filename, bool prettify = false) {
+	inline bool writeToFile(auto& jsonDoc, const std::string_view& filename, bool prettify = false) {
 		// opening stream
 		std::ofstream stream(filename.data(), std::ios::out | std::ios::binary);
 		if (!stream.is_open()) {
@@ -337,6 +471,1775 @@ namespace rapidjsonHelper {
 		stream.close();
 		return true;
 	}
+
+	struct MemoryReport {
+		// objects: member arrays are sized by capacity, not by member count
+		size_t objectCount{};
+		size_t memberCount{};
+		size_t memberBytes{};
+
+		// arrays: element buffers are sized by capacity, not by element count
+		size_t arrayCount{};
+		size_t elementCount{};
+		size_t elementBytes{};
+		size_t packedArrayCount{}; // arrays stored as int64_t / double buffers (kParsePackedArraysFlag)
+
+		// strings (values and keys) stored outside of the value, terminator included
+		size_t stringCount{};
+		size_t stringBytes{};
+
+		// strings stored inline inside the value (no allocation)
+		size_t shortStringCount{};
+		size_t shortStringBytes{};
+
+		// strings pointing to storage already counted above (keys interned by kParseInternKeysFlag)
+		size_t sharedStringCount{};
+		size_t sharedStringBytes{};
+
+		// allocator totals
+		size_t allocatorCapacity{};
+		size_t allocatorSize{};
+#if RAPIDJSON_ALLOCATOR_STATS
+		rapidjson::AllocatorStats allocatorStats;
+#endif
+	};
+
+	namespace details {
+		// short strings live inside the value itself
+		inline bool isShortString(const auto& value) {
+			const auto* str = reinterpret_cast<const char*>(value.GetString());
+			const auto* base = reinterpret_cast<const char*>(&value);
+			return str >= base && str < base + sizeof(value);
+		}
+
+		inline void addString(MemoryReport& report, const auto& value, std::unordered_set<const void*>& seen) {
+			const auto* str = value.GetString();
+			if (isShortString(value)) {
+				report.shortStringCount++;
+				report.shortStringBytes += value.GetStringLength();
+				return;
+			}
+
+			// the same storage referenced again
+			if (!seen.insert(str).second) {
+				report.sharedStringCount++;
+				report.sharedStringBytes += value.GetStringLength() + 1;
+				return;
+			}
+
+			report.stringCount++;
+			report.stringBytes += value.GetStringLength() + 1;
+		}
+
+		inline void addValue(MemoryReport& report, const auto& value, std::unordered_set<const void*>& seen) {
+			if (value.IsObject()) {
+				report.objectCount++;
+				report.memberCount += value.MemberCount();
+				report.memberBytes += ValueTypeOf<decltype(value)>::MemberStorageSize(value.MemberCapacity());
+				for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+					addString(report, it->name, seen);
+					addValue(report, it->value, seen);
+				}
+			}
+			else if (value.GetType() == rapidjson::kArrayType) {
+				report.arrayCount++;
+				report.elementCount += value.Size();
+				if (value.IsPackedArray()) {
+					// 8-byte int64_t / double elements
+					report.packedArrayCount++;
+					report.elementBytes += value.Capacity() * sizeof(int64_t);
+					return;
+				}
+				report.elementBytes += ValueTypeOf<decltype(value)>::ElementStorageSize(value.Capacity());
+				for (auto& elem : value.GetArray())
+					addValue(report, elem, seen);
+			}
+			else if (value.IsString()) {
+				addString(report, value, seen);
+			}
+		}
+	}
+
+	inline MemoryReport memoryReport(const auto& jsonDoc) {
+		MemoryReport report;
+
+		// walking the whole tree
+		std::unordered_set<const void*> seen;
+		details::addValue(report, jsonDoc, seen);
+
+		// collecting allocator info
+		const auto& allocator = jsonDoc.GetAllocator();
+		report.allocatorCapacity = allocator.Capacity();
+		report.allocatorSize = allocator.Size();
+#if RAPIDJSON_ALLOCATOR_STATS
+		report.allocatorStats = allocator.GetStats();
+#endif
+		return report;
+	}
+
+	namespace details {
+		// keys sharing their storage (kParseInternKeysFlag) are counted and copied once, other keys are copied per member
+		struct SharedKeyHash {
+			size_t operator()(const std::pair<const void*, size_t>& key) const { return std::hash<const void*>()(key.first) ^ key.second; }
+		};
+		using SharedKeys = std::unordered_map<std::pair<const void*, size_t>, const void*, SharedKeyHash>;
+
+		inline size_t compactSize(const auto& value, SharedKeys& keys) {
+			if (value.IsObject()) {
+				size_t size = RAPIDJSON_ALIGN(ValueTypeOf<decltype(value)>::MemberStorageSize(value.MemberCount()));
+				for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+					if (it->name.IsSharedString() && !keys.emplace(std::make_pair(it->name.GetString(), it->name.GetStringLength()), nullptr).second)
+						size += compactSize(it->value, keys);
+					else
+						size += compactSize(it->name, keys) + compactSize(it->value, keys);
+				}
+				return size;
+			}
+
+			if (value.IsPackedArray())
+				return RAPIDJSON_ALIGN(value.Size() * sizeof(int64_t));
+
+			if (value.IsArray()) {
+				size_t size = RAPIDJSON_ALIGN(ValueTypeOf<decltype(value)>::ElementStorageSize(value.Size()));
+				for (auto& elem : value.GetArray())
+					size += compactSize(elem, keys);
+				return size;
+			}
+
+			if (value.IsString() && !isShortString(value))
+				return RAPIDJSON_ALIGN((value.GetStringLength() + 1) * sizeof(typename ValueTypeOf<decltype(value)>::Ch));
+
+			return 0;
+		}
+
+		inline auto relocateKey(const auto& src, auto& allocator, SharedKeys& keys) {
+			using Value = ValueTypeOf<decltype(src)>;
+			using Ch = typename Value::Ch;
+			if (!src.IsSharedString())
+				return Value(src.GetString(), src.GetStringLength(), allocator);
+
+			// copied on first occurrence, every occurrence shares the copy
+			auto& copy = keys[std::make_pair(src.GetString(), src.GetStringLength())];
+			if (!copy) {
+				const size_t size = src.GetStringLength() * sizeof(Ch);
+				auto* str = static_cast<Ch*>(allocator.Malloc(size + sizeof(Ch)));
+				std::memcpy(str, src.GetString(), size);
+				str[src.GetStringLength()] = 0;
+				copy = str;
+			}
+			Value key;
+			key.SetSharedString(rapidjson::StringRef(static_cast<const Ch*>(copy), src.GetStringLength()));
+			return key;
+		}
+
+		// copies the tree in depth-first order: every container buffer is allocated right before its children
+		inline void relocate(auto& dst, const auto& src, auto& allocator, SharedKeys& keys) {
+			if (src.IsObject()) {
+				dst.SetObject();
+				dst.MemberReserve(src.MemberCount(), allocator);
+				for (auto it = src.MemberBegin(); it != src.MemberEnd(); ++it) {
+					ValueTypeOf<decltype(dst)> name = relocateKey(it->name, allocator, keys);
+					ValueTypeOf<decltype(dst)> value;
+					relocate(value, it->value, allocator, keys);
+					dst.AddMember(name, value, allocator);
+				}
+			}
+			else if (src.IsInt64Array())
+				dst.SetInt64Array(src.GetInt64Array(), src.Size(), allocator);
+			else if (src.IsDoubleArray())
+				dst.SetDoubleArray(src.GetDoubleArray(), src.Size(), allocator);
+			else if (src.IsArray()) {
+				dst.SetArray();
+				dst.Reserve(src.Size(), allocator);
+				for (auto& elem : src.GetArray()) {
+					ValueTypeOf<decltype(dst)> value;
+					relocate(value, elem, allocator, keys);
+					dst.PushBack(value, allocator);
+				}
+			}
+			else {
+				dst.CopyFrom(src, allocator);
+			}
+		}
+	}
+
+	// Rebuilds the document into an exactly sized arena and frees the old chunks.
+	// The document allocator must not be shared with other values.
+	// Returns the number of bytes reclaimed.
+	inline size_t compact(auto& jsonDoc) {
+		auto& allocator = jsonDoc.GetAllocator();
+		const size_t capacityBefore = allocator.Capacity();
+		details::SharedKeys keys;
+		const size_t size = details::compactSize(jsonDoc, keys);
+
+		// 1. building the compacted tree in a fresh arena, the document stays untouched on failure
+		typename std::remove_cvref_t<decltype(jsonDoc)>::AllocatorType compacted;
+		if (!compacted.Reserve(size))
+			return 0;
+		details::ValueTypeOf<decltype(jsonDoc)> tmp;
+		keys.clear();
+		details::relocate(tmp, jsonDoc, compacted, keys);
+
+		// 2. handing the arena to the document, the old chunks are freed along with `compacted`
+		allocator.Swap(compacted);
+		static_cast<details::ValueTypeOf<decltype(jsonDoc)>&>(jsonDoc) = tmp;
+
+		const size_t capacityAfter = allocator.Capacity();
+		return capacityBefore > capacityAfter ? capacityBefore - capacityAfter : 0;
+	}
+
+	// one bit per row, row i at bit i % 64 of word i / 64
+	using Bitmap = std::vector<uint64_t>;
+
+	// A field of an array of objects stored as a typed contiguous column.
+	// Rows without the field, or with a value of another type, are invalid (validity bit cleared)
+	// and hold 0 / an empty string.
+	struct Column {
+		// Unknown: no valid value seen, the column has no storage
+		enum class Type { Unknown, Int64, Double, String };
+
+		std::string name;
+		Type type = Type::Unknown;
+		size_t rowCount{};
+		size_t nullCount{};
+		Bitmap validity;
+
+		std::vector<int64_t> ints;
+		std::vector<double> doubles;
+		std::vector<uint32_t> offsets; // string of row i is blob[offsets[i], offsets[i + 1])
+		std::string blob;
+
+		bool isValid(size_t row) const { return (validity[row / 64] >> (row % 64)) & 1; }
+
+		std::string_view getString(size_t row) const {
+			assert(type == Type::String);
+			return std::string_view(blob).substr(offsets[row], offsets[row + 1] - offsets[row]);
+		}
+
+		template<class T>
+		std::span<const T> data() const {
+			if constexpr (std::is_same_v<T, int64_t>) {
+				assert(type == Type::Int64);
+				return ints;
+			}
+			else {
+				static_assert(std::is_same_v<T, double>, "columns hold int64_t or double values");
+				assert(type == Type::Double);
+				return doubles;
+			}
+		}
+	};
+
+	struct Columns {
+		size_t rowCount{};
+		std::vector<Column> columns;
+
+		const Column* find(std::string_view name) const {
+			for (auto& column : columns)
+				if (column.name == name)
+					return &column;
+			return nullptr;
+		}
+	};
+
+	namespace details {
+		// the validity words of all rows are allocated with the column
+		inline void pushValidity(Column& column, bool valid) {
+			column.validity[column.rowCount / 64] |= uint64_t(valid) << (column.rowCount % 64);
+			column.nullCount += !valid;
+			column.rowCount++;
+		}
+
+		inline void pushInvalid(Column& column) {
+			switch (column.type) {
+			case Column::Type::Int64: column.ints.push_back(0); break;
+			case Column::Type::Double: column.doubles.push_back(0.0); break;
+			case Column::Type::String: column.offsets.push_back(static_cast<uint32_t>(column.blob.size())); break;
+			default: break;
+			}
+			pushValidity(column, false);
+		}
+
+		inline void pushCell(Column& column, const auto& value, size_t rows) {
+			// a cell of the type of the column
+			switch (column.type) {
+			case Column::Type::Int64:
+				if (value.IsInt64()) {
+					column.ints.push_back(value.GetInt64());
+					pushValidity(column, true);
+					return;
+				}
+				break;
+			case Column::Type::Double:
+				if (value.IsNumber()) {
+					column.doubles.push_back(value.GetDouble());
+					pushValidity(column, true);
+					return;
+				}
+				break;
+			case Column::Type::String:
+				if (value.IsString()) {
+					column.blob.append(value.GetString(), value.GetStringLength());
+					column.offsets.push_back(static_cast<uint32_t>(column.blob.size()));
+					pushValidity(column, true);
+					return;
+				}
+				break;
+			default: break;
+			}
+
+			// first valid value decides the type and reserves all rows, integers turn into doubles when a
+			// double shows up
+			const auto type = value.IsInt64() ? Column::Type::Int64 : value.IsNumber() ? Column::Type::Double : value.IsString() ? Column::Type::String : Column::Type::Unknown;
+			if (type == Column::Type::Unknown) {
+				pushInvalid(column);
+				return;
+			}
+
+			if (column.type == Column::Type::Unknown) {
+				column.type = type;
+				if (type == Column::Type::Int64) {
+					column.ints.reserve(rows);
+					column.ints.assign(column.rowCount, 0);
+				}
+				else if (type == Column::Type::Double) {
+					column.doubles.reserve(rows);
+					column.doubles.assign(column.rowCount, 0.0);
+				}
+				else {
+					column.offsets.reserve(rows + 1);
+					column.offsets.assign(column.rowCount + 1, 0);
+					column.blob.reserve(rows * value.GetStringLength());
+				}
+			}
+			else if (column.type == Column::Type::Int64 && type == Column::Type::Double) {
+				column.type = Column::Type::Double;
+				column.doubles.reserve(rows);
+				column.doubles.assign(column.ints.begin(), column.ints.end());
+				column.ints = {};
+			}
+
+			if (column.type == Column::Type::Int64 && type == Column::Type::Int64)
+				column.ints.push_back(value.GetInt64());
+			else if (column.type == Column::Type::Double && type != Column::Type::String)
+				column.doubles.push_back(value.GetDouble());
+			else if (column.type == Column::Type::String && type == Column::Type::String) {
+				column.blob.append(value.GetString(), value.GetStringLength());
+				column.offsets.push_back(static_cast<uint32_t>(column.blob.size()));
+			}
+			else {
+				pushInvalid(column);
+				return;
+			}
+			pushValidity(column, true);
+		}
+	}
+
+	// Converts an array of objects into one column per field name, in a single pass over the rows; the
+	// storage of every column is sized from the row count up front.
+	inline Columns toColumns(const auto& array) {
+		assert(array.GetType() == rapidjson::kArrayType);
+		Columns result;
+		if (array.IsPackedArray()) {
+			// number rows have no fields
+			result.rowCount = array.Size();
+			return result;
+		}
+		std::unordered_map<std::string, size_t> byName;
+		std::vector<size_t> byPosition; // column of each member position in the previous row
+
+		for (auto& row : array.GetArray()) {
+			if (row.IsObject()) {
+				size_t position = 0;
+				for (auto it = row.MemberBegin(); it != row.MemberEnd(); ++it, ++position) {
+					const std::string_view name(it->name.GetString(), it->name.GetStringLength());
+
+					// rows of a table usually repeat the same layout
+					size_t index;
+					if (position < byPosition.size() && result.columns[byPosition[position]].name == name)
+						index = byPosition[position];
+					else {
+						auto [found, inserted] = byName.try_emplace(std::string(name), result.columns.size());
+						if (inserted) {
+							auto& column = result.columns.emplace_back();
+							column.name = name;
+							column.validity.assign((array.Size() + 63) / 64, 0);
+						}
+						index = found->second;
+						if (position >= byPosition.size())
+							byPosition.resize(position + 1);
+						byPosition[position] = index;
+					}
+
+					// missing rows before this one, a duplicated key keeps its first value
+					auto& column = result.columns[index];
+					while (column.rowCount < result.rowCount)
+						details::pushInvalid(column);
+					if (column.rowCount == result.rowCount)
+						details::pushCell(column, it->value, array.Size());
+				}
+			}
+			result.rowCount++;
+		}
+
+		for (auto& column : result.columns)
+			while (column.rowCount < result.rowCount)
+				details::pushInvalid(column);
+		return result;
+	}
+
+	// Column kernels: selected rows (valid, and set in the optional mask) are visited 64 at a time;
+	// fully selected words run a plain loop over independent lanes the compiler vectorizes,
+	// partially selected words a branch-free masked loop.
+	namespace details {
+		inline uint64_t selectedBits(const Column& column, const Bitmap* mask, size_t word) {
+			return column.validity[word] & (mask ? (*mask)[word] : ~uint64_t(0));
+		}
+
+		template<class T>
+		inline T reduceColumn(const Column& column, const Bitmap* mask, T init, auto op) {
+			assert(!mask || mask->size() == column.validity.size());
+			constexpr size_t kLanes = 8;
+			T lanes[kLanes];
+			for (auto& lane : lanes)
+				lane = init;
+
+			const auto values = column.data<T>();
+			for (size_t word = 0; word < column.validity.size(); word++) {
+				const uint64_t bits = selectedBits(column, mask, word);
+				const T* x = values.data() + word * 64;
+				if (bits == ~uint64_t(0)) {
+					for (size_t i = 0; i < 64; i += kLanes)
+						for (size_t j = 0; j < kLanes; j++)
+							lanes[j] = op(lanes[j], x[i + j]);
+				}
+				else if (bits) {
+					const size_t count = std::min<size_t>(64, values.size() - word * 64);
+					for (size_t i = 0; i < count; i++)
+						lanes[i % kLanes] = ((bits >> i) & 1) ? op(lanes[i % kLanes], x[i]) : lanes[i % kLanes];
+				}
+			}
+
+			T result = init;
+			for (auto lane : lanes)
+				result = op(result, lane);
+			return result;
+		}
+	}
+
+	// number of rows set in a bitmap (e.g. the result of filterColumn)
+	inline size_t countRows(const Bitmap& bitmap) {
+		size_t count = 0;
+		for (auto word : bitmap)
+			count += std::popcount(word);
+		return count;
+	}
+
+	template<class T>
+	inline T sumColumn(const Column& column, const Bitmap* mask = nullptr) {
+		return details::reduceColumn<T>(column, mask, T{}, [](T a, T b) { return a + b; });
+	}
+
+	// rows both valid and set in the optional mask
+	inline size_t countSelected(const Column& column, const Bitmap* mask = nullptr) {
+		size_t count = 0;
+		for (size_t word = 0; word < column.validity.size(); word++)
+			count += std::popcount(details::selectedBits(column, mask, word));
+		return count;
+	}
+
+	template<class T>
+	inline std::optional<T> minColumn(const Column& column, const Bitmap* mask = nullptr) {
+		if (countSelected(column, mask) == 0)
+			return std::nullopt;
+		return details::reduceColumn<T>(column, mask, std::numeric_limits<T>::max(), [](T a, T b) { return b < a ? b : a; });
+	}
+
+	template<class T>
+	inline std::optional<T> maxColumn(const Column& column, const Bitmap* mask = nullptr) {
+		if (countSelected(column, mask) == 0)
+			return std::nullopt;
+		return details::reduceColumn<T>(column, mask, std::numeric_limits<T>::lowest(), [](T a, T b) { return b > a ? b : a; });
+	}
+
+	// rows which are valid and for which predicate(value) holds
+	template<class T>
+	inline Bitmap filterColumn(const Column& column, auto predicate) {
+		const auto values = column.data<T>();
+		Bitmap result(column.validity.size());
+		for (size_t word = 0; word < result.size(); word++) {
+			const T* x = values.data() + word * 64;
+			const size_t count = std::min<size_t>(64, values.size() - word * 64);
+			uint64_t bits = 0;
+			for (size_t i = 0; i < count; i++)
+				bits |= uint64_t(predicate(x[i]) ? 1 : 0) << i;
+			result[word] = bits & column.validity[word];
+		}
+		return result;
+	}
+
+	// options of diff()
+	struct DiffOptions {
+		// member identifying the rows of arrays of objects (e.g. "vnum"): arrays whose elements all hold
+		// a value of it, distinct within the array, are matched by that value instead of by position
+		std::string arrayKey;
+	};
+
+	namespace details {
+		// counts of present slots, for the array indices of the rows while a patch is emitted
+		struct FenwickTree {
+			std::vector<int32_t> tree;
+
+			explicit FenwickTree(size_t size) : tree(size + 1, 0) {}
+
+			void add(size_t slot, int32_t delta) {
+				for (slot++; slot < tree.size(); slot += slot & (0 - slot))
+					tree[slot] += delta;
+			}
+
+			// present slots below slot
+			rapidjson::SizeType rank(size_t slot) const {
+				int32_t sum = 0;
+				for (; slot > 0; slot -= slot & (0 - slot))
+					sum += tree[slot];
+				return static_cast<rapidjson::SizeType>(sum);
+			}
+		};
+
+		// marks the elements of one longest strictly increasing subsequence
+		inline std::vector<bool> longestIncreasing(const std::vector<rapidjson::SizeType>& sequence) {
+			constexpr size_t none = ~size_t(0);
+			std::vector<size_t> tails, previous(sequence.size()); // tails[l]: smallest last element of a run of length l + 1
+			for (size_t i = 0; i < sequence.size(); i++) {
+				auto it = std::lower_bound(tails.begin(), tails.end(), sequence[i], [&](size_t t, rapidjson::SizeType v) { return sequence[t] < v; });
+				previous[i] = it == tails.begin() ? none : *(it - 1);
+				if (it == tails.end())
+					tails.push_back(i);
+				else
+					*it = i;
+			}
+			std::vector<bool> result(sequence.size());
+			for (size_t i = tails.empty() ? none : tails.back(); i != none; i = previous[i])
+				result[i] = true;
+			return result;
+		}
+
+		template<class Value, class Patch>
+		struct Differ {
+			using SizeType = rapidjson::SizeType;
+			using Pointer = rapidjson::GenericPointer<Value>;
+			using PatchValue = ValueTypeOf<Patch>;
+			static constexpr SizeType none = ~SizeType(0);
+
+			Patch& patch;
+			const Value keyName;
+			std::unordered_map<const Value*, uint64_t> containerHashes;  // of the objects and arrays reached so far
+
+			Differ(Patch& patch, const DiffOptions& options)
+				: patch(patch), keyName(rapidjson::StringRef(options.arrayKey.data(), static_cast<SizeType>(options.arrayKey.size()))) {}
+
+			PatchValue stringify(const Pointer& path) {
+				rapidjson::GenericStringBuffer<typename Value::EncodingType> buffer;
+				path.Stringify(buffer);
+				return PatchValue(buffer.GetString(), static_cast<SizeType>(buffer.GetSize() / sizeof(typename Value::Ch)), patch.GetAllocator());
+			}
+
+			void emit(const char* op, const Pointer& path, const Value* value = nullptr, const Pointer* from = nullptr) {
+				auto& allocator = patch.GetAllocator();
+				PatchValue operation(rapidjson::kObjectType);
+				operation.AddMember("op", rapidjson::StringRef(op), allocator);
+				if (from)
+					operation.AddMember("from", stringify(*from), allocator);
+				operation.AddMember("path", stringify(path), allocator);
+				if (value)
+					operation.AddMember("value", PatchValue(*value, allocator), allocator);
+				patch.PushBack(operation, allocator);
+			}
+
+			// structural hash, the same function as GetHash(), with the hash of each object and array computed once
+			// per diff: without RAPIDJSON_VALUE_HASH_CACHE, GetHash() rehashes the whole subtree on every call
+			uint64_t hashOf(const Value& v) {
+				const bool object = v.IsObject();
+				if (!object && !v.IsArray())
+					return v.GetHash();  // scalars and packed arrays hold no values
+				if (auto it = containerHashes.find(&v); it != containerHashes.end())
+					return it->second;
+				uint64_t h = rapidjson::internal::HashCombine(0, v.GetType());
+				if (object)
+					for (auto m = v.MemberBegin(); m != v.MemberEnd(); ++m)
+						h += rapidjson::internal::HashCombine(m->name.GetHash(), hashOf(m->value));
+				else
+					for (auto e = v.Begin(); e != v.End(); ++e)
+						h = rapidjson::internal::HashCombine(h, hashOf(*e));
+				return containerHashes[&v] = h;
+			}
+
+			// different hashes prove a difference, equal ones are confirmed (integers above 2^53 may collide); each
+			// subtree found equal is compared once and then skipped, so hashing and comparing take linear time
+			bool same(const Value& a, const Value& b) { return hashOf(a) == hashOf(b) && a == b; }
+
+			// a and b differ
+			void diffValue(const Value& a, const Value& b, const Pointer& path) {
+				if (a.IsObject() && b.IsObject())
+					diffObject(a, b, path);
+				else if (a.GetType() == rapidjson::kArrayType && b.GetType() == rapidjson::kArrayType) {
+					if (keyName.GetStringLength() == 0 || a.IsPackedArray() || b.IsPackedArray() || !diffKeyedArray(a, b, path))
+						diffArray(a, b, path);
+				}
+				else
+					emit("replace", path, &b);
+			}
+
+			void diffObject(const Value& a, const Value& b, const Pointer& path) {
+				for (auto m = a.MemberBegin(); m != a.MemberEnd(); ++m) {
+					auto n = b.FindMember(m->name);
+					if (n == b.MemberEnd())
+						emit("remove", path.Append(m->name));
+					else if (!same(m->value, n->value))
+						diffValue(m->value, n->value, path.Append(m->name));
+				}
+				for (auto n = b.MemberBegin(); n != b.MemberEnd(); ++n)
+					if (!a.HasMember(n->name))
+						emit("add", path.Append(n->name), &n->value);
+			}
+
+			// by position: equal head and tail are skipped, the rest is changed pairwise and the surplus removed or added;
+			// elements of packed arrays are read through ElementAt()
+			void diffArray(const Value& a, const Value& b, const Pointer& path) {
+				const SizeType n = a.Size(), m = b.Size();
+				Value scratchA, scratchB;
+				auto sameAt = [&](SizeType i, SizeType j) { return same(a.ElementAt(i, scratchA), b.ElementAt(j, scratchB)); };
+				SizeType head = 0, tail = 0;
+				while (head < n && head < m && sameAt(head, head))
+					head++;
+				while (tail < n - head && tail < m - head && sameAt(n - 1 - tail, m - 1 - tail))
+					tail++;
+
+				const SizeType common = std::min(n, m) - head - tail;
+				for (SizeType i = head; i < head + common; i++) {
+					const Value& x = a.ElementAt(i, scratchA);
+					const Value& y = b.ElementAt(i, scratchB);
+					if (!same(x, y))
+						diffValue(x, y, path.Append(i));
+				}
+				for (SizeType i = n - tail; i-- > head + common;)
+					emit("remove", path.Append(i));
+				for (SizeType i = head + common; i < m - tail; i++)
+					emit("add", path.Append(i), &b.ElementAt(i, scratchB));
+			}
+
+			const Value* keyOf(const Value& element) const {
+				if (!element.IsObject())
+					return nullptr;
+				auto it = element.FindMember(keyName);
+				return it != element.MemberEnd() ? &it->value : nullptr;
+			}
+
+			// by key: false (nothing emitted) unless every row holds a key, distinct within a
+			bool diffKeyedArray(const Value& a, const Value& b, const Pointer& path) {
+				const SizeType n = a.Size(), m = b.Size();
+
+				// open addressing table of the key hashes of a, each slot holding a row + 1
+				size_t mask = 15;
+				while (mask < size_t(n) * 2)
+					mask = mask * 2 + 1;
+				std::vector<SizeType> table(mask + 1, 0);
+				std::vector<const Value*> keys(n);
+				std::vector<uint64_t> hashes(n);
+				for (SizeType i = 0; i < n; i++) {
+					if (!(keys[i] = keyOf(a[i])))
+						return false;
+					hashes[i] = hashOf(*keys[i]);
+					size_t slot = hashes[i] & mask;
+					for (; table[slot] != 0; slot = (slot + 1) & mask)
+						if (hashes[table[slot] - 1] == hashes[i])
+							return false;
+					table[slot] = i + 1;
+				}
+
+				std::vector<SizeType> match(m, none), target(n, none); // row of a for each row of b, and back
+				for (SizeType j = 0; j < m; j++) {
+					const Value* key = keyOf(b[j]);
+					if (!key)
+						return false;
+					const uint64_t hash = hashOf(*key);
+					size_t slot = hash & mask;
+					while (table[slot] != 0 && hashes[table[slot] - 1] != hash)
+						slot = (slot + 1) & mask;
+					if (table[slot] == 0)
+						continue;
+					const SizeType i = table[slot] - 1;
+					if (target[i] != none || *keys[i] != *key)
+						return false;
+					match[j] = i;
+					target[i] = j;
+				}
+
+				// 1. rows missing from b, back to front so that the indices stay valid
+				for (SizeType i = n; i-- > 0;)
+					if (target[i] == none)
+						emit("remove", path.Append(i));
+
+				// 2. kept rows on a longest run of increasing target stay where they are, the others are moved
+				std::vector<SizeType> kept, targets;
+				for (SizeType i = 0; i < n; i++)
+					if (target[i] != none) {
+						kept.push_back(i);
+						targets.push_back(target[i]);
+					}
+				const std::vector<bool> stays = longestIncreasing(targets);
+
+				// Every row owns a slot in the final order, the final slot of b[j] right after the slots of the rows
+				// waiting to be moved in front of the staying row bound for j, so the array index of a row is the
+				// number of present slots below its own.
+				std::vector<SizeType> anchor(kept.size()), waitingBelow(m + 2, 0);
+				for (size_t k = kept.size(), next = m; k-- > 0;) {
+					if (stays[k])
+						next = targets[k];
+					else {
+						anchor[k] = static_cast<SizeType>(next);
+						waitingBelow[next + 1]++;
+					}
+				}
+				for (SizeType j = 1; j < m + 2; j++)
+					waitingBelow[j] += waitingBelow[j - 1];
+
+				FenwickTree present(m + waitingBelow[m + 1]);
+				std::vector<size_t> waitingSlot(n), cursor(waitingBelow.begin(), waitingBelow.end() - 1);
+				for (size_t k = 0; k < kept.size(); k++) {
+					if (stays[k])
+						present.add(targets[k] + waitingBelow[targets[k] + 1], 1);
+					else {
+						waitingSlot[kept[k]] = anchor[k] + cursor[anchor[k]]++;
+						present.add(waitingSlot[kept[k]], 1);
+					}
+				}
+				std::vector<bool> waiting(n);
+				for (size_t k = 0; k < kept.size(); k++)
+					waiting[kept[k]] = !stays[k];
+
+				// 3. rows of b in order: added, moved into place or left, then diffed in place
+				for (SizeType j = 0; j < m; j++) {
+					const size_t slot = j + waitingBelow[j + 1];
+					const SizeType i = match[j];
+					if (i == none) {
+						emit("add", path.Append(present.rank(slot)), &b[j]);
+						present.add(slot, 1);
+						continue;
+					}
+					if (waiting[i]) {
+						const SizeType from = present.rank(waitingSlot[i]);
+						present.add(waitingSlot[i], -1);
+						present.add(slot, 1);
+						const SizeType to = present.rank(slot);
+						if (from != to) {
+							const Pointer fromPath = path.Append(from);
+							emit("move", path.Append(to), nullptr, &fromPath);
+						}
+					}
+					if (!same(a[i], b[j]))
+						diffValue(a[i], b[j], path.Append(present.rank(slot)));
+				}
+				return true;
+			}
+		};
+	}
+
+	// Fills patch (a document, made an array) with the RFC 6902 JSON Patch turning from into to; paths are
+	// built with rapidjson::GenericPointer. Subtrees with different structural hashes (GenericValue::GetHash, each
+	// object and array hashed once per diff) are told apart, equal hashes are confirmed with operator== once before
+	// a subtree is skipped. Packed arrays are diffed element by element like regular ones. Values are copied into
+	// the patch.
+	inline void diff(const auto& from, const auto& to, auto& patch, const DiffOptions& options = {}) {
+		using Value = details::ValueTypeOf<decltype(from)>;
+		patch.SetArray();
+		details::Differ<Value, std::remove_cvref_t<decltype(patch)>> differ(patch, options);
+		if (!differ.same(from, to))
+			differ.diffValue(from, to, rapidjson::GenericPointer<Value>());
+	}
+
+	namespace details {
+		// values of patch can be moved into jsonDoc: same value type, non-const, and owned either by the pool of
+		// jsonDoc or by an allocator without bookkeeping (CrtAllocator)
+		template<class Patch>
+		inline bool canAdopt(auto& jsonDoc, Patch& patch) {
+			using Value = ValueTypeOf<decltype(jsonDoc)>;
+			if constexpr (std::is_const_v<Patch> || !std::is_same_v<ValueTypeOf<Patch>, Value>)
+				return false;
+			else if constexpr (Value::AllocatorType::kNeedFree)
+				return true;
+			else if constexpr (requires { patch.GetAllocator(); })
+				return &patch.GetAllocator() == &jsonDoc.GetAllocator();
+			else
+				return false;
+		}
+
+		template<class Document>
+		struct Patcher {
+			using Value = ValueTypeOf<Document>;
+			using SizeType = rapidjson::SizeType;
+			using Pointer = rapidjson::GenericPointer<Value>;
+			using Token = typename Pointer::Token;
+
+			// inverse of one change, addressed by path so that it survives reallocations of the containers
+			struct UndoStep {
+				enum class Kind { Remove, Insert, Replace, Repack } kind;
+				const Pointer* path;
+				SizeType index;  // array index, member position to insert at, or 1 to repack the parent as doubles
+				Value value;     // value to insert or put back
+				bool carried;    // insert the value displaced by the previous step (the second half of a move)
+			};
+
+			Value& root;
+			typename Value::AllocatorType& allocator;
+			std::vector<UndoStep> undo;
+			// chain[k] is the value reached through the first k tokens of *cachedPath: consecutive operations
+			// below the same parent resolve the shared prefix once, mutations cut the chain below the container
+			std::vector<Value*> chain;
+			const Pointer* cachedPath = nullptr;
+
+			explicit Patcher(Document& document) : root(document), allocator(document.GetAllocator()), chain{&root} {}
+
+			static bool isLast(const Token& token) { return token.length == 1 && token.name[0] == '-'; }
+
+			// elements of packed arrays are not values: they are read through peek() and changed after unpack()
+			static Value* child(Value& container, const Token& token) {
+				if (container.IsObject()) {
+					auto it = container.FindMember(Value(rapidjson::StringRef(token.name, token.length)));
+					return it != container.MemberEnd() ? &it->value : nullptr;
+				}
+				if (container.IsArray() && token.index < container.Size())
+					return &container[token.index];
+				return nullptr;
+			}
+
+			// value reached through the first depth tokens of path
+			Value* resolve(const Pointer& path, size_t depth) {
+				const Token* tokens = path.GetTokens();
+				size_t k = 0;
+				if (cachedPath) {
+					const Token* cached = cachedPath->GetTokens();
+					const size_t limit = std::min(chain.size() - 1, depth);
+					while (k < limit && tokens[k].length == cached[k].length && std::equal(tokens[k].name, tokens[k].name + tokens[k].length, cached[k].name))
+						k++;
+				}
+				chain.resize(k + 1);
+				cachedPath = &path;
+				for (; k < depth; k++) {
+					Value* next = child(*chain[k], tokens[k]);
+					if (!next)
+						return nullptr;
+					chain.push_back(next);
+				}
+				return chain[depth];
+			}
+
+			// the children of the value at depth moved or changed
+			void invalidate(size_t depth) {
+				if (chain.size() > depth + 1)
+					chain.resize(depth + 1);
+			}
+
+			// value at path for reading; an element of a packed array is read into scratch
+			const Value* peek(const Pointer& path, Value& scratch) {
+				const size_t depth = path.GetTokenCount();
+				if (depth) {
+					const Value* parent = resolve(path, depth - 1);
+					const Token& token = path.GetTokens()[depth - 1];
+					if (parent && parent->IsPackedArray())
+						return token.index < parent->Size() ? &parent->ElementAt(token.index, scratch) : nullptr;
+				}
+				return resolve(path, depth);
+			}
+
+			// turns the parent of the last token of path, a packed array about to change, into regular elements;
+			// rollback packs it again
+			void unpack(Value& array, const Pointer& path) {
+				if (!array.IsPackedArray())
+					return;
+				undo.push_back({UndoStep::Kind::Repack, &path, array.IsDoubleArray() ? 1u : 0u, Value(), false});
+				array.UnpackArray(allocator);
+				invalidate(path.GetTokenCount() - 1);
+			}
+
+			void repack(Value& array, bool doubles) {
+				if (doubles) {
+					std::vector<double> values;
+					for (auto& element : array.GetArray())
+						values.push_back(element.GetDouble());
+					array.SetDoubleArray(values.data(), static_cast<SizeType>(values.size()), allocator);
+				}
+				else {
+					std::vector<int64_t> values;
+					for (auto& element : array.GetArray())
+						values.push_back(element.GetInt64());
+					array.SetInt64Array(values.data(), static_cast<SizeType>(values.size()), allocator);
+				}
+			}
+
+			void insertElement(Value& array, SizeType index, Value& value) {
+				array.PushBack(value, allocator);
+				for (SizeType k = array.Size() - 1; k > index; k--)
+					array[k].Swap(array[k - 1]);
+			}
+
+			void insertMember(Value& object, const Token& token, SizeType position, Value& value) {
+				Value name(token.name, token.length, allocator);
+				object.AddMember(name, value, allocator);
+				auto members = object.MemberBegin();
+				for (SizeType k = object.MemberCount() - 1; k > position; k--) {
+					members[k].name.Swap(members[k - 1].name);
+					members[k].value.Swap(members[k - 1].value);
+				}
+				if (position + 1 < object.MemberCount())
+					object.RebuildMemberIndex();
+			}
+
+			// RFC 6902 "add"; an existing member is replaced
+			bool add(const Pointer& path, Value& value) {
+				const size_t depth = path.GetTokenCount();
+				if (depth == 0)
+					return replace(path, value);
+				Value* parent = resolve(path, depth - 1);
+				if (!parent)
+					return false;
+				const Token& token = path.GetTokens()[depth - 1];
+				if (parent->IsObject()) {
+					auto it = parent->FindMember(Value(rapidjson::StringRef(token.name, token.length)));
+					if (it != parent->MemberEnd()) {
+						it->value.Swap(value);
+						undo.push_back({UndoStep::Kind::Replace, &path, 0, std::move(value), false});
+					}
+					else {
+						insertMember(*parent, token, parent->MemberCount(), value);
+						undo.push_back({UndoStep::Kind::Remove, &path, 0, Value(), false});
+					}
+				}
+				else if (parent->GetType() == rapidjson::kArrayType) {
+					const SizeType index = isLast(token) ? parent->Size() : token.index;
+					if (index > parent->Size())
+						return false;
+					unpack(*parent, path);
+					insertElement(*parent, index, value);
+					undo.push_back({UndoStep::Kind::Remove, &path, index, Value(), false});
+				}
+				else
+					return false;
+				invalidate(depth - 1);
+				return true;
+			}
+
+			// RFC 6902 "remove"; the value is moved into removed (the first half of a move) or into the undo log
+			bool remove(const Pointer& path, Value* removed = nullptr) {
+				const size_t depth = path.GetTokenCount();
+				if (depth == 0)
+					return false;
+				Value* parent = resolve(path, depth - 1);
+				if (!parent)
+					return false;
+				const Token& token = path.GetTokens()[depth - 1];
+				Value value;
+				SizeType position;
+				if (parent->IsObject()) {
+					auto it = parent->FindMember(Value(rapidjson::StringRef(token.name, token.length)));
+					if (it == parent->MemberEnd())
+						return false;
+					position = static_cast<SizeType>(it - parent->MemberBegin());
+					value.Swap(it->value);
+					parent->EraseMember(it);
+				}
+				else if (parent->GetType() == rapidjson::kArrayType && token.index < parent->Size()) {
+					unpack(*parent, path);
+					position = token.index;
+					value.Swap((*parent)[position]);
+					parent->Erase(parent->Begin() + position);
+				}
+				else
+					return false;
+				invalidate(depth - 1);
+				if (removed)
+					removed->Swap(value);
+				undo.push_back({UndoStep::Kind::Insert, &path, position, std::move(value), removed != nullptr});
+				return true;
+			}
+
+			// RFC 6902 "replace"
+			bool replace(const Pointer& path, Value& value) {
+				const size_t depth = path.GetTokenCount();
+				if (depth)
+					if (Value* parent = resolve(path, depth - 1); parent && parent->IsPackedArray() && path.GetTokens()[depth - 1].index < parent->Size())
+						unpack(*parent, path);
+				Value* target = resolve(path, depth);
+				if (!target)
+					return false;
+				target->Swap(value);
+				undo.push_back({UndoStep::Kind::Replace, &path, 0, std::move(value), false});
+				invalidate(depth);
+				return true;
+			}
+
+			// undoes the logged steps in reverse order
+			void rollback() {
+				cachedPath = nullptr;
+				chain.resize(1);
+				Value displaced;
+				for (; !undo.empty(); undo.pop_back()) {
+					UndoStep& step = undo.back();
+					const size_t depth = step.path->GetTokenCount();
+					const Token* token = depth ? &step.path->GetTokens()[depth - 1] : nullptr;
+					if (step.kind == UndoStep::Kind::Replace) {
+						Value* target = resolve(*step.path, depth);
+						target->Swap(step.value);
+						displaced.Swap(step.value);
+						invalidate(depth);
+						continue;
+					}
+
+					Value* parent = resolve(*step.path, depth - 1);
+					if (step.kind == UndoStep::Kind::Repack)
+						repack(*parent, step.index != 0);
+					else if (step.kind == UndoStep::Kind::Remove) {
+						if (parent->IsObject()) {
+							auto it = parent->FindMember(Value(rapidjson::StringRef(token->name, token->length)));
+							displaced.Swap(it->value);
+							parent->EraseMember(it);
+						}
+						else {
+							displaced.Swap((*parent)[step.index]);
+							parent->Erase(parent->Begin() + step.index);
+						}
+					}
+					else {
+						Value& value = step.carried ? displaced : step.value;
+						if (parent->IsObject())
+							insertMember(*parent, *token, step.index, value);
+						else
+							insertElement(*parent, step.index, value);
+					}
+					invalidate(depth - 1);
+				}
+			}
+
+			static bool isPrefix(const Pointer& prefix, const Pointer& path) {
+				if (prefix.GetTokenCount() >= path.GetTokenCount())
+					return false;
+				for (size_t k = 0; k < prefix.GetTokenCount(); k++) {
+					const Token& a = prefix.GetTokens()[k];
+					const Token& b = path.GetTokens()[k];
+					if (a.length != b.length || !std::equal(a.name, a.name + a.length, b.name))
+						return false;
+				}
+				return true;
+			}
+
+			// applies one operation, nullptr on success or the reason of the failure
+			const char* apply(auto& op, const Pointer& path, const Pointer& from, bool adopt) {
+				using OpValue = std::remove_reference_t<decltype(op)>;
+				const std::string_view name(op["op"].GetString(), op["op"].GetStringLength());
+				auto valueMember = op.FindMember("value");
+				const bool hasValue = valueMember != op.MemberEnd();
+				auto take = [&]() {
+					if constexpr (std::is_same_v<OpValue, Value>) {
+						if (adopt)
+							return Value(std::move(valueMember->value));
+					}
+					return Value(valueMember->value, allocator);
+				};
+
+				if (name == "add" || name == "replace") {
+					if (!hasValue)
+						return "missing value";
+					Value value = take();
+					if (!(name == "add" ? add(path, value) : replace(path, value)))
+						return "path not found";
+				}
+				else if (name == "remove") {
+					if (!remove(path))
+						return "path not found";
+				}
+				else if (name == "move") {
+					if (isPrefix(from, path))
+						return "cannot move a value into itself";
+					Value value;
+					if (!remove(from, &value))
+						return "from not found";
+					if (!add(path, value)) {
+						// the removed value is only held here: handing it to the undo step lets rollback put it back
+						undo.back().value.Swap(value);
+						undo.back().carried = false;
+						return "path not found";
+					}
+				}
+				else if (name == "copy") {
+					Value scratch;
+					const Value* source = peek(from, scratch);
+					if (!source)
+						return "from not found";
+					Value value(*source, allocator);
+					if (!add(path, value))
+						return "path not found";
+				}
+				else if (name == "test") {
+					if (!hasValue)
+						return "missing value";
+					Value scratch;
+					const Value* target = peek(path, scratch);
+					if (!target || *target != valueMember->value)
+						return "test failed";
+				}
+				else
+					return "unknown operation";
+				return nullptr;
+			}
+		};
+
+		inline void mergePatch(auto& target, auto& patch, auto& allocator, bool adopt) {
+			using Value = std::remove_cvref_t<decltype(target)>;
+			using Patch = std::remove_reference_t<decltype(patch)>;
+			constexpr bool movable = !std::is_const_v<Patch> && std::is_base_of_v<Value, Patch>;
+			if (!patch.IsObject()) {
+				if constexpr (movable) {
+					if (adopt) {
+						target = static_cast<Value&>(patch);
+						return;
+					}
+				}
+				target.CopyFrom(patch, allocator);
+				return;
+			}
+			if (!target.IsObject())
+				target.SetObject();
+			for (auto it = patch.MemberBegin(); it != patch.MemberEnd(); ++it) {
+				auto member = target.FindMember(it->name);
+				if (it->value.IsNull()) {
+					if (member != target.MemberEnd())
+						target.EraseMember(member);
+				}
+				else if (member != target.MemberEnd())
+					mergePatch(member->value, it->value, allocator, adopt);
+				else {
+					// nulls of nested objects are dropped as well, hence merged into an empty value; the name is
+					// copied, so the patch keeps valid member names even when its values are moved
+					Value name(it->name, allocator), value;
+					mergePatch(value, it->value, allocator, adopt);
+					target.AddMember(name, value, allocator);
+				}
+			}
+		}
+	}
+
+	// Applies an RFC 6902 JSON Patch (an array of operations) to jsonDoc in place. Either every operation
+	// applies, or the changes of those before the failing one are rolled back from an undo log and false is
+	// returned. Consecutive operations below the same parent resolve the shared pointer prefix once.
+	// Values of a non-const patch are moved instead of copied when jsonDoc can own them (the patch is a
+	// document sharing the allocator of jsonDoc, or the allocator is a CrtAllocator); the patch then keeps
+	// null values in their place. Packed arrays (kParsePackedArraysFlag) are unpacked only by operations that
+	// change their elements, and packed again on rollback.
+	inline bool applyPatch(auto& jsonDoc, auto&& patch) {
+		using Patcher = details::Patcher<std::remove_cvref_t<decltype(jsonDoc)>>;
+		using Pointer = typename Patcher::Pointer;
+		if (!patch.IsArray()) {
+			std::fprintf(stderr, "JSON PATCH ERROR: the patch is not an array\n");
+			return false;
+		}
+
+		// all pointers are parsed up front, the undo log refers to them
+		std::vector<Pointer> paths;
+		paths.reserve(patch.Size() * 2);
+		for (rapidjson::SizeType i = 0; i < patch.Size(); i++) {
+			const auto& op = patch[i];
+			const auto from = op.IsObject() ? op.FindMember("from") : op.MemberEnd();
+			if (!op.IsObject() || !op.HasMember("op") || !op["op"].IsString() || !op.HasMember("path") || !op["path"].IsString()
+				|| (from != op.MemberEnd() && !from->value.IsString())) {
+				std::fprintf(stderr, "JSON PATCH ERROR: operation %u is malformed\n", i);
+				return false;
+			}
+			paths.emplace_back(op["path"].GetString(), op["path"].GetStringLength());
+			if (from != op.MemberEnd())
+				paths.emplace_back(from->value.GetString(), from->value.GetStringLength());
+			else
+				paths.emplace_back();
+			if (!paths[i * 2].IsValid() || !paths[i * 2 + 1].IsValid()) {
+				std::fprintf(stderr, "JSON PATCH ERROR: operation %u has an invalid pointer\n", i);
+				return false;
+			}
+		}
+
+		Patcher patcher(jsonDoc);
+		const bool adopt = details::canAdopt(jsonDoc, patch);
+		for (rapidjson::SizeType i = 0; i < patch.Size(); i++) {
+			auto& op = patch[i];
+			if (const char* error = patcher.apply(op, paths[i * 2], paths[i * 2 + 1], adopt)) {
+				std::fprintf(stderr, "JSON PATCH ERROR: operation %u (%s %s): %s\n", i, op["op"].GetString(), op["path"].GetString(), error);
+				patcher.rollback();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Applies an RFC 7386 JSON Merge Patch to jsonDoc in place; values of a non-const patch are moved
+	// under the same conditions as for applyPatch(), member names are always copied.
+	inline void applyMergePatch(auto& jsonDoc, auto&& patch) {
+		auto& target = static_cast<details::ValueTypeOf<decltype(jsonDoc)>&>(jsonDoc);
+		details::mergePatch(target, patch, jsonDoc.GetAllocator(), details::canAdopt(jsonDoc, patch));
+	}
+
+	namespace details {
+		// C++ string literal spelling the bytes of text
+		inline std::string cppLiteral(std::string_view text) {
+			std::string literal = "\"";
+			for (const char c : text) {
+				const unsigned char u = static_cast<unsigned char>(c);
+				if (c == '"' || c == '\\')
+					(literal += '\\') += c;
+				else if (u >= 0x20 && u < 0x7F)
+					literal += c;
+				else {
+					char octal[8];
+					std::snprintf(octal, sizeof(octal), "\\%03o", u);
+					literal += octal;
+				}
+			}
+			return literal += '"';
+		}
+
+		// structs and SAX handler emitted by generateParser()
+		template<class Schema>
+		struct ParserGenerator {
+			enum class Kind { Integer, Number, String, Boolean, Object, Array };
+			struct Field {
+				std::string key, member;
+				size_t type;
+				bool required;
+			};
+			struct Bound {
+				bool present = false;
+				bool exclusive = false;
+				bool integral = false;  // the limit is an int64_t
+				int64_t i = 0;
+				double d = 0;
+			};
+			struct Choice {
+				std::string literal;  // C++ literal of an "enum" value
+				size_t length = 0;    // of a string
+			};
+			struct Type {
+				Kind kind;
+				bool nullable = false;
+				std::string name;      // struct name, or the name the slots of an array derive from
+				std::string spelling;  // C++ type
+				std::string id;        // enumerator of an object type
+				std::vector<Field> fields;
+				bool closed = false;   // "additionalProperties": false
+				size_t item = 0;       // element type of an array
+				uint32_t seed = 0;     // perfect hash of the property names: table[fnv1a(seed, key) & (table.size() - 1)]
+				std::vector<int> table;
+				Bound minimum, maximum;  // of a number
+				int64_t multipleOf = 0;  // of an integer
+				rapidjson::SizeType minSize = 0, maxSize = rapidjson::SizeType(~0);  // code points of a string, elements of an array
+				bool enumerated = false; // the value must be one of choices
+				std::vector<Choice> choices;
+			};
+			enum class Target { Root, Field, Item };
+			struct Slot {
+				std::string id;
+				Target target;
+				size_t owner;  // type holding the slot
+				size_t field;
+				size_t type;   // type of the value stored through the slot
+			};
+
+			std::vector<Type> types;
+			std::vector<size_t> structs;                        // object types in declaration order
+			std::unordered_map<const Schema*, size_t> objects;  // SIZE_MAX while the object is being built
+			std::unordered_set<std::string> identifiers{"kIgnored", "kRoot", "kArray"};
+			std::vector<Slot> slots;
+
+			static bool fail(const std::string& name, const char* reason) {
+				std::fprintf(stderr, "JSON SCHEMA GENERATOR ERROR: %s: %s\n", name.c_str(), reason);
+				return false;
+			}
+
+			static std::string integerLiteral(int64_t value) {
+				return value == INT64_MIN ? "INT64_MIN" : std::to_string(value);
+			}
+
+			static std::string doubleLiteral(double value) {
+				char literal[32];
+				std::snprintf(literal, sizeof(literal), "%.17g", value);
+				return std::strpbrk(literal, ".e") ? literal : std::string(literal) + ".0";
+			}
+
+			std::string unique(std::string name) {
+				for (size_t suffix = 2; !identifiers.insert(name).second; suffix++)
+					name = name.substr(0, name.find_last_not_of("0123456789") + 1) + std::to_string(suffix);
+				return name;
+			}
+
+			static std::string identifier(std::string_view key) {
+				static const std::unordered_set<std::string_view> keywords{"alignas", "alignof", "and", "asm", "auto", "bool", "break", "case", "catch",
+					"char", "class", "const", "constexpr", "continue", "default", "delete", "do", "double", "else", "enum", "explicit", "export", "extern",
+					"false", "float", "for", "friend", "goto", "if", "inline", "int", "long", "mutable", "namespace", "new", "not", "nullptr", "operator",
+					"or", "private", "protected", "public", "register", "return", "short", "signed", "sizeof", "static", "struct", "switch", "template",
+					"this", "throw", "true", "try", "typedef", "typename", "union", "unsigned", "using", "virtual", "void", "volatile", "while", "xor"};
+				std::string name;
+				for (const char c : key)
+					name += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+				if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0])))
+					name.insert(name.begin(), '_');
+				if (keywords.contains(name))
+					name += '_';
+				return name;
+			}
+
+			// "mob_list" -> "MobList"
+			static std::string capitalized(std::string_view key) {
+				std::string name;
+				bool upper = true;
+				for (const char c : key) {
+					if (!std::isalnum(static_cast<unsigned char>(c)))
+						upper = true;
+					else {
+						name += upper ? static_cast<char>(std::toupper(static_cast<unsigned char>(c))) : c;
+						upper = false;
+					}
+				}
+				return name;
+			}
+
+			// folded so that the low bits picking the entry depend on every byte
+			static uint32_t fnv1a(uint32_t seed, std::string_view key) {
+				for (const char c : key)
+					seed = (seed ^ static_cast<unsigned char>(c)) * 16777619u;
+				return seed ^ seed >> 16;
+			}
+
+			// smallest power-of-two table with a seed under which the names do not collide
+			static void perfectHash(Type& type) {
+				size_t size = std::bit_ceil(std::max<size_t>(type.fields.size(), 1));
+				for (;; size *= 2)
+					for (uint32_t seed = 2166136261u, attempt = 0; attempt < 4096; attempt++, seed = seed * 747796405u + 2891336453u) {
+						type.table.assign(size, -1);
+						bool collision = false;
+						for (size_t i = 0; i < type.fields.size() && !collision; i++) {
+							int& entry = type.table[fnv1a(seed, type.fields[i].key) & (size - 1)];
+							collision = entry >= 0;
+							entry = static_cast<int>(i);
+						}
+						if (!collision) {
+							type.seed = seed;
+							return;
+						}
+					}
+			}
+
+			// the keywords checked by the generated code; the others fail the generation
+			bool constrain(const Schema& schema, const std::string& name, Type& type) {
+				if (const char* keyword = schema.GetUnexposedKeyword())
+					return fail(name, ("\"" + std::string(keyword) + "\" is not supported").c_str());
+				auto bound = [](const auto& limit, bool exclusive, Bound& b) {
+					if (limit.IsNumber())
+						b = {true, exclusive, limit.IsInt64(), limit.IsInt64() ? limit.GetInt64() : 0, limit.GetDouble()};
+				};
+				if (type.kind == Kind::Integer || type.kind == Kind::Number) {
+					bound(schema.GetMinimum(), schema.IsExclusiveMinimum(), type.minimum);
+					bound(schema.GetMaximum(), schema.IsExclusiveMaximum(), type.maximum);
+					if (const auto& multipleOf = schema.GetMultipleOf(); multipleOf.IsNumber()) {
+						if (type.kind != Kind::Integer || !multipleOf.IsInt64())
+							return fail(name, "\"multipleOf\" is only supported as an integer of an integer");
+						type.multipleOf = multipleOf.GetInt64();
+					}
+				}
+				else if (type.kind == Kind::String)
+					type.minSize = schema.GetMinLength(), type.maxSize = schema.GetMaxLength();
+				else if (type.kind == Kind::Array)
+					type.minSize = schema.GetMinItems(), type.maxSize = schema.GetMaxItems();
+
+				const auto& choices = schema.GetEnum();
+				if (!choices.IsArray())
+					return true;
+				if (type.kind == Kind::Object || type.kind == Kind::Array)
+					return fail(name, "\"enum\" of objects or arrays is not supported");
+				type.enumerated = true;
+				bool null = false;
+				for (const auto& choice : choices.GetArray()) {
+					if (choice.IsNull())
+						null = true;
+					else if (type.kind == Kind::String && choice.IsString())
+						type.choices.push_back({cppLiteral(std::string(choice.GetString(), choice.GetStringLength())), choice.GetStringLength()});
+					else if (type.kind == Kind::Boolean && choice.IsBool())
+						type.choices.push_back({choice.GetBool() ? "true" : "false"});
+					else if (type.kind == Kind::Number && choice.IsNumber())
+						type.choices.push_back({doubleLiteral(choice.GetDouble())});
+					else if (type.kind == Kind::Integer && choice.IsInt64())
+						type.choices.push_back({integerLiteral(choice.GetInt64())});
+					else if (type.kind == Kind::Integer && choice.IsDouble() && std::floor(choice.GetDouble()) == choice.GetDouble()
+						&& std::fabs(choice.GetDouble()) < 9.2e18)
+						type.choices.push_back({integerLiteral(static_cast<int64_t>(choice.GetDouble()))});
+				}
+				type.nullable = type.nullable && null;
+				return true;
+			}
+
+			bool build(const Schema& schema, const std::string& name, size_t& index) {
+				if (schema.IsTypeless())
+					return fail(name, "no type");
+				const int kinds = schema.AllowsType(Schema::kBooleanSchemaType) + schema.AllowsType(Schema::kObjectSchemaType)
+					+ schema.AllowsType(Schema::kArraySchemaType) + schema.AllowsType(Schema::kStringSchemaType) + schema.AllowsType(Schema::kIntegerSchemaType);
+				if (kinds != 1)
+					return fail(name, "the type does not map to a single C++ type");
+
+				Type type;
+				type.nullable = schema.AllowsType(Schema::kNullSchemaType);
+				if (schema.AllowsType(Schema::kNumberSchemaType))
+					type.kind = Kind::Number, type.spelling = "double";
+				else if (schema.AllowsType(Schema::kIntegerSchemaType))
+					type.kind = Kind::Integer, type.spelling = "int64_t";
+				else if (schema.AllowsType(Schema::kStringSchemaType))
+					type.kind = Kind::String, type.spelling = "std::string";
+				else if (schema.AllowsType(Schema::kBooleanSchemaType))
+					type.kind = Kind::Boolean, type.spelling = "bool";
+				else if (schema.AllowsType(Schema::kArraySchemaType)) {
+					const Schema* items = schema.GetItemsSchema();
+					if (!items)
+						return fail(name, "\"items\" must be a single schema");
+					size_t item;
+					if (!build(*items, name + "Item", item))
+						return false;
+					type.kind = Kind::Array;
+					type.name = name;
+					type.item = item;
+					type.spelling = "std::vector<" + types[item].spelling + ">";
+				}
+				else {
+					// schemas shared through $ref become one struct
+					if (auto it = objects.find(&schema); it != objects.end()) {
+						if (it->second == SIZE_MAX)
+							return fail(name, "recursive schema");
+						index = it->second;
+						return true;
+					}
+					if (schema.GetPropertyCount() > 64)
+						return fail(name, "more than 64 properties");
+					objects[&schema] = SIZE_MAX;
+					type.kind = Kind::Object;
+					type.name = type.spelling = unique(name);
+					type.id = unique("k" + type.name + "Object");
+					type.closed = !schema.AllowsAdditionalProperties();
+					std::unordered_set<std::string> members{type.name};
+					for (rapidjson::SizeType i = 0; i < schema.GetPropertyCount(); i++) {
+						const auto& key = schema.GetPropertyName(i);
+						Field field{std::string(key.GetString(), key.GetStringLength()), {}, 0, schema.IsPropertyRequired(i)};
+						field.member = identifier(field.key);
+						while (!members.insert(field.member).second)
+							field.member += '_';
+						if (!build(*schema.GetPropertySchema(i), type.name + capitalized(field.key), field.type))
+							return false;
+						type.fields.push_back(std::move(field));
+					}
+					perfectHash(type);
+					structs.push_back(types.size());
+					objects[&schema] = types.size();
+				}
+				if (!constrain(schema, name, type))
+					return false;
+				index = types.size();
+				types.push_back(std::move(type));
+				return true;
+			}
+
+			// condition under which value (s and n for a string, the element count n for an array) breaks the keywords of type
+			std::string violation(const Type& type, const std::string& value) const {
+				std::string condition;
+				auto add = [&](const std::string& term) { condition += (condition.empty() ? "" : " || ") + term; };
+				auto limit = [&](const Bound& b, const char* outside, const char* outsideExclusive) {
+					if (!b.present)
+						return;
+					const std::string op = b.exclusive ? outsideExclusive : outside;
+					if (type.kind == Kind::Integer && b.integral)
+						add(value + " " + op + " " + integerLiteral(b.i));
+					else
+						add((type.kind == Kind::Integer ? "static_cast<double>(" + value + ")" : value) + " " + op + " " + doubleLiteral(b.d));
+				};
+				limit(type.minimum, "<", "<=");
+				limit(type.maximum, ">", ">=");
+				if (type.multipleOf)
+					add(value + " % " + integerLiteral(type.multipleOf) + " != 0");
+				const bool limited = type.minSize != 0 || type.maxSize != rapidjson::SizeType(~0);
+				if (limited && type.kind == Kind::String)
+					add("!lengthWithin(s, n, " + std::to_string(type.minSize) + "u, " + std::to_string(type.maxSize) + "u)");
+				else if (limited && type.kind == Kind::Array) {
+					if (type.minSize)
+						add("n < " + std::to_string(type.minSize) + "u");
+					if (type.maxSize != rapidjson::SizeType(~0))
+						add("n > " + std::to_string(type.maxSize) + "u");
+				}
+				if (type.enumerated) {
+					std::string any;
+					for (const Choice& choice : type.choices)
+						any += (any.empty() ? "" : " || ") + (type.kind == Kind::String
+							? "(n == " + std::to_string(choice.length) + " && std::memcmp(s, " + choice.literal + ", " + std::to_string(choice.length) + ") == 0)"
+							: value + " == " + choice.literal);
+					add(any.empty() ? "true" : "!(" + any + ")");
+				}
+				return condition;
+			}
+
+			void addSlots(size_t root) {
+				slots.push_back({"kRoot", Target::Root, SIZE_MAX, 0, root});
+				// the slots of an object are contiguous: the field index is the offset from the first one
+				for (const size_t owner : structs)
+					for (size_t i = 0; i < types[owner].fields.size(); i++)
+						slots.push_back({unique("k" + types[owner].name + "_" + types[owner].fields[i].member), Target::Field, owner, i, types[owner].fields[i].type});
+				for (size_t owner = 0; owner < types.size(); owner++)
+					if (types[owner].kind == Kind::Array)
+						slots.push_back({unique("k" + types[owner].name + "Item"), Target::Item, owner, 0, types[owner].item});
+			}
+
+			// storage reached through slot from the frame target, for a value (field) or a new element (item)
+			std::string place(const Slot& slot) const {
+				switch (slot.target) {
+				case Target::Root:
+					return "*static_cast<" + types[slot.type].spelling + "*>(frame.target)";
+				case Target::Field:
+					return "static_cast<" + types[slot.owner].spelling + "*>(frame.target)->" + types[slot.owner].fields[slot.field].member;
+				default:
+					return "static_cast<" + types[slot.owner].spelling + "*>(frame.target)->emplace_back()";
+				}
+			}
+
+			// emits a scalar event: the cases storing the value through the slots of the accepted kinds, with
+			// the expression converting it (an empty list accepts null where the type is nullable); the parameters
+			// stay unnamed when no slot takes the value
+			void scalarEvent(std::string& code, const std::string& signature, const std::string& unnamed, std::initializer_list<std::pair<Kind, std::string>> accepted) {
+				std::string cases;
+				for (const Slot& slot : slots) {
+					const Type& type = types[slot.type];
+					const bool item = slot.target == Target::Item;
+					std::string statement = item ? place(slot) : "", check;
+					if (accepted.size() == 0) {
+						if (!type.nullable)
+							continue;
+					}
+					else {
+						auto it = std::find_if(accepted.begin(), accepted.end(), [&](const auto& entry) { return entry.first == type.kind; });
+						if (it == accepted.end())
+							continue;
+						if (const std::string condition = violation(type, it->second); !condition.empty())
+							check = "\t\t\t\tif (" + condition + ")\n\t\t\t\t\treturn false;\n";
+						if (item)
+							statement.replace(statement.size() - 2, 2, "(" + it->second + ")");
+						else if (type.kind == Kind::String)
+							statement = place(slot) + ".assign(s, n)";
+						else
+							statement = place(slot) + " = " + it->second;
+					}
+					cases += "\t\t\tcase " + slot.id + ":\n" + check + (statement.empty() ? "" : "\t\t\t\t" + statement + ";\n") + "\t\t\t\treturn true;\n";
+				}
+				const bool stored = cases.find("frame.") != std::string::npos;
+				code += "\t\t" + (stored ? signature : unnamed) + " {\n\t\t\tif (skip_)\n\t\t\t\treturn true;\n";
+				if (stored)
+					code += "\t\t\tFrame& frame = stack_.back();\n\t\t\tswitch (frame.slot) {\n";
+				else
+					code += "\t\t\tswitch (stack_.back().slot) {\n";
+				code += "\t\t\tcase kIgnored:\n\t\t\t\treturn true;\n" + cases;
+				code += "\t\t\tdefault:\n\t\t\t\treturn false;\n\t\t\t}\n\t\t}\n\n";
+			}
+
+			// emits StartObject/StartArray: the cases entering a container stored through the slots of the kind
+			void startEvent(std::string& code, Kind kind) {
+				const bool object = kind == Kind::Object;
+				code += object ? "\t\tbool StartObject() {\n" : "\t\tbool StartArray() {\n";
+				code += "\t\t\tFrame& frame = stack_.back();\n\t\t\tif (skip_ || frame.slot == kIgnored) {\n\t\t\t\tskip_++;\n\t\t\t\treturn true;\n\t\t\t}\n";
+				code += "\t\t\tswitch (frame.slot) {\n";
+				for (const Slot& slot : slots) {
+					const Type& type = types[slot.type];
+					if (type.kind != kind)
+						continue;
+					code += "\t\t\tcase " + slot.id + ":\n";
+					if (object)
+						code += "\t\t\t\treturn enter(" + type.id + ", kIgnored, " + (slot.target == Target::Root ? "frame.target" : "&" + place(slot)) + ");\n";
+					else {
+						const std::string& item = std::find_if(slots.begin(), slots.end(), [&](const Slot& s) {
+							return s.target == Target::Item && s.owner == slot.type; })->id;
+						code += "\t\t\t\treturn enter(kArray, " + item + ", &(" + place(slot) + (slot.target == Target::Item ? ")" : " = {})") + ");\n";
+					}
+				}
+				code += "\t\t\tdefault:\n\t\t\t\treturn false;\n\t\t\t}\n\t\t}\n\n";
+			}
+
+			// emits PredictKey/PredictedKey (kParsePredictKeysFlag): the property after the previous one, in
+			// schema order, is matched as its quoted name and colon; names needing escapes are never predicted
+			void predictEvents(std::string& code) {
+				std::string predict, predicted;
+				size_t first = 1;
+				for (const size_t index : structs) {
+					const Type& type = types[index];
+					if (!type.fields.empty()) {
+						std::string keys, lengths;
+						for (const Field& field : type.fields) {
+							const bool plain = std::none_of(field.key.begin(), field.key.end(), [](char c) {
+								return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20; });
+							keys += (plain ? cppLiteral("\"" + field.key + "\":") : "nullptr") + ", ";
+							lengths += std::to_string(plain ? field.key.size() + 3 : 0) + ", ";
+						}
+						predict += "\t\t\tcase " + type.id + ": {\n\t\t\t\tstatic const char* const keys[] = { " + keys + "nullptr };\n"
+							"\t\t\t\tstatic const rapidjson::SizeType lengths[] = { " + lengths + "0 };\n"
+							"\t\t\t\tlength = lengths[frame.next];\n\t\t\t\treturn keys[frame.next];\n\t\t\t}\n";
+						predicted += "\t\t\tcase " + type.id + ":\n\t\t\t\tframe.slot = static_cast<Slot>(" + slots[first].id + " + frame.next);\n\t\t\t\tbreak;\n";
+					}
+					first += type.fields.size();
+				}
+				code += "\t\tconst char* PredictKey(rapidjson::SizeType& length) const {\n\t\t\tif (skip_)\n\t\t\t\treturn nullptr;\n"
+					"\t\t\tconst Frame& frame = stack_.back();\n\t\t\tswitch (frame.type) {\n" + predict + "\t\t\tdefault:\n\t\t\t\treturn nullptr;\n\t\t\t}\n\t\t}\n\n";
+				code += "\t\tbool PredictedKey() {\n\t\t\tFrame& frame = stack_.back();\n\t\t\tswitch (frame.type) {\n" + predicted
+					+ "\t\t\tdefault:\n\t\t\t\treturn false;\n\t\t\t}\n\t\t\tframe.seen |= uint64_t(1) << frame.next++;\n\t\t\treturn true;\n\t\t}\n\n";
+			}
+
+			std::string emit(size_t root, std::string_view rootName, std::string_view nameSpace) {
+				const std::string reader = std::string(rootName) + "Reader";
+				const std::string rootType = types[root].kind == Kind::Array ? std::string(rootName) : types[root].spelling;
+				std::string code = "// Generated by rapidjsonHelper::generateParser() from a JSON schema, do not edit.\n"
+					"#pragma once\n\n#include <rapidjson/reader.h>\n\n#include <cstdint>\n#include <cstring>\n#include <string>\n#include <vector>\n\n";
+				code += "namespace " + std::string(nameSpace) + " {\n";
+				for (const size_t index : structs) {
+					const Type& type = types[index];
+					code += "\tstruct " + type.name + " {\n";
+					for (const Field& field : type.fields) {
+						const Kind kind = types[field.type].kind;
+						code += "\t\t" + types[field.type].spelling + " " + field.member + (kind == Kind::Integer || kind == Kind::Number ? " = 0" : kind == Kind::Boolean ? " = false" : "") + ";\n";
+					}
+					code += "\t};\n\n";
+				}
+				if (types[root].kind == Kind::Array)
+					code += "\tusing " + rootType + " = " + types[root].spelling + ";\n\n";
+
+				code += "\t// SAX handler parsing straight into " + std::string(rootName) + ". A value of another type or outside of its \"enum\",\n"
+					"\t// \"minimum\", \"maximum\", \"multipleOf\", length or item count limits, a missing required property or an\n"
+					"\t// unknown property of a closed object stops the parse.\n";
+				code += "\tclass " + reader + " : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, " + reader + "> {\n\tpublic:\n";
+				code += "\t\texplicit " + reader + "(" + rootType + "& root) {\n\t\t\tstack_.reserve(16);\n\t\t\tstack_.push_back({kArray, kRoot, 0, 0, &root});\n\t\t}\n\n";
+				code += "\t\t// parses the zero-terminated json into root; properties missing from json keep their values\n";
+				code += "\t\ttemplate<unsigned parseFlags = rapidjson::kParsePredictKeysFlag>\n";
+				code += "\t\tstatic bool parse(const char* json, " + rootType + "& root) {\n\t\t\t" + reader + " handler(root);\n"
+					"\t\t\trapidjson::Reader reader;\n\t\t\trapidjson::StringStream stream(json);\n\t\t\treturn !reader.Parse<parseFlags>(stream, handler).IsError();\n\t\t}\n\n";
+
+				scalarEvent(code, "bool Null()", "bool Null()", {});
+				scalarEvent(code, "bool Bool(bool b)", "bool Bool(bool)", {{Kind::Boolean, "b"}});
+				code += "\t\tbool Int(int i) { return Int64(i); }\n\t\tbool Uint(unsigned u) { return Int64(u); }\n"
+					"\t\tbool Uint64(uint64_t u) { return u <= static_cast<uint64_t>(INT64_MAX) ? Int64(static_cast<int64_t>(u)) : Double(static_cast<double>(u)); }\n\n";
+				scalarEvent(code, "bool Int64(int64_t i)", "bool Int64(int64_t)", {{Kind::Integer, "i"}, {Kind::Number, "static_cast<double>(i)"}});
+				scalarEvent(code, "bool Double(double d)", "bool Double(double)", {{Kind::Number, "d"}});
+				scalarEvent(code, "bool String(const char* s, rapidjson::SizeType n, bool)", "bool String(const char*, rapidjson::SizeType, bool)", {{Kind::String, "s, n"}});
+
+				code += "\t\tbool Key(const char* s, rapidjson::SizeType n, bool) {\n\t\t\tif (skip_)\n\t\t\t\treturn true;\n"
+					"\t\t\tFrame& frame = stack_.back();\n\t\t\tswitch (frame.type) {\n";
+				size_t first = 1;
+				for (const size_t index : structs) {
+					const Type& type = types[index];
+					const char* unknown = type.closed ? "false" : "true";
+					code += "\t\t\tcase " + type.id + ": {\n";
+					if (type.fields.empty())
+						code += "\t\t\t\tframe.slot = kIgnored;\n\t\t\t\treturn " + std::string(unknown) + ";\n\t\t\t}\n";
+					else {
+						code += "\t\t\t\tconst int field = fieldOf" + type.name + "(s, n);\n\t\t\t\tif (field < 0) {\n\t\t\t\t\tframe.slot = kIgnored;\n\t\t\t\t\treturn " + unknown + ";\n\t\t\t\t}\n";
+						code += "\t\t\t\tframe.slot = static_cast<Slot>(" + slots[first].id + " + field);\n\t\t\t\tframe.seen |= uint64_t(1) << field;\n"
+							"\t\t\t\tframe.next = static_cast<uint16_t>(field + 1);\n\t\t\t\treturn true;\n\t\t\t}\n";
+					}
+					first += type.fields.size();
+				}
+				code += "\t\t\tdefault:\n\t\t\t\treturn false;\n\t\t\t}\n\t\t}\n\n";
+
+				predictEvents(code);
+				startEvent(code, Kind::Object);
+				startEvent(code, Kind::Array);
+				code += "\t\tbool EndObject(rapidjson::SizeType) {\n\t\t\tif (skip_) {\n\t\t\t\tskip_--;\n\t\t\t\treturn true;\n\t\t\t}\n\t\t\tstatic const uint64_t required[] = {";
+				for (const size_t index : structs) {
+					uint64_t mask = 0;
+					for (size_t i = 0; i < types[index].fields.size(); i++)
+						mask |= uint64_t(types[index].fields[i].required) << i;
+					char hex[24];
+					std::snprintf(hex, sizeof(hex), "%s0x%llx", index == structs.front() ? " " : ", ", static_cast<unsigned long long>(mask));
+					code += hex;
+				}
+				if (structs.empty())
+					code += " 0";
+				code += " };\n\t\t\tconst Frame& frame = stack_.back();\n\t\t\tif ((frame.seen & required[frame.type]) != required[frame.type])\n\t\t\t\treturn false;\n"
+					"\t\t\tstack_.pop_back();\n\t\t\treturn true;\n\t\t}\n\n";
+				std::string counted;
+				for (const Slot& slot : slots)
+					if (slot.target == Target::Item)
+						if (const std::string condition = violation(types[slot.owner], "n"); !condition.empty())
+							counted += "\t\t\tcase " + slot.id + ":\n\t\t\t\tif (" + condition + ")\n\t\t\t\t\treturn false;\n\t\t\t\tbreak;\n";
+				if (counted.empty())
+					code += "\t\tbool EndArray(rapidjson::SizeType) {\n\t\t\tif (skip_)\n\t\t\t\tskip_--;\n\t\t\telse\n\t\t\t\tstack_.pop_back();\n\t\t\treturn true;\n\t\t}\n\n";
+				else
+					code += "\t\tbool EndArray(rapidjson::SizeType n) {\n\t\t\tif (skip_) {\n\t\t\t\tskip_--;\n\t\t\t\treturn true;\n\t\t\t}\n"
+						"\t\t\tswitch (stack_.back().slot) {\n" + counted + "\t\t\tdefault:\n\t\t\t\tbreak;\n\t\t\t}\n\t\t\tstack_.pop_back();\n\t\t\treturn true;\n\t\t}\n\n";
+
+				code += "\tprivate:\n\t\tenum Type : uint16_t {";
+				for (const size_t index : structs)
+					code += " " + types[index].id + ",";
+				code += " kArray };\n\t\tenum Slot : uint16_t {";
+				for (size_t i = 0; i < slots.size(); i++)
+					code += (i % 4 ? " " : "\n\t\t\t") + slots[i].id + ",";
+				code += "\n\t\t\tkIgnored\n\t\t};\n";
+				code += "\t\tstruct Frame {\n\t\t\tType type;\n\t\t\tSlot slot;  // of the value to come\n\t\t\tuint16_t next;  // property predicted next\n\t\t\tuint64_t seen;  // properties present\n\t\t\tvoid* target;\n\t\t};\n\n";
+				code += "\t\tbool enter(Type type, Slot slot, void* target) {\n\t\t\tstack_.push_back({type, slot, 0, 0, target});\n\t\t\treturn true;\n\t\t}\n\n";
+				if (std::any_of(types.begin(), types.end(), [](const Type& type) {
+						return type.kind == Kind::String && (type.minSize != 0 || type.maxSize != rapidjson::SizeType(~0)); }))
+					code += "\t\t// \"minLength\" and \"maxLength\" count code points, the bytes not continuing a UTF-8 sequence\n"
+						"\t\tstatic bool lengthWithin(const char* s, rapidjson::SizeType n, rapidjson::SizeType min, rapidjson::SizeType max) {\n"
+						"\t\t\trapidjson::SizeType length = 0;\n\t\t\tfor (rapidjson::SizeType i = 0; i < n; i++)\n"
+						"\t\t\t\tlength += (static_cast<unsigned char>(s[i]) & 0xC0) != 0x80;\n\t\t\treturn length >= min && length <= max;\n\t\t}\n\n";
+
+				for (const size_t index : structs) {
+					const Type& type = types[index];
+					if (type.fields.empty())
+						continue;
+					code += "\t\t// property index of " + type.name + ": a seeded FNV-1a picks the only candidate, memcmp confirms it\n";
+					code += "\t\tstatic int fieldOf" + type.name + "(const char* s, rapidjson::SizeType n) {\n\t\t\tstatic const char* const names[] = {";
+					std::string lengths;
+					for (size_t i = 0; i < type.fields.size(); i++) {
+						code += (i ? ", " : " ") + cppLiteral(type.fields[i].key);
+						lengths += (i ? ", " : " ") + std::to_string(type.fields[i].key.size());
+					}
+					code += " };\n\t\t\tstatic const rapidjson::SizeType lengths[] = {" + lengths + " };\n";
+					code += "\t\t\tstatic const int8_t table[" + std::to_string(type.table.size()) + "] = {";
+					for (size_t i = 0; i < type.table.size(); i++)
+						code += (i ? ", " : " ") + std::to_string(type.table[i]);
+					code += " };\n\t\t\tuint32_t h = " + std::to_string(type.seed) + "u;\n\t\t\tfor (rapidjson::SizeType i = 0; i < n; i++)\n"
+						"\t\t\t\th = (h ^ static_cast<unsigned char>(s[i])) * 16777619u;\n";
+					code += "\t\t\tconst int field = table[(h ^ h >> 16) & " + std::to_string(type.table.size() - 1) + "];\n"
+						"\t\t\treturn field >= 0 && lengths[field] == n && std::memcmp(names[field], s, n) == 0 ? field : -1;\n\t\t}\n\n";
+				}
+				code += "\t\tstd::vector<Frame> stack_;  // the bottom frame holds the root\n\t\tunsigned skip_ = 0;         // depth inside an ignored value\n\t};\n}\n";
+				return code;
+			}
+		};
+	}
+
+	// Generates C++ source with structs mirroring schemaDoc and a rapidjson::Reader handler filling them without a
+	// DOM. The root (rootName, an object or an array) and every object with typed properties become structs:
+	// "integer" maps to int64_t, "number" to double, "string" to std::string, "boolean" to bool, "array" with
+	// a single "items" schema to std::vector. The generated handler checks "required", "additionalProperties": false,
+	// "enum" of scalars, "minimum", "maximum", "exclusiveMinimum", "exclusiveMaximum", "multipleOf" of integers,
+	// "minLength", "maxLength", "minItems" and "maxItems". Returns an empty string for a schema outside of this
+	// subset, including one using any other keyword.
+	inline std::string generateParser(const auto& schemaDoc, std::string_view rootName, std::string_view nameSpace) {
+		details::ParserGenerator<typename std::remove_cvref_t<decltype(schemaDoc)>::SchemaType> generator;
+		generator.identifiers.insert(std::string(rootName) + "Reader");
+		size_t root;
+		if (!generator.build(schemaDoc.GetRoot(), std::string(rootName), root))
+			return {};
+		if (generator.types[root].kind != decltype(generator)::Kind::Object && generator.types[root].kind != decltype(generator)::Kind::Array) {
+			generator.fail(std::string(rootName), "the root must be an object or an array");
+			return {};
+		}
+		generator.addSlots(root);
+		return generator.emit(root, rootName, nameSpace);
+	}
 }
 
 #endif //__INC_IKD_RAPIDJSON_HELPER_H__
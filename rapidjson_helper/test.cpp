@@ -1,6 +1,13 @@
 #include <rapidjson_helper.h>
+#include "test_load_parser.h"
 
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <vector>
+#if RAPIDJSON_HAS_MMAP
+#include <unistd.h>
+#endif
 
 struct MyBigThiccData {
 	int64_t id{};
@@ -89,9 +96,1180 @@ bool TestSaveData() {
 	return rapidjsonHelper::writeToFile(jsonDoc, filename, true);
 }
 
+bool TestMemoryReport() {
+	rapidjson::Document jsonDoc;
+	if (!rapidjsonHelper::parseFromFile(jsonDoc, "test_load.json"))
+		return false;
+
+	// print memory usage by value kind
+	const auto report = rapidjsonHelper::memoryReport(jsonDoc);
+	std::printf("objects %zu (members %zu, %zu bytes)\n", report.objectCount, report.memberCount, report.memberBytes);
+	std::printf("arrays %zu (elements %zu, %zu bytes)\n", report.arrayCount, report.elementCount, report.elementBytes);
+	std::printf("strings %zu (%zu bytes), short strings %zu (%zu bytes)\n", report.stringCount, report.stringBytes, report.shortStringCount, report.shortStringBytes);
+	std::printf("allocator size %zu, capacity %zu\n", report.allocatorSize, report.allocatorCapacity);
+#if RAPIDJSON_ALLOCATOR_STATS
+	std::printf("allocator requested %zu, reserved %zu, chunks %zu, peak %zu, abandoned %zu\n",
+		report.allocatorStats.requested, report.allocatorStats.reserved, report.allocatorStats.chunkCount,
+		report.allocatorStats.peak, report.allocatorStats.abandoned);
+#endif
+
+	// a known document: 4 members, 2 long strings (5 short ones with the keys) and a 2-element array
+	const std::string title(40, 't'), tag(30, 'g');
+	rapidjson::Document known;
+	known.Parse(("{\"id\":7,\"title\":\"" + title + "\",\"tags\":[\"x\",\"" + tag + "\"],\"none\":[]}").c_str());
+	const auto counts = rapidjsonHelper::memoryReport(known);
+	const size_t memberBytes = rapidjson::Value::MemberStorageSize(4), elementBytes = rapidjson::Value::ElementStorageSize(2);
+	const size_t used = RAPIDJSON_ALIGN(memberBytes) + RAPIDJSON_ALIGN(elementBytes) + RAPIDJSON_ALIGN(title.size() + 1) + RAPIDJSON_ALIGN(tag.size() + 1);
+	if (counts.objectCount != 1 || counts.memberCount != 4 || counts.memberBytes != memberBytes
+		|| counts.arrayCount != 2 || counts.elementCount != 2 || counts.elementBytes != elementBytes || counts.packedArrayCount != 0
+		|| counts.stringCount != 2 || counts.stringBytes != title.size() + tag.size() + 2
+		|| counts.shortStringCount != 5 || counts.shortStringBytes != std::string("idtitletagsnonex").size()
+		|| counts.allocatorSize != used || counts.allocatorCapacity != 64 * 1024)
+		return false;
+#if RAPIDJSON_ALLOCATOR_STATS
+	// one 64 KB chunk; growing the tags array moves its elements and leaves the old buffer behind
+	const size_t requested = memberBytes + elementBytes + title.size() + 1 + tag.size() + 1;
+	if (counts.allocatorStats.requested != requested || counts.allocatorStats.chunkCount != 1 || counts.allocatorStats.abandoned != 0
+		|| counts.allocatorStats.reserved != RAPIDJSON_ALIGN(3 * sizeof(size_t)) + 64 * 1024 || counts.allocatorStats.peak != counts.allocatorStats.reserved)
+		return false;
+	known["tags"].PushBack(1, known.GetAllocator());
+	if (rapidjsonHelper::memoryReport(known).allocatorStats.abandoned != RAPIDJSON_ALIGN(elementBytes))
+		return false;
+
+	// CrtAllocator counts every block; realloc() releases the old one, so nothing is abandoned
+	rapidjson::CrtAllocator crt;
+	void* block = crt.Malloc(100);
+	block = crt.Realloc(block, 100, 300);
+	const auto crtStats = crt.GetStats();
+	rapidjson::CrtAllocator::Free(block);
+	if (crtStats.requested != 300 || crtStats.reserved != 300 || crtStats.chunkCount != 1 || crtStats.abandoned != 0)
+		return false;
+#endif
+	return true;
+}
+
+bool TestCompact() {
+	rapidjson::Document jsonDoc;
+	if (!rapidjsonHelper::parseFromFile(jsonDoc, "test_load.json"))
+		return false;
+
+	// editing the document leaves abandoned blocks in the pool
+	for (auto& member : jsonDoc.GetArray()) {
+		member.EraseMember("price");
+		rapidjsonHelper::insertValue(member, "description", std::string("a description longer than a short string"), jsonDoc.GetAllocator());
+	}
+
+	const auto before = rapidjsonHelper::writeToStream(jsonDoc);
+	const auto reclaimed = rapidjsonHelper::compact(jsonDoc);
+	std::printf("compact reclaimed %zu bytes, capacity now %zu\n", reclaimed, jsonDoc.GetAllocator().Capacity());
+	return before == rapidjsonHelper::writeToStream(jsonDoc);
+}
+
+bool TestHugePageLoad() {
+	// same loader as TestLoadData, with the document pool backed by huge pages
+	rapidjsonHelper::HugePageDocument jsonDoc;
+	if (!rapidjsonHelper::parseFromFile(jsonDoc, "test_load.json"))
+		return false;
+
+	int64_t vnumSum = 0;
+	for (auto& member : jsonDoc.GetArray())
+		vnumSum += rapidjsonHelper::getValue<int64_t>(member, "vnum");
+	std::printf("huge page document: %u rows, vnum sum %" PRIi64 ", capacity %zu\n", jsonDoc.Size(), vnumSum, jsonDoc.GetAllocator().Capacity());
+	return true;
+}
+
+bool TestSimdKernels() {
+	std::printf("simd kernel: %s\n", rapidjson::GetSimdKernelName(rapidjson::GetSimdKernel()));
+
+	// every kernel set supported by this cpu must load and save the same document
+	const auto active = rapidjson::GetSimdKernel();
+	std::string expected;
+	bool ok = true;
+	for (int kernel = rapidjson::kSimdKernelScalar; kernel < rapidjson::kSimdKernelCount; ++kernel) {
+		if (!rapidjson::SetSimdKernel(static_cast<rapidjson::SimdKernel>(kernel)))
+			continue;
+		rapidjson::Document jsonDoc;
+		if (!rapidjsonHelper::parseFromFile(jsonDoc, "test_load.json")) {
+			ok = false;
+			break;
+		}
+		const auto saved = rapidjsonHelper::writeToStream(jsonDoc);
+		if (expected.empty())
+			expected = saved;
+		else if (saved != expected) {
+			std::printf("simd kernel %s: output differs\n", rapidjson::GetSimdKernelName(static_cast<rapidjson::SimdKernel>(kernel)));
+			ok = false;
+		}
+	}
+	rapidjson::SetSimdKernel(active);
+
+#ifdef RAPIDJSON_SIMD_DISPATCH
+	// parsing threads may observe a kernel switch at any point, each table gives the same result
+	std::atomic<bool> done{false};
+	std::atomic<int> mismatches{0};
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 2; t++)
+		readers.emplace_back([&] {
+			for (int i = 0; i < 200; i++) {
+				rapidjson::Document jsonDoc;
+				if (!rapidjsonHelper::parseFromStream(jsonDoc, expected) || rapidjsonHelper::writeToStream(jsonDoc) != expected)
+					mismatches++;
+			}
+		});
+	std::thread switcher([&] {
+		for (int i = 0; !done; i = (i + 1) % rapidjson::kSimdKernelCount)
+			rapidjson::SetSimdKernel(static_cast<rapidjson::SimdKernel>(i));
+	});
+	for (auto& reader : readers)
+		reader.join();
+	done = true;
+	switcher.join();
+	rapidjson::SetSimdKernel(active);
+	ok = ok && mismatches == 0;
+#endif
+	return ok;
+}
+
+// documents whose last byte sits at the end of a buffer, for the skip and scan kernels
+struct EdgeCase {
+	std::string json;
+	size_t stringLength;
+	bool numeric = false;  // a number instead of a string
+	double number = 0;
+};
+
+std::vector<EdgeCase> simdEdgeCases() {
+	// every whitespace and string tail length up to two 64-byte blocks
+	std::vector<EdgeCase> cases;
+	for (size_t i = 0; i < 130; i++) {
+		const std::string ws(i, ' '), text(i, 'a');
+		cases.push_back({"[" + ws + "\"" + text + "\"" + ws + "]" + ws, i});
+		cases.push_back({std::string(i % 3, '\n') + "\"" + text + "\"", i});
+	}
+	// every integer and fraction digit run length that the 8-byte digit loads take
+	const std::string digits = "1234567891234567891";
+	for (size_t i = 1; i <= digits.size(); i++) {
+		const std::string run = digits.substr(0, i);
+		cases.push_back({run, 0, true, std::strtod(run.c_str(), nullptr)});
+		cases.push_back({"[" + run + "]", 0, true, std::strtod(run.c_str(), nullptr)});
+		if (i <= 15)
+			cases.push_back({"0." + run, 0, true, std::strtod(("0." + run).c_str(), nullptr)});
+	}
+	return cases;
+}
+
+bool checkEdgeParse(const rapidjson::Document& jsonDoc, const EdgeCase& edge) {
+	if (jsonDoc.HasParseError())
+		return false;
+	const auto& value = jsonDoc.IsArray() && jsonDoc.Size() == 1 ? jsonDoc[0] : static_cast<const rapidjson::Value&>(jsonDoc);
+	if (edge.numeric)
+		return value.IsNumber() && value.GetDouble() == edge.number;
+	return value.IsString() && value.GetStringLength() == edge.stringLength;
+}
+
+bool checkEdgeWrite(const char* text, size_t length) {
+	rapidjson::StringBuffer buffer;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+	writer.String(text, static_cast<rapidjson::SizeType>(length));
+	std::string expected = "\"";
+	for (size_t i = 0; i < length; i++)
+		expected += text[i] == '"' ? "\\\"" : std::string(1, text[i]);
+	return buffer.GetString() == expected + "\"";
+}
+
+// parses and writes each edge case from an exactly sized heap buffer (caught by address sanitizers)
+// and from the end of a page followed by an inaccessible one (caught by the MMU)
+bool testSimdEdges(const std::vector<EdgeCase>& cases, char* region, size_t regionSize) {
+	for (const auto& edge : cases) {
+		const size_t size = edge.json.size();
+
+		auto exact = std::make_unique<char[]>(size + 1);
+		std::memcpy(exact.get(), edge.json.c_str(), size + 1);
+		rapidjson::Document zeroTerminated, bounded;
+		zeroTerminated.Parse(exact.get());
+		auto unterminated = std::make_unique<char[]>(size);
+		std::memcpy(unterminated.get(), edge.json.data(), size);
+		bounded.Parse(unterminated.get(), size);
+		if (!checkEdgeParse(zeroTerminated, edge) || !checkEdgeParse(bounded, edge))
+			return false;
+
+		if (region && size + 1 <= regionSize) {
+			char* zeroEnd = region + regionSize - size - 1;
+			std::memcpy(zeroEnd, edge.json.c_str(), size + 1);
+			rapidjson::Document paged, insitu;
+			paged.Parse(zeroEnd);
+			if (!checkEdgeParse(paged, edge))
+				return false;
+			insitu.ParseInsitu(zeroEnd);
+			if (!checkEdgeParse(insitu, edge))
+				return false;
+
+			char* end = region + regionSize - size;
+			std::memcpy(end, edge.json.data(), size);
+			rapidjson::Document pagedBounded;
+			pagedBounded.Parse(end, size);
+			if (!checkEdgeParse(pagedBounded, edge))
+				return false;
+
+			// string to escape ending at the page end, with a quote as its last character
+			char* text = region + regionSize - edge.stringLength;
+			std::memset(text, 'a', edge.stringLength);
+			if (edge.stringLength % 2)
+				text[edge.stringLength - 1] = '"';
+			if (!checkEdgeWrite(text, edge.stringLength))
+				return false;
+		}
+
+		// an unterminated string running into the end of the buffer
+		if (edge.stringLength && edge.json.back() == '"') {
+			rapidjson::Document truncated;
+			truncated.Parse(unterminated.get(), size - 1);
+			if (!truncated.HasParseError())
+				return false;
+		}
+	}
+	return true;
+}
+
+bool TestSimdEdges() {
+	const auto cases = simdEdgeCases();
+	char* region = nullptr;
+	size_t pageSize = 0;
+#if RAPIDJSON_HAS_MMAP
+	pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	void* mapped = mmap(nullptr, 2 * pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mapped != MAP_FAILED && mprotect(static_cast<char*>(mapped) + pageSize, pageSize, PROT_NONE) == 0)
+		region = static_cast<char*>(mapped);
+#endif
+
+	const auto active = rapidjson::GetSimdKernel();
+	bool ok = true;
+	for (int kernel = rapidjson::kSimdKernelScalar; kernel < rapidjson::kSimdKernelCount && ok; ++kernel) {
+		if (!rapidjson::SetSimdKernel(static_cast<rapidjson::SimdKernel>(kernel)))
+			continue;
+		ok = testSimdEdges(cases, region, pageSize);
+		if (!ok)
+			std::printf("simd kernel %s: buffer edge case failed\n", rapidjson::GetSimdKernelName(static_cast<rapidjson::SimdKernel>(kernel)));
+	}
+	rapidjson::SetSimdKernel(active);
+
+#if RAPIDJSON_HAS_MMAP
+	if (mapped != MAP_FAILED)
+		munmap(mapped, 2 * pageSize);
+#endif
+	return ok;
+}
+
+bool TestShortestDouble() {
+	// doubles written with the shortest round-trip engine must parse back to the same bits
+	const double values[] = { 11.11, 0.1 + 0.2, 1e23, 5e-324, 2.2250738585072014e-308, 1.7976931348623157e308, -123456.789, 9007199254740993.0 };
+	rapidjson::StringBuffer buffer;
+	rapidjson::Writer<rapidjson::StringBuffer, rapidjson::UTF8<>, rapidjson::UTF8<>, rapidjson::CrtAllocator, rapidjson::kWriteShortestDoubleFlag> writer(buffer);
+	writer.StartArray();
+	for (auto value : values)
+		writer.Double(value);
+	writer.EndArray();
+	std::printf("shortest doubles: %s\n", buffer.GetString());
+
+	rapidjson::Document jsonDoc;
+	jsonDoc.Parse<rapidjson::kParseFullPrecisionFlag>(buffer.GetString());
+	if (jsonDoc.HasParseError() || jsonDoc.Size() != std::size(values))
+		return false;
+	for (rapidjson::SizeType i = 0; i < jsonDoc.Size(); ++i)
+		if (jsonDoc[i].GetDouble() != values[i])
+			return false;
+	return true;
+}
+
+bool TestFixedDecimals() {
+	// fixed-point output must match the truncated shortest representation
+	const double values[] = { 11.11, 0.5, 1234.5, 0.1 + 0.2, 2.675, 1e-7, 100.0, -0.015, 123456789.125 };
+	rapidjson::StringBuffer buffer;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+	writer.SetMaxDecimalPlaces(2);
+	writer.StartArray();
+	for (auto value : values)
+		writer.Double(value);
+	writer.EndArray();
+	return std::strcmp(buffer.GetString(), "[11.11,0.5,1234.5,0.3,2.67,0.0,100.0,-0.01,123456789.12]") == 0;
+}
+
+// random decimal literal: 1 to 25 significant digits, an optional point and an exponent from the
+// subnormal range to the overflow threshold
+std::string randomDecimal(uint64_t& x) {
+	auto next = [&x] { x ^= x << 13; x ^= x >> 7; x ^= x << 17; return x; };
+	std::string number = next() % 4 ? "" : "-";
+	const size_t digits = 1 + next() % 25;
+	for (size_t i = 0; i < digits; i++)
+		number += static_cast<char>('0' + (i == 0 ? 1 + next() % 9 : next() % 10));
+	if (next() % 2)
+		number.insert(1 + (number[0] == '-') + next() % digits, ".");
+	if (number.back() == '.')
+		number += '0';
+	const int exponent = next() % 3 ? static_cast<int>(next() % 660) - 345 : static_cast<int>(next() % 40) - 345;  // a third near 4.9e-324
+	return number + "e" + std::to_string(exponent);
+}
+
+// exact decimal of the midpoint between a random double and the next one up, where long double can hold it
+std::string randomHalfway(uint64_t& x) {
+	if (std::numeric_limits<long double>::digits < 64)
+		return {};
+	x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+	double d;
+	uint64_t bits = x & 0x7FEFFFFFFFFFFFFFull;  // finite, below the largest double
+	std::memcpy(&d, &bits, sizeof(d));
+	const long double halfway = (static_cast<long double>(d) + std::nextafter(d, HUGE_VAL)) / 2;
+	char buffer[1200];
+	std::snprintf(buffer, sizeof(buffer), "%.1100Le", halfway);  // glibc prints the exact value
+	std::string number = buffer;
+	const size_t e = number.find('e');
+	const size_t last = number.find_last_not_of('0', e - 1);
+	return number.substr(0, number[last] == '.' ? last : last + 1) + number.substr(e);
+}
+
+bool TestFullPrecisionParse() {
+	// correctly rounded parsing, including halfway cases and digits beyond 64 bits
+	std::vector<std::string> numbers = { "9007199254740993", "2.2250738585072011e-308", "4.9406564584124654e-324", "1.7976931348623157e308",
+		"8.5600939128708100556e-14", "7.625300685289994415472833505428e-74", "0.1000000000000000055511151231257827", "123456789012345678901234567890e-10" };
+	// differential against strtod over random literals and exact midpoints
+	uint64_t x = 0x9E3779B97F4A7C15ull;
+	for (int i = 0; i < 50000; i++)
+		numbers.push_back(randomDecimal(x));
+	for (int i = 0; i < 2000; i++)
+		if (std::string halfway = randomHalfway(x); !halfway.empty())
+			numbers.push_back(halfway);
+
+	for (const auto& number : numbers) {
+		rapidjson::Document jsonDoc;
+		jsonDoc.Parse<rapidjson::kParseFullPrecisionFlag>(number.c_str());
+		const double expected = std::strtod(number.c_str(), nullptr), parsed = jsonDoc.HasParseError() ? 0 : jsonDoc.GetDouble();
+		if (std::isinf(expected) ? !jsonDoc.HasParseError() : jsonDoc.HasParseError() || std::memcmp(&expected, &parsed, sizeof(double)) != 0) {
+			std::fprintf(stderr, "FULL PRECISION MISMATCH %s\n", number.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+bool TestMemberIndex() {
+	// large objects look members up through the hash index, which must follow removals
+	rapidjson::Document doc;
+	auto& allocator = doc.GetAllocator();
+	doc.SetObject();
+	for (int i = 0; i < 1000; i++) {
+		rapidjson::Value name(std::to_string(i).c_str(), allocator);
+		doc.AddMember(name, rapidjson::Value(i), allocator);
+	}
+	for (int i = 0; i < 1000; i += 3)
+		doc.RemoveMember(std::to_string(i).c_str());
+	doc.EraseMember(std::to_string(1).c_str());
+	for (int i = 0; i < 1000; i++) {
+		auto it = doc.FindMember(std::to_string(i).c_str());
+		bool removed = i % 3 == 0 || i == 1;
+		if (removed != (it == doc.MemberEnd()) || (!removed && it->value.GetInt() != i))
+			return false;
+	}
+
+	rapidjson::Document copy;
+	copy.CopyFrom(doc, copy.GetAllocator());
+	return copy == doc;
+}
+
+bool TestInternKeys() {
+	// a large table whose rows repeat the same keys, some longer than a short string
+	std::string json = "[";
+	for (int i = 0; i < 10000; i++) {
+		json += i ? "," : "";
+		json += "{\"vnum\":" + std::to_string(i) + ",\"count\":1,\"item_description_text\":\"-\",\"minimum_required_character_level\":" + std::to_string(i % 120) + "}";
+	}
+	json += "]";
+
+	rapidjson::Document plain, interned;
+	if (!rapidjsonHelper::parseFromStream(plain, json) || !rapidjsonHelper::parseFromStream<rapidjson::kParseInternKeysFlag>(interned, json))
+		return false;
+
+	const auto before = rapidjsonHelper::memoryReport(plain);
+	const auto after = rapidjsonHelper::memoryReport(interned);
+	std::printf("interned keys: allocator size %zu -> %zu bytes, %zu keys sharing %zu bytes\n",
+		before.allocatorSize, after.allocatorSize, after.sharedStringCount, after.sharedStringBytes);
+
+	// a copy owns its keys and outlives the source document
+	rapidjson::Document copy;
+	{
+		rapidjson::Document source;
+		rapidjsonHelper::parseFromStream<rapidjson::kParseInternKeysFlag>(source, json);
+		copy.CopyFrom(source, copy.GetAllocator());
+	}
+	if (copy != plain || copy[0].MemberBegin()[3].name.IsSharedString())
+		return false;
+
+	// identical keys share one pointer, also after compaction
+	rapidjsonHelper::compact(interned);
+	const auto& rows = interned.GetArray();
+	return plain == interned && after.allocatorSize < before.allocatorSize
+		&& rows[0].MemberBegin()[3].name.GetString() == rows[9999].MemberBegin()[3].name.GetString();
+}
+
+void BenchmarkMemberCache() {
+	// 200k rows with the same layout, read through getValue with and without lookup-site caches
+	std::string json = "[";
+	for (int i = 0; i < 200000; i++) {
+		json += i ? "," : "";
+		json += "{\"id\":" + std::to_string(i) + ",\"vnum\":" + std::to_string(i * 10) + ",\"count\":" + std::to_string(i % 200)
+			+ ",\"price\":" + std::to_string(i * 3) + ",\"name\":\"item\",\"factor\":1.5}";
+	}
+	json += "]";
+
+	rapidjson::Document jsonDoc;
+	if (!rapidjsonHelper::parseFromStream(jsonDoc, json))
+		return;
+
+	const auto start = std::chrono::steady_clock::now();
+	double plainSum = 0;
+	for (auto& row : jsonDoc.GetArray())
+		plainSum += rapidjsonHelper::getValue<double>(row, "factor") + rapidjsonHelper::getValue<int64_t>(row, "price") + rapidjsonHelper::getValue<int>(row, "count");
+	const auto middle = std::chrono::steady_clock::now();
+
+	rapidjsonHelper::MemberCache factor("factor"), price("price"), count("count");
+	double cachedSum = 0;
+	for (auto& row : jsonDoc.GetArray())
+		cachedSum += rapidjsonHelper::getValue<double>(row, factor) + rapidjsonHelper::getValue<int64_t>(row, price) + rapidjsonHelper::getValue<int>(row, count);
+	const auto end = std::chrono::steady_clock::now();
+
+	const size_t hits = factor.hits + price.hits + count.hits;
+	const size_t lookups = hits + factor.misses + price.misses + count.misses;
+	std::printf("member cache: %.2f ms -> %.2f ms, hit rate %.4f%%%s\n",
+		std::chrono::duration<double, std::milli>(middle - start).count(), std::chrono::duration<double, std::milli>(end - middle).count(),
+		100.0 * hits / lookups, plainSum == cachedSum ? "" : " (MISMATCH)");
+}
+
+bool TestColumns() {
+	// a table with a missing field, an integer column turning into doubles and a mistyped cell
+	std::string json = "[";
+	for (int i = 0; i < 100000; i++) {
+		json += i ? "," : "";
+		json += "{\"vnum\":" + std::to_string(i) + ",\"price\":" + std::to_string(i % 1000) + ",\"name\":\"item" + std::to_string(i % 7) + "\"";
+		json += i % 10 ? ",\"factor\":" + std::to_string(i % 100) + (i == 501 ? ".5" : "") : "";
+		json += "}";
+	}
+	json += ",{\"vnum\":\"bad\"}]";
+
+	rapidjson::Document jsonDoc;
+	if (!rapidjsonHelper::parseFromStream(jsonDoc, json))
+		return false;
+
+	// reference values walking the tree
+	const auto start = std::chrono::steady_clock::now();
+	int64_t priceSum = 0;
+	double factorSum = 0;
+	size_t expensive = 0;
+	for (auto& row : jsonDoc.GetArray()) {
+		auto price = row.FindMember("price");
+		auto factor = row.FindMember("factor");
+		if (price != row.MemberEnd()) {
+			priceSum += price->value.GetInt64();
+			expensive += price->value.GetInt64() > 900;
+		}
+		if (factor != row.MemberEnd())
+			factorSum += factor->value.GetDouble();
+	}
+	const auto middle = std::chrono::steady_clock::now();
+
+	const auto columns = rapidjsonHelper::toColumns(jsonDoc);
+	const auto converted = std::chrono::steady_clock::now();
+
+	const auto* price = columns.find("price");
+	const auto* factor = columns.find("factor");
+	const auto* vnum = columns.find("vnum");
+	const auto* name = columns.find("name");
+	if (!price || !factor || !vnum || !name)
+		return false;
+
+	// the query of the tree walk on the columns
+	const auto mask = rapidjsonHelper::filterColumn<int64_t>(*price, [](int64_t value) { return value > 900; });
+	const bool ok = rapidjsonHelper::sumColumn<int64_t>(*price) == priceSum
+		&& rapidjsonHelper::countRows(mask) == expensive
+		&& rapidjsonHelper::sumColumn<double>(*factor) == factorSum;
+	const auto end = std::chrono::steady_clock::now();
+
+	// the conversion pays off once it costs less than the tree walks it saves
+	const double walkMs = std::chrono::duration<double, std::milli>(middle - start).count();
+	const double convertMs = std::chrono::duration<double, std::milli>(converted - middle).count();
+	const double queryMs = std::chrono::duration<double, std::milli>(end - converted).count();
+	std::printf("columns: %zu rows, tree walk %.2f ms, toColumns %.2f ms, query on columns %.3f ms, break-even after %.0f queries\n",
+		columns.rowCount, walkMs, convertMs, queryMs, std::ceil(convertMs / (walkMs - queryMs)));
+
+	return ok && factor->type == rapidjsonHelper::Column::Type::Double && factor->nullCount == 10001
+		&& rapidjsonHelper::maxColumn<double>(*factor, &mask) == 99.0
+		&& rapidjsonHelper::minColumn<int64_t>(*vnum) == 0 && !vnum->isValid(100000)
+		&& name->getString(12) == "item5";
+}
+
+bool TestPackedArrays() {
+	// 1M doubles and 1M integers, as regular and as packed arrays
+	std::string json = "{\"factors\":[";
+	for (int i = 0; i < 1000000; i++)
+		json += (i ? "," : "") + std::to_string(i) + ".25";
+	json += "],\"vnums\":[";
+	for (int i = 0; i < 1000000; i++)
+		json += (i ? "," : "") + std::to_string(i * 7);
+	json += "]}";
+
+	rapidjson::Document plain, packed;
+	if (!rapidjsonHelper::parseFromStream(plain, json) || !rapidjsonHelper::parseFromStream<rapidjson::kParsePackedArraysFlag>(packed, json))
+		return false;
+
+	const auto before = rapidjsonHelper::memoryReport(plain);
+	const auto after = rapidjsonHelper::memoryReport(packed);
+	std::printf("packed arrays: %zu of %zu, element bytes %zu -> %zu\n", after.packedArrayCount, after.arrayCount, before.elementBytes, after.elementBytes);
+
+	const auto factors = rapidjsonHelper::getPackedArray<double>(packed["factors"]);
+	const auto vnums = rapidjsonHelper::getPackedArray<int64_t>(packed["vnums"]);
+	if (factors.size() != 1000000 || vnums.size() != 1000000 || factors[3] != 3.25 || vnums[3] != 21)
+		return false;
+
+	// packed elements are not values: element accessors and pointers must not reach them, ElementAt() reads
+	// them and pointers erase them in place
+	const auto& vnumArray = packed["vnums"];
+	rapidjson::Value scratch;
+	if (vnumArray.IsArray() || vnumArray.GetType() != rapidjson::kArrayType || vnumArray.Size() != 1000000
+		|| rapidjson::GetValueByPointer(packed, "/vnums/1") || !rapidjson::GetValueByPointer(plain, "/vnums/1")
+		|| vnumArray.ElementAt(1, scratch).GetInt64() != 7 || packed["factors"].ElementAt(1, scratch).GetDouble() != 1.25
+		|| !rapidjson::Pointer("/vnums/1").Erase(packed) || !rapidjson::Pointer("/vnums/1").Erase(plain)
+		|| !vnumArray.IsPackedArray() || vnumArray.Size() != 999999 || vnumArray.GetInt64Array()[1] != 14)
+		return false;
+
+	// a schema parsed with packed arrays keeps its numeric enums
+	for (const char* schemaText : { R"({"enum":[1,2,3]})", R"({"enum":[1.5,2.5]})" }) {
+		rapidjson::Document schemaJson;
+		schemaJson.Parse<rapidjson::kParsePackedArraysFlag>(schemaText);
+		const rapidjson::SchemaDocument schema(schemaJson);
+		rapidjson::Document allowed, rejected;
+		allowed.Parse(schemaJson["enum"].IsInt64Array() ? "2" : "2.5");
+		rejected.Parse("5");
+		rapidjson::SchemaValidator validator(schema);
+		const bool allowedValid = allowed.Accept(validator);
+		validator.Reset();
+		if (!schemaJson["enum"].IsPackedArray() || !allowedValid || rejected.Accept(validator) || schema.GetRoot().GetEnum().Size() != schemaJson["enum"].Size())
+			return false;
+	}
+	rapidjson::Document small;
+	small.Parse<rapidjson::kParsePackedArraysFlag>(R"({"a":[1,2,3]})");
+	rapidjson::Pointer("/a/1").Set(small, 5);
+	if (small["a"].IsPackedArray() || !small["a"].IsArray() || small["a"][1].GetInt() != 5 || small["a"].Size() != 3)
+		return false;
+
+	// mutation turns the array back into regular elements
+	packed["vnums"].PushBack(-1, packed.GetAllocator());
+	plain["vnums"].PushBack(-1, plain.GetAllocator());
+	return !packed["vnums"].IsPackedArray() && packed == plain
+		&& rapidjsonHelper::writeToStream(packed) == rapidjsonHelper::writeToStream(plain);
+}
+
+// rows of test_load.json, also the source of test_load_parser.h
+const char* loadSchema = R"({
+	"type": "array",
+	"items": {
+		"type": "object",
+		"properties": {
+			"vnum": { "type": "integer", "minimum": 0 },
+			"count": { "type": "integer" },
+			"price": { "type": "integer" },
+			"name": { "type": "string" },
+			"factor": { "type": "number" }
+		},
+		"required": [ "vnum", "count", "name" ]
+	}
+})";
+
+bool TestSchemaLoad() {
+	rapidjson::Document schemaJson;
+	if (!rapidjsonHelper::parseFromStream(schemaJson, loadSchema))
+		return false;
+	const rapidjson::SchemaDocument schema(schemaJson);
+
+	rapidjsonHelper::LoadTiming timing;
+	rapidjson::Document jsonDoc;
+	if (!rapidjsonHelper::parseFromFile(jsonDoc, "test_load.json", schema, &timing) || jsonDoc.Size() != 2)
+		return false;
+	std::printf("validated load test_load.json: %zu bytes in %.3f ms\n", timing.bytes, timing.milliseconds);
+
+	// the document of a validated load interns keys and packs arrays like a plain parse
+	rapidjson::Document packedDoc;
+	const char* rows = R"([{"vnum":1,"count":2,"name":"a","spawn_room_numbers_of_zone":[3001,3002]},{"vnum":2,"count":1,"name":"b","spawn_room_numbers_of_zone":[3003]}])";
+	if (!rapidjsonHelper::parseFromStream<rapidjson::kParseInternKeysFlag | rapidjson::kParsePackedArraysFlag>(packedDoc, rows, schema)
+		|| !packedDoc[0]["spawn_room_numbers_of_zone"].IsInt64Array() || !packedDoc[0].MemberBegin()[3].name.IsSharedString()
+		|| packedDoc[0].MemberBegin()[3].name.GetString() != packedDoc[1].MemberBegin()[3].name.GetString())
+		return false;
+
+	// a row without "name" is rejected
+	rapidjson::Document invalidDoc;
+	return !rapidjsonHelper::parseFromStream(invalidDoc, R"([{"vnum":1,"count":2}])", schema);
+}
+
+bool TestSchemaDispatch() {
+	// wide schemas resolve property names and enum values through hash tables
+	std::string schemaJson = R"({"type":"object","additionalProperties":false,"properties":{"state":{"enum":[)";
+	for (int i = 0; i < 100; i++)
+		schemaJson += (i ? ",\"s" : "\"s") + std::to_string(i) + "\"";
+	schemaJson += "]}";
+	for (int i = 0; i < 100; i++)
+		schemaJson += ",\"f" + std::to_string(i) + "\":{\"type\":\"integer\"}";
+	schemaJson += "}}";
+	rapidjson::Document schemaDoc;
+	if (!rapidjsonHelper::parseFromStream(schemaDoc, schemaJson))
+		return false;
+	const rapidjson::SchemaDocument schema(schemaDoc);
+
+	auto isValid = [&](const char* json) {
+		rapidjson::Document jsonDoc;
+		jsonDoc.Parse(json);
+		rapidjson::SchemaValidator validator(schema);
+		return jsonDoc.Accept(validator);
+	};
+	return isValid(R"({"f0":1,"f99":2,"state":"s99"})")
+		&& !isValid(R"({"f0":1,"f100":2})")
+		&& !isValid(R"({"f0":"x"})")
+		&& !isValid(R"({"state":"s100"})");
+}
+
+bool TestSchemaPatterns() {
+	// pattern and patternProperties go through the cached DFA and the literal prefilters
+	rapidjson::Document schemaDoc;
+	if (!rapidjsonHelper::parseFromStream(schemaDoc, R"({
+		"type": "object",
+		"patternProperties": {
+			"^x-[a-z]+$": { "type": "string", "pattern": "^[A-Z]{2}[0-9]{4,8}$" },
+			"_id$": { "type": "integer" }
+		}
+	})"))
+		return false;
+	const rapidjson::SchemaDocument schema(schemaDoc);
+
+	auto isValid = [&](const char* json) {
+		rapidjson::Document jsonDoc;
+		jsonDoc.Parse(json);
+		rapidjson::SchemaValidator validator(schema);
+		return jsonDoc.Accept(validator);
+	};
+	if (!isValid(R"({"x-trace":"AB12345","record_id":7,"x-Trace":0,"id_":"7"})") || isValid(R"({"x-trace":"AB123"})") || isValid(R"({"record_id":"7"})"))
+		return false;
+
+	// the regex stays immutable, each search object grows its own DFA
+	const rapidjson::internal::Regex regex("^[a-z]+_(count|total)$");
+	rapidjson::internal::RegexSearch search(regex);
+	return search.Search("item_count") && search.Search("gold_total") && !search.Search("item_sum") && !search.Search("Item_count")
+		&& regex.Match("mob_total") && !regex.Search("mob_totals");
+}
+
+bool TestValidatorPool() {
+	// worker threads share warmed validators for one compiled schema
+	rapidjson::Document schemaDoc;
+	if (!rapidjsonHelper::parseFromStream(schemaDoc, R"({
+		"type": "array",
+		"items": {
+			"type": "object",
+			"properties": {
+				"vnum": { "type": "integer", "minimum": 0 },
+				"name": { "type": "string", "pattern": "^[a-z]+$" },
+				"tags": { "type": "array", "uniqueItems": true }
+			},
+			"patternProperties": { "^x-[a-z]+$": { "type": "integer" } },
+			"required": [ "vnum", "name" ]
+		}
+	})"))
+		return false;
+	const rapidjson::SchemaDocument schema(schemaDoc);
+	rapidjsonHelper::ValidatorPool pool(schema);
+
+	// the patterns make every worker run the shared schema's regexes
+	rapidjson::Document jsonDoc;
+	if (!rapidjsonHelper::parseFromStream(jsonDoc, R"([{"vnum":1,"name":"a","tags":[1,2],"x-spawn":3},{"vnum":2,"name":"bat","x-zone":7}])"))
+		return false;
+
+	const int threadCount = 4;
+	std::vector<int> validCounts(threadCount);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threadCount; t++)
+		threads.emplace_back([&, t] {
+			for (int i = 0; i < 1000; i++)
+				validCounts[t] += rapidjsonHelper::validate(jsonDoc, pool);
+		});
+	for (auto& thread : threads)
+		thread.join();
+	for (int validCount : validCounts)
+		if (validCount != 1000)
+			return false;
+
+	// a lease assigned over another one returns the validator it held
+	const size_t idle = pool.size();
+	{
+		auto first = pool.acquire();
+		auto second = pool.acquire();
+		first = std::move(second);
+		if (pool.size() != std::max<size_t>(idle, 2) - 1)
+			return false;
+	}
+	if (pool.size() != std::max<size_t>(idle, 2))
+		return false;
+
+	rapidjson::Document invalidDoc, badName, badExtra;
+	invalidDoc.Parse(R"([{"vnum":1,"name":"a","tags":[1,1]}])");
+	badName.Parse(R"([{"vnum":1,"name":"A1"}])");
+	badExtra.Parse(R"([{"vnum":1,"name":"a","x-spawn":"3"}])");
+	return !rapidjsonHelper::validate(invalidDoc, pool) && !rapidjsonHelper::validate(badName, pool)
+		&& !rapidjsonHelper::validate(badExtra, pool) && rapidjsonHelper::validate(jsonDoc, pool)
+		&& pool.size() <= threadCount;
+}
+
+bool TestHashValue() {
+	rapidjson::Document a, b, c;
+	a.Parse(R"({"name":"sword","stats":{"atk":12,"def":3},"tags":["rare","iron"]})");
+	b.Parse(R"({"tags":["rare","iron"],"stats":{"def":3.0,"atk":12},"name":"sword"})");
+	c.Parse(R"({"name":"sword","stats":{"atk":12,"def":3},"tags":["iron","rare"]})");
+	return rapidjsonHelper::hashValue(a) == rapidjsonHelper::hashValue(b)
+		&& rapidjsonHelper::hashValue(a) != rapidjsonHelper::hashValue(c)
+		&& rapidjsonHelper::hashValue(a["stats"]) == rapidjsonHelper::hashValue(b["stats"]);
+}
+
+bool TestMerkleHash() {
+	rapidjson::Document live, reloaded;
+	live.Parse(R"({"mobs":[{"vnum":169,"name":"Nymph"},{"vnum":179,"name":"Lion"}],"zone":{"id":3,"reset":15}})");
+	reloaded.Parse(R"({"zone":{"reset":15,"id":3.0},"mobs":[{"name":"Nymph","vnum":169},{"name":"Lion","vnum":179}]})");
+	if (live.GetHash() != reloaded.GetHash() || live != reloaded)
+		return false;
+
+	// mutating through the non-const accessors drops the cached hashes along the path
+	const uint64_t before = live.GetHash();
+	live["mobs"][1]["vnum"] = 180;
+	if (live.GetHash() == before || live["zone"].GetHash() != reloaded["zone"].GetHash())
+		return false;
+	if (live["mobs"].GetHash() == reloaded["mobs"].GetHash() || live == reloaded)
+		return false;
+
+	live["mobs"][1]["vnum"] = 179;
+	if (live.GetHash() != before || live != reloaded)
+		return false;
+
+	// operator== does not trust hashes left stale by a reference taken before hashing
+	rapidjson::Document a, b;
+	a.Parse(R"({"x":[1,2]})");
+	b.Parse(R"({"x":[3,2]})");
+	rapidjson::Value& first = a["x"][0];
+	a.GetHash();
+	b.GetHash();
+	first = 3;
+	if (a != b)
+		return false;
+
+	// integers are hashed exactly beyond 2^53, 1 and 1.0 still alike
+	a.Parse("[1,9007199254740993,18446744073709551615,-9007199254740993,18446744073709551616.0]");
+	b.Parse("[1.0,9007199254740992,18446744073709551614,-9007199254740992,18446744073709551616.0]");
+	return a[0].GetHash() == b[0].GetHash() && a[1].GetHash() != b[1].GetHash() && a[2].GetHash() != b[2].GetHash()
+		&& a[3].GetHash() != b[3].GetHash() && a[4].GetHash() == b[4].GetHash();
+}
+
+bool TestDiff() {
+	rapidjson::Document from, to, patch;
+	from.Parse(R"({"mobs":[{"vnum":169,"count":1},{"vnum":179,"count":2},{"vnum":189,"count":3}],"zone":"forest"})");
+	to.Parse(R"({"mobs":[{"vnum":189,"count":3},{"vnum":169,"count":5},{"vnum":199,"count":1}],"zone":"forest"})");
+
+	// rows matched by vnum: 179 removed, 169 moved behind 189 and changed, 199 added
+	rapidjsonHelper::diff(from, to, patch, {"vnum"});
+	const std::string expected = R"([{"op":"remove","path":"/mobs/1"},{"op":"move","from":"/mobs/0","path":"/mobs/1"},)"
+		R"({"op":"replace","path":"/mobs/1/count","value":5},{"op":"add","path":"/mobs/2","value":{"vnum":199,"count":1}}])";
+	if (rapidjsonHelper::writeToStream(patch) != expected)
+		return false;
+
+	// integers past 2^53 hash alike through their double value but still differ
+	from.Parse(R"({"id":9007199254740993,"max":18446744073709551615})");
+	to.Parse(R"({"id":9007199254740992,"max":18446744073709551614})");
+	rapidjsonHelper::diff(from, to, patch);
+	if (rapidjsonHelper::writeToStream(patch) != R"([{"op":"replace","path":"/id","value":9007199254740992},{"op":"replace","path":"/max","value":18446744073709551614}])")
+		return false;
+
+	rapidjsonHelper::diff(from, from, patch);
+	if (!patch.IsArray() || !patch.Empty())
+		return false;
+
+	// packed arrays are diffed element by element, also against a regular array
+	from.Parse<rapidjson::kParsePackedArraysFlag>(R"({"vnums":[1,2,3,4],"factors":[0.5,1.5],"plain":[7,8]})");
+	to.Parse<rapidjson::kParsePackedArraysFlag>(R"({"vnums":[1,5,3,4,6],"factors":[0.5,2.5],"plain":["x",8]})");
+	rapidjsonHelper::diff(from, to, patch);
+	if (rapidjsonHelper::writeToStream(patch) != R"([{"op":"replace","path":"/vnums/1","value":5},{"op":"add","path":"/vnums/4","value":6},)"
+		R"({"op":"replace","path":"/factors/1","value":2.5},{"op":"replace","path":"/plain/0","value":"x"}])")
+		return false;
+
+	// a change at the bottom of a deep chain: each level is hashed once, not once per ancestor
+	std::string deep, deeper;
+	for (int i = 0; i < 5000; i++)
+		deep += "[0,";
+	deeper = deep + "2" + std::string(5000, ']');
+	deep += "1" + std::string(5000, ']');
+	from.Parse<rapidjson::kParseIterativeFlag>(deep.c_str());
+	to.Parse<rapidjson::kParseIterativeFlag>(deeper.c_str());
+	rapidjsonHelper::diff(from, to, patch);
+	return patch.Size() == 1 && patch[0]["value"].GetInt() == 2 && patch[0]["path"].GetStringLength() == 5000 * 2;
+}
+
+bool TestPatch() {
+	rapidjson::Document from, to, patch;
+	from.Parse(R"({"mobs":[{"vnum":169,"count":1},{"vnum":179,"count":2},{"vnum":189,"count":3}],"zone":"forest"})");
+	to.Parse(R"({"mobs":[{"vnum":189,"count":3},{"vnum":169,"count":5},{"vnum":199,"count":1}],"zone":"forest"})");
+
+	rapidjson::Document jsonDoc;
+	jsonDoc.CopyFrom(from, jsonDoc.GetAllocator());
+	rapidjsonHelper::diff(from, to, patch, {"vnum"});
+	if (!rapidjsonHelper::applyPatch(jsonDoc, patch) || jsonDoc != to)
+		return false;
+
+	// the failing test rolls the copy and the removal back
+	patch.Parse(R"([{"op":"copy","from":"/mobs/0","path":"/boss"},{"op":"remove","path":"/zone"},{"op":"test","path":"/boss/vnum","value":0}])");
+	if (rapidjsonHelper::applyPatch(jsonDoc, patch) || jsonDoc != to)
+		return false;
+
+	// a move whose target parent is missing puts the moved value back, also behind a completed move
+	patch.Parse(R"([{"op":"move","from":"/mobs/2","path":"/rare"},{"op":"move","from":"/mobs/0","path":"/missing/x"}])");
+	if (rapidjsonHelper::applyPatch(jsonDoc, patch) || jsonDoc != to)
+		return false;
+
+	// reading packed elements leaves the array packed, a rolled back change packs it again
+	rapidjson::Document packed;
+	packed.Parse<rapidjson::kParsePackedArraysFlag>(R"({"ids":[1,2,3],"rates":[0.5,1.5]})");
+	patch.Parse(R"([{"op":"test","path":"/ids/1","value":2},{"op":"copy","from":"/rates/1","path":"/rate"}])");
+	if (!rapidjsonHelper::applyPatch(packed, patch) || !packed["ids"].IsPackedArray() || !packed["rates"].IsPackedArray() || packed["rate"].GetDouble() != 1.5)
+		return false;
+	patch.Parse(R"([{"op":"replace","path":"/ids/0","value":7},{"op":"remove","path":"/rates/0"},{"op":"add","path":"/ids/-","value":4},{"op":"test","path":"/rate","value":0}])");
+	if (rapidjsonHelper::applyPatch(packed, patch) || !packed["ids"].IsInt64Array() || !packed["rates"].IsDoubleArray()
+		|| rapidjsonHelper::writeToStream(packed) != R"({"ids":[1,2,3],"rates":[0.5,1.5],"rate":1.5})")
+		return false;
+
+	patch.Parse(R"({"zone":null,"mobs":{"vnum":169,"tags":null},"reset":{"mode":2,"empty":null}})");
+	rapidjsonHelper::applyMergePatch(jsonDoc, patch);
+	if (rapidjsonHelper::writeToStream(jsonDoc) != R"({"mobs":{"vnum":169},"reset":{"mode":2}})")
+		return false;
+
+	// values of a patch sharing the allocator are moved, its member names stay in place
+	rapidjson::Document shared(&jsonDoc.GetAllocator());
+	shared.Parse(R"({"reset":{"mode":3},"owner":"gnome"})");
+	rapidjsonHelper::applyMergePatch(jsonDoc, shared);
+	return rapidjsonHelper::writeToStream(jsonDoc) == R"({"mobs":{"vnum":169},"reset":{"mode":3},"owner":"gnome"})"
+		&& shared.HasMember("reset") && shared.HasMember("owner") && shared["owner"].IsNull();
+}
+
+bool TestGeneratedParser() {
+	rapidjson::Document schemaJson;
+	if (!rapidjsonHelper::parseFromStream(schemaJson, loadSchema))
+		return false;
+	const rapidjson::SchemaDocument schema(schemaJson);
+
+	// the checked-in parser is what the generator emits today
+	std::ifstream file("test_load_parser.h", std::ios::binary);
+	const std::string checkedIn((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (rapidjsonHelper::generateParser(schema, "Mobs", "testLoad") != checkedIn) {
+		std::printf("test_load_parser.h is stale\n");
+		return false;
+	}
+
+	std::ifstream data("test_load.json", std::ios::binary);
+	const std::string json((std::istreambuf_iterator<char>(data)), std::istreambuf_iterator<char>());
+	testLoad::Mobs mobs;
+	if (!testLoad::MobsReader::parse(json.c_str(), mobs) || mobs.size() != 2 || mobs[1].vnum != 189 || mobs[1].name != "Thicc Gnome" || mobs[1].factor != 22.22)
+		return false;
+
+	// keys out of schema order, spaced or unknown fall back from prediction to the general path
+	const char* shuffled = R"([{"count":2,"vnum":1,"name":"a"},{"vnum":3, "count" : 4,"extra":[{"vnum":0}],"name":"b","price":5}])";
+	testLoad::Mobs plain;
+	if (!testLoad::MobsReader::parse(shuffled, mobs) || !testLoad::MobsReader::parse<rapidjson::kParseNoFlags>(shuffled, plain)
+		|| mobs.size() != 2 || mobs[1].count != 4 || mobs[1].name != "b" || mobs[1].price != 5 || plain[1].price != mobs[1].price || plain[0].vnum != mobs[0].vnum)
+		return false;
+
+	// a short key near the end of an exactly sized buffer is not compared past the terminator
+	const std::string_view tail = R"([{"vnum":1,"count":2,"name":"a","p":1}])";
+	const auto buffer = std::make_unique<char[]>(tail.size() + 1);
+	std::memcpy(buffer.get(), tail.data(), tail.size());
+	if (!testLoad::MobsReader::parse(buffer.get(), mobs) || mobs.size() != 1 || mobs[0].name != "a")
+		return false;
+
+	// a row without "name", with a fractional count or below the "minimum" of vnum is rejected
+	if (testLoad::MobsReader::parse(R"([{"vnum":1,"count":2}])", mobs) || testLoad::MobsReader::parse(R"([{"vnum":1,"count":2.5,"name":""}])", mobs)
+		|| testLoad::MobsReader::parse(R"([{"vnum":-1,"count":2,"name":""}])", mobs))
+		return false;
+
+	// the checked keywords are emitted, any other one fails the generation
+	auto generate = [](const char* json) {
+		rapidjson::Document document;
+		document.Parse(json);
+		return rapidjsonHelper::generateParser(rapidjson::SchemaDocument(document), "Row", "gen");
+	};
+	const std::string checked = generate(R"({"type":"object","properties":{"kind":{"type":"string","enum":["mob","npc"],"maxLength":3},
+		"level":{"type":"integer","minimum":1,"maximum":100,"exclusiveMaximum":true,"multipleOf":5},"tags":{"type":"array","minItems":1,"items":{"type":"boolean"}}}})");
+	if (checked.find(R"((n == 3 && std::memcmp(s, "npc", 3) == 0))") == std::string::npos || checked.find("!lengthWithin(s, n, 0u, 3u)") == std::string::npos
+		|| checked.find("i < 1 || i >= 100 || i % 5 != 0") == std::string::npos || checked.find("if (n < 1u)") == std::string::npos)
+		return false;
+	return generate(R"({"type":"object","properties":{"a":{"type":"string","pattern":"^a"}}})").empty()
+		&& generate(R"({"type":"array","uniqueItems":true,"items":{"type":"integer"}})").empty()
+		&& generate(R"({"type":"object","properties":{"a":{"type":"number","multipleOf":0.5}}})").empty()
+		&& generate(R"({"type":"object","properties":{"a":{"type":"object","enum":[{}]}}})").empty();
+}
+
+// zero-terminated stream that the reader's SWAR overloads do not match: digits are taken one by one
+struct BytewiseStringStream : rapidjson::StringStream {
+	using rapidjson::StringStream::StringStream;
+};
+
+void BenchmarkParseNumbers() {
+	// integer columns of different widths, parsed through Parse(const char*), Parse(const char*, size_t)
+	// and, as the baseline without digit runs, a zero-terminated stream taking digits one by one
+	std::string json = "[";
+	uint64_t x = 88172645463325252ull;
+	const int rows = 200000;
+	for (int i = 0; i < rows; ++i) {
+		x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+		json += std::to_string(i) + "," + std::to_string(x % 1000000) + "," + std::to_string(x >> (x % 40)) + ",";
+	}
+	json += "0]";
+
+	const char* modes[] = { "zero-terminated", "bounded", "zero-terminated, digit by digit" };
+	double ms[3];
+	for (int mode = 0; mode < 3; ++mode) {
+		auto best = std::chrono::steady_clock::duration::max();
+		for (int run = 0; run < 5; ++run) {
+			rapidjson::Document jsonDoc;
+			BytewiseStringStream bytewise(json.c_str());
+			auto start = std::chrono::steady_clock::now();
+			if (mode == 0)
+				jsonDoc.Parse(json.c_str());
+			else if (mode == 1)
+				jsonDoc.Parse(json.c_str(), json.size());
+			else
+				jsonDoc.ParseStream(bytewise);
+			best = std::min(best, std::chrono::steady_clock::now() - start);
+			if (jsonDoc.HasParseError() || jsonDoc.Size() != static_cast<rapidjson::SizeType>(rows * 3 + 1))
+				std::printf("BenchmarkParseNumbers: %s parse FAILED\n", modes[mode]);
+		}
+		ms[mode] = std::chrono::duration<double, std::milli>(best).count();
+		std::printf("parse %d numbers (%s): %.2f ms\n", rows * 3 + 1, modes[mode], ms[mode]);
+	}
+	std::printf("8-digit runs: Parse(const char*) %.2fx, Parse(const char*, size_t) %.2fx faster than digit by digit\n", ms[2] / ms[0], ms[2] / ms[1]);
+}
+
+void BenchmarkParseDoubles() {
+	// doubles printed with 17 significant digits and short random decimals, parsed with and without
+	// kParseFullPrecisionFlag against strtod on each literal
+	std::vector<std::string> literals;
+	uint64_t x = 0x2545F4914F6CDD1Dull;
+	const int count = 200000;
+	for (int i = 0; i < count; ++i) {
+		x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+		char buffer[32];
+		if (i % 2)
+			std::snprintf(buffer, sizeof(buffer), "%.17g", static_cast<double>(x >> 11) * std::pow(10.0, static_cast<double>(x % 40) - 30));
+		else
+			std::snprintf(buffer, sizeof(buffer), "%u.%02u", static_cast<unsigned>(x % 100000), static_cast<unsigned>(x >> 40) % 100);
+		literals.push_back(buffer);
+	}
+	std::string json = "[";
+	for (const auto& literal : literals)
+		json += literal + ",";
+	json.back() = ']';
+
+	auto time = [](auto&& run) {
+		auto best = std::chrono::steady_clock::duration::max();
+		for (int repeat = 0; repeat < 5; ++repeat) {
+			auto start = std::chrono::steady_clock::now();
+			run();
+			best = std::min(best, std::chrono::steady_clock::now() - start);
+		}
+		return std::chrono::duration<double, std::milli>(best).count();
+	};
+	std::vector<double> expected(literals.size());
+	const double strtodMs = time([&] { for (size_t i = 0; i < literals.size(); ++i) expected[i] = std::strtod(literals[i].c_str(), nullptr); });
+	rapidjson::Document normal, full;
+	const double normalMs = time([&] { normal.Parse(json.c_str()); });
+	const double fullMs = time([&] { full.Parse<rapidjson::kParseFullPrecisionFlag>(json.c_str()); });
+	int normalOff = 0, fullOff = 0;
+	for (rapidjson::SizeType i = 0; i < full.Size(); ++i) {
+		normalOff += normal[i].GetDouble() != expected[i];
+		fullOff += full[i].GetDouble() != expected[i];
+	}
+	std::printf("parse %d doubles: strtod %.2f ms, Parse %.2f ms (%d differ), Parse full precision %.2f ms (%d differ)\n",
+		count, strtodMs, normalMs, normalOff, fullMs, fullOff);
+}
+
+void BenchmarkSimdKernels() {
+	// indented rows with long strings: whitespace skipping and string scanning dominate
+	std::string json = "[\n";
+	for (int i = 0; i < 100000; i++) {
+		json += i ? ",\n" : "";
+		json += "        {\n            \"name\": \"" + std::string(40 + i % 60, 'n') + "\",\n            \"text\": \"" + std::string(100 + i % 200, 't') + "\"\n        }";
+	}
+	json += "\n]";
+
+	const auto active = rapidjson::GetSimdKernel();
+	for (int kernel = rapidjson::kSimdKernelScalar; kernel < rapidjson::kSimdKernelCount; ++kernel) {
+		if (!rapidjson::SetSimdKernel(static_cast<rapidjson::SimdKernel>(kernel)))
+			continue;
+		auto zeroBest = std::chrono::steady_clock::duration::max(), boundedBest = zeroBest, writeBest = zeroBest;
+		for (int run = 0; run < 5; ++run) {
+			rapidjson::Document jsonDoc;
+			auto start = std::chrono::steady_clock::now();
+			jsonDoc.Parse(json.c_str());
+			zeroBest = std::min(zeroBest, std::chrono::steady_clock::now() - start);
+
+			start = std::chrono::steady_clock::now();
+			jsonDoc.Parse(json.c_str(), json.size());
+			boundedBest = std::min(boundedBest, std::chrono::steady_clock::now() - start);
+
+			start = std::chrono::steady_clock::now();
+			rapidjson::StringBuffer buffer;
+			rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+			jsonDoc.Accept(writer);
+			writeBest = std::min(writeBest, std::chrono::steady_clock::now() - start);
+		}
+		const double megabytes = json.size() / 1e6;
+		std::printf("simd kernel %s on %.1f MB: parse %.0f MB/s, bounded parse %.0f MB/s, write %.0f MB/s\n",
+			rapidjson::GetSimdKernelName(static_cast<rapidjson::SimdKernel>(kernel)), megabytes,
+			megabytes / std::chrono::duration<double>(zeroBest).count(), megabytes / std::chrono::duration<double>(boundedBest).count(),
+			megabytes / std::chrono::duration<double>(writeBest).count());
+	}
+	rapidjson::SetSimdKernel(active);
+}
+
+void BenchmarkGeneratedParser() {
+	// 200k rows loaded into structs: validated DOM plus extraction against the generated handler
+	std::string json = "[";
+	for (int i = 0; i < 200000; i++) {
+		json += i ? "," : "";
+		json += "{\"vnum\":" + std::to_string(i * 10) + ",\"count\":" + std::to_string(i % 200) + ",\"price\":" + std::to_string(i * 3)
+			+ ",\"name\":\"item" + std::to_string(i % 7) + "\",\"factor\":1.5}";
+	}
+	json += "]";
+
+	rapidjson::Document schemaJson;
+	if (!rapidjsonHelper::parseFromStream(schemaJson, loadSchema))
+		return;
+	const rapidjson::SchemaDocument schema(schemaJson);
+
+	auto domBest = std::chrono::steady_clock::duration::max(), generatedBest = domBest, predictedBest = domBest, copyBest = domBest;
+	size_t domRows = 0, generatedRows = 0, predictedRows = 0;
+	std::vector<char> copy(json.size() + 1);
+	for (int run = 0; run < 3; ++run) {
+		auto start = std::chrono::steady_clock::now();
+		rapidjson::Document jsonDoc;
+		testLoad::Mobs extracted;
+		if (rapidjsonHelper::parseFromStream(jsonDoc, json, schema)) {
+			extracted.reserve(jsonDoc.Size());
+			for (auto& row : jsonDoc.GetArray())
+				extracted.push_back({row["vnum"].GetInt64(), row["count"].GetInt64(), row["price"].GetInt64(), row["name"].GetString(), row["factor"].GetDouble()});
+		}
+		domRows = extracted.size();
+		domBest = std::min(domBest, std::chrono::steady_clock::now() - start);
+
+		start = std::chrono::steady_clock::now();
+		testLoad::Mobs mobs;
+		if (testLoad::MobsReader::parse<rapidjson::kParseNoFlags>(json.c_str(), mobs))
+			generatedRows = mobs.size();
+		generatedBest = std::min(generatedBest, std::chrono::steady_clock::now() - start);
+
+		// keys matched in schema order (kParsePredictKeysFlag)
+		start = std::chrono::steady_clock::now();
+		testLoad::Mobs predicted;
+		if (testLoad::MobsReader::parse(json.c_str(), predicted))
+			predictedRows = predicted.size();
+		predictedBest = std::min(predictedBest, std::chrono::steady_clock::now() - start);
+
+		start = std::chrono::steady_clock::now();
+		std::memcpy(copy.data(), json.c_str(), json.size() + 1);
+		copyBest = std::min(copyBest, std::chrono::steady_clock::now() - start);
+	}
+	std::printf("load %zu rows into structs: DOM + validator %.2f ms, generated parser %.2f ms, with key prediction %.2f ms (memcpy %.2f ms)%s\n", domRows,
+		std::chrono::duration<double, std::milli>(domBest).count(), std::chrono::duration<double, std::milli>(generatedBest).count(),
+		std::chrono::duration<double, std::milli>(predictedBest).count(), std::chrono::duration<double, std::milli>(copyBest).count(),
+		domRows == generatedRows && domRows == predictedRows && copy[json.size() / 2] == json[json.size() / 2] ? "" : " (MISMATCH)");
+}
+
+void BenchmarkHugePages() {
+	// the same 300k rows parsed, walked in order and looked up in random order, with the default pool and
+	// with huge-page chunks; best of 5 interleaved runs
+	std::string json = "[";
+	const int rows = 300000;
+	for (int i = 0; i < rows; i++) {
+		json += i ? "," : "";
+		json += "{\"vnum\":" + std::to_string(i) + ",\"count\":" + std::to_string(i % 200) + ",\"name\":\"item" + std::to_string(i % 7) + "\",\"factor\":1.5}";
+	}
+	json += "]";
+	std::vector<rapidjson::SizeType> order(rows);
+	uint64_t x = 88172645463325252ull;
+	for (int i = 0; i < rows; i++) {
+		x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+		order[i] = static_cast<rapidjson::SizeType>(i);
+		std::swap(order[i], order[x % (i + 1)]);
+	}
+
+	double ms[2][3] = { { 1e9, 1e9, 1e9 }, { 1e9, 1e9, 1e9 } };
+	int64_t sums[2] = {};
+	auto measure = [&](auto jsonDoc, double* best, int64_t& sum) {
+		auto start = std::chrono::steady_clock::now();
+		jsonDoc.Parse(json.c_str(), json.size());
+		auto parsed = std::chrono::steady_clock::now();
+		sum = 0;
+		for (int pass = 0; pass < 3; pass++)
+			for (auto& row : jsonDoc.GetArray())
+				sum += row["vnum"].GetInt64() + row["count"].GetInt64();
+		auto walked = std::chrono::steady_clock::now();
+		for (const rapidjson::SizeType i : order)
+			sum += jsonDoc[i]["vnum"].GetInt64() + jsonDoc[i]["count"].GetInt64();
+		auto end = std::chrono::steady_clock::now();
+		best[0] = std::min(best[0], std::chrono::duration<double, std::milli>(parsed - start).count());
+		best[1] = std::min(best[1], std::chrono::duration<double, std::milli>(walked - parsed).count());
+		best[2] = std::min(best[2], std::chrono::duration<double, std::milli>(end - walked).count());
+	};
+	for (int run = 0; run < 5; run++) {
+		measure(rapidjson::Document(), ms[0], sums[0]);
+		measure(rapidjsonHelper::HugePageDocument(), ms[1], sums[1]);
+	}
+	std::printf("huge pages, %zu bytes: parse %.2f ms -> %.2f ms, in-order walk %.2f ms -> %.2f ms, random lookups %.2f ms -> %.2f ms (%.2fx)%s\n",
+		json.size(), ms[0][0], ms[1][0], ms[0][1], ms[1][1], ms[0][2], ms[1][2], ms[0][2] / ms[1][2], sums[0] == sums[1] ? "" : " (MISMATCH)");
+}
+
 int main()
 {
-	TestLoadData();
-	TestSaveData();
-	return 0;
+	int failures = 0;
+	auto check = [&failures](bool passed, const char* name) {
+		if (!passed) {
+			std::printf("%s FAILED\n", name);
+			failures++;
+		}
+	};
+	check(TestLoadData(), "TestLoadData");
+	check(TestSaveData(), "TestSaveData");
+	check(TestMemoryReport(), "TestMemoryReport");
+	check(TestCompact(), "TestCompact");
+	check(TestHugePageLoad(), "TestHugePageLoad");
+	check(TestSimdKernels(), "TestSimdKernels");
+	check(TestSimdEdges(), "TestSimdEdges");
+	check(TestShortestDouble(), "TestShortestDouble");
+	check(TestFixedDecimals(), "TestFixedDecimals");
+	check(TestFullPrecisionParse(), "TestFullPrecisionParse");
+	check(TestMemberIndex(), "TestMemberIndex");
+	check(TestInternKeys(), "TestInternKeys");
+	check(TestColumns(), "TestColumns");
+	check(TestPackedArrays(), "TestPackedArrays");
+	check(TestSchemaLoad(), "TestSchemaLoad");
+	check(TestSchemaDispatch(), "TestSchemaDispatch");
+	check(TestSchemaPatterns(), "TestSchemaPatterns");
+	check(TestValidatorPool(), "TestValidatorPool");
+	check(TestHashValue(), "TestHashValue");
+	check(TestMerkleHash(), "TestMerkleHash");
+	check(TestDiff(), "TestDiff");
+	check(TestPatch(), "TestPatch");
+	check(TestGeneratedParser(), "TestGeneratedParser");
+	BenchmarkSimdKernels();
+	BenchmarkParseNumbers();
+	BenchmarkParseDoubles();
+	BenchmarkMemberCache();
+	BenchmarkGeneratedParser();
+	BenchmarkHugePages();
+	return failures ? 1 : 0;
 }
@@ -0,0 +1,257 @@
+// Generated by rapidjsonHelper::generateParser() from a JSON schema, do not edit.
+#pragma once
+
+#include <rapidjson/reader.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace testLoad {
+	struct MobsItem {
+		int64_t vnum = 0;
+		int64_t count = 0;
+		int64_t price = 0;
+		std::string name;
+		double factor = 0;
+	};
+
+	using Mobs = std::vector<MobsItem>;
+
+	// SAX handler parsing straight into Mobs. A value of another type or outside of its "enum",
+	// "minimum", "maximum", "multipleOf", length or item count limits, a missing required property or an
+	// unknown property of a closed object stops the parse.
+	class MobsReader : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, MobsReader> {
+	public:
+		explicit MobsReader(Mobs& root) {
+			stack_.reserve(16);
+			stack_.push_back({kArray, kRoot, 0, 0, &root});
+		}
+
+		// parses the zero-terminated json into root; properties missing from json keep their values
+		template<unsigned parseFlags = rapidjson::kParsePredictKeysFlag>
+		static bool parse(const char* json, Mobs& root) {
+			MobsReader handler(root);
+			rapidjson::Reader reader;
+			rapidjson::StringStream stream(json);
+			return !reader.Parse<parseFlags>(stream, handler).IsError();
+		}
+
+		bool Null() {
+			if (skip_)
+				return true;
+			switch (stack_.back().slot) {
+			case kIgnored:
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		bool Bool(bool) {
+			if (skip_)
+				return true;
+			switch (stack_.back().slot) {
+			case kIgnored:
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		bool Int(int i) { return Int64(i); }
+		bool Uint(unsigned u) { return Int64(u); }
+		bool Uint64(uint64_t u) { return u <= static_cast<uint64_t>(INT64_MAX) ? Int64(static_cast<int64_t>(u)) : Double(static_cast<double>(u)); }
+
+		bool Int64(int64_t i) {
+			if (skip_)
+				return true;
+			Frame& frame = stack_.back();
+			switch (frame.slot) {
+			case kIgnored:
+				return true;
+			case kMobsItem_vnum:
+				if (i < 0)
+					return false;
+				static_cast<MobsItem*>(frame.target)->vnum = i;
+				return true;
+			case kMobsItem_count:
+				static_cast<MobsItem*>(frame.target)->count = i;
+				return true;
+			case kMobsItem_price:
+				static_cast<MobsItem*>(frame.target)->price = i;
+				return true;
+			case kMobsItem_factor:
+				static_cast<MobsItem*>(frame.target)->factor = static_cast<double>(i);
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		bool Double(double d) {
+			if (skip_)
+				return true;
+			Frame& frame = stack_.back();
+			switch (frame.slot) {
+			case kIgnored:
+				return true;
+			case kMobsItem_factor:
+				static_cast<MobsItem*>(frame.target)->factor = d;
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		bool String(const char* s, rapidjson::SizeType n, bool) {
+			if (skip_)
+				return true;
+			Frame& frame = stack_.back();
+			switch (frame.slot) {
+			case kIgnored:
+				return true;
+			case kMobsItem_name:
+				static_cast<MobsItem*>(frame.target)->name.assign(s, n);
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		bool Key(const char* s, rapidjson::SizeType n, bool) {
+			if (skip_)
+				return true;
+			Frame& frame = stack_.back();
+			switch (frame.type) {
+			case kMobsItemObject: {
+				const int field = fieldOfMobsItem(s, n);
+				if (field < 0) {
+					frame.slot = kIgnored;
+					return true;
+				}
+				frame.slot = static_cast<Slot>(kMobsItem_vnum + field);
+				frame.seen |= uint64_t(1) << field;
+				frame.next = static_cast<uint16_t>(field + 1);
+				return true;
+			}
+			default:
+				return false;
+			}
+		}
+
+		const char* PredictKey(rapidjson::SizeType& length) const {
+			if (skip_)
+				return nullptr;
+			const Frame& frame = stack_.back();
+			switch (frame.type) {
+			case kMobsItemObject: {
+				static const char* const keys[] = { "\"vnum\":", "\"count\":", "\"price\":", "\"name\":", "\"factor\":", nullptr };
+				static const rapidjson::SizeType lengths[] = { 7, 8, 8, 7, 9, 0 };
+				length = lengths[frame.next];
+				return keys[frame.next];
+			}
+			default:
+				return nullptr;
+			}
+		}
+
+		bool PredictedKey() {
+			Frame& frame = stack_.back();
+			switch (frame.type) {
+			case kMobsItemObject:
+				frame.slot = static_cast<Slot>(kMobsItem_vnum + frame.next);
+				break;
+			default:
+				return false;
+			}
+			frame.seen |= uint64_t(1) << frame.next++;
+			return true;
+		}
+
+		bool StartObject() {
+			Frame& frame = stack_.back();
+			if (skip_ || frame.slot == kIgnored) {
+				skip_++;
+				return true;
+			}
+			switch (frame.slot) {
+			case kMobsItem:
+				return enter(kMobsItemObject, kIgnored, &static_cast<std::vector<MobsItem>*>(frame.target)->emplace_back());
+			default:
+				return false;
+			}
+		}
+
+		bool StartArray() {
+			Frame& frame = stack_.back();
+			if (skip_ || frame.slot == kIgnored) {
+				skip_++;
+				return true;
+			}
+			switch (frame.slot) {
+			case kRoot:
+				return enter(kArray, kMobsItem, &(*static_cast<std::vector<MobsItem>*>(frame.target) = {}));
+			default:
+				return false;
+			}
+		}
+
+		bool EndObject(rapidjson::SizeType) {
+			if (skip_) {
+				skip_--;
+				return true;
+			}
+			static const uint64_t required[] = { 0xb };
+			const Frame& frame = stack_.back();
+			if ((frame.seen & required[frame.type]) != required[frame.type])
+				return false;
+			stack_.pop_back();
+			return true;
+		}
+
+		bool EndArray(rapidjson::SizeType) {
+			if (skip_)
+				skip_--;
+			else
+				stack_.pop_back();
+			return true;
+		}
+
+	private:
+		enum Type : uint16_t { kMobsItemObject, kArray };
+		enum Slot : uint16_t {
+			kRoot, kMobsItem_vnum, kMobsItem_count, kMobsItem_price,
+			kMobsItem_name, kMobsItem_factor, kMobsItem,
+			kIgnored
+		};
+		struct Frame {
+			Type type;
+			Slot slot;  // of the value to come
+			uint16_t next;  // property predicted next
+			uint64_t seen;  // properties present
+			void* target;
+		};
+
+		bool enter(Type type, Slot slot, void* target) {
+			stack_.push_back({type, slot, 0, 0, target});
+			return true;
+		}
+
+		// property index of MobsItem: a seeded FNV-1a picks the only candidate, memcmp confirms it
+		static int fieldOfMobsItem(const char* s, rapidjson::SizeType n) {
+			static const char* const names[] = { "vnum", "count", "price", "name", "factor" };
+			static const rapidjson::SizeType lengths[] = { 4, 5, 5, 4, 6 };
+			static const int8_t table[8] = { -1, 4, -1, -1, 0, 1, 2, 3 };
+			uint32_t h = 2166136261u;
+			for (rapidjson::SizeType i = 0; i < n; i++)
+				h = (h ^ static_cast<unsigned char>(s[i])) * 16777619u;
+			const int field = table[(h ^ h >> 16) & 7];
+			return field >= 0 && lengths[field] == n && std::memcmp(names[field], s, n) == 0 ? field : -1;
+		}
+
+		std::vector<Frame> stack_;  // the bottom frame holds the root
+		unsigned skip_ = 0;         // depth inside an ignored value
+	};
+}